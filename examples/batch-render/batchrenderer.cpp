@@ -0,0 +1,377 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include "core/g3d_scene.h"
+#include "core/g3d_camera.h"
+#include "core/g3d_offscreenrenderer.h"
+
+#include "batchrenderer.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QThread>
+#include <QRunnable>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QStringList>
+
+#include <algorithm>
+#include <math.h>
+
+namespace {
+    /** Writes a single image as PNG. */
+    class EncodeJob : public QRunnable {
+    public:
+        EncodeJob(BatchRenderer *batchRenderer, QImage image, QString fileName) {
+            _batchRenderer = batchRenderer;
+            _image = image;
+            _fileName = fileName;
+        }
+
+        void run() {
+            _batchRenderer->imageWritten(_image.save(_fileName, "PNG"));
+        }
+
+    private:
+        BatchRenderer *_batchRenderer;
+        QImage _image;
+        QString _fileName;
+    };
+
+    /** Renders poses on its own thread until none are left. */
+    class RenderWorker : public QThread {
+    public:
+        RenderWorker(BatchRenderer *batchRenderer,
+                     Glee3D::Scene *scene,
+                     Glee3D::OffscreenRenderer *renderer) {
+            _batchRenderer = batchRenderer;
+            _scene = scene;
+            _renderer = renderer;
+            _ownerThread = QThread::currentThread();
+        }
+
+        void run() {
+            if(!_renderer->makeCurrent()) {
+                return;
+            }
+
+            // The first frame compiles all meshes, which is not what we
+            // want to measure.
+            Glee3D::Camera camera;
+            _renderer->render(_scene, &camera);
+
+            int index;
+            while((index = _batchRenderer->nextPose()) >= 0) {
+                CameraPose pose = _batchRenderer->pose(index);
+                camera.setPosition(pose._position);
+                camera.setLookAt(pose._lookAt);
+                if(pose._fieldOfView > 0.0) {
+                    camera.setFieldOfView(pose._fieldOfView);
+                }
+
+                QElapsedTimer timer;
+                timer.start();
+                _renderer->render(_scene, &camera);
+                QImage image = _renderer->image();
+                _batchRenderer->frameFinished(index, image, timer.nsecsElapsed());
+            }
+
+            // Compiled meshes have to be released with the context current.
+            qDeleteAll(_scene->entities());
+            _renderer->doneCurrent();
+            _renderer->moveToThread(_ownerThread);
+        }
+
+    private:
+        BatchRenderer *_batchRenderer;
+        Glee3D::Scene *_scene;
+        Glee3D::OffscreenRenderer *_renderer;
+        QThread *_ownerThread;
+    };
+}
+
+BatchRenderer::BatchRenderer()
+    : Glee3D::Logging("BatchRenderer") {
+    _outputDirectory = ".";
+    _width = 512;
+    _height = 512;
+    _threadCount = QThread::idealThreadCount();
+    _wallTime = 0;
+    setEncoderCount(QThread::idealThreadCount());
+}
+
+BatchRenderer::~BatchRenderer() {
+    _encoderPool.waitForDone();
+}
+
+bool BatchRenderer::loadScene(QString fileName) {
+    QFile file(fileName);
+    if(!file.open(QFile::ReadOnly)) {
+        error(QString("Cannot open scene %1.").arg(fileName));
+        return false;
+    }
+
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if(!document.isObject()) {
+        error(QString("Cannot parse scene %1: %2").arg(fileName).arg(parseError.errorString()));
+        return false;
+    }
+
+    // Make sure the scene can be read before starting any threads.
+    Glee3D::Scene scene;
+    if(!scene.deserialize(document.object())) {
+        error(QString("Cannot deserialize scene %1.").arg(fileName));
+        return false;
+    }
+    qDeleteAll(scene.entities());
+    qDeleteAll(scene.lightSources());
+
+    _scene = document.object();
+    return true;
+}
+
+bool BatchRenderer::loadPoses(QString fileName) {
+    QFile file(fileName);
+    if(!file.open(QFile::ReadOnly)) {
+        error(QString("Cannot open poses %1.").arg(fileName));
+        return false;
+    }
+
+    _poses.clear();
+    QByteArray data = file.readAll();
+    bool success;
+    if(QFileInfo(fileName).suffix().toLower() == "json") {
+        success = loadJsonPoses(data);
+    } else {
+        success = loadCsvPoses(data);
+    }
+
+    if(success && _poses.isEmpty()) {
+        error(QString("No poses found in %1.").arg(fileName));
+        return false;
+    }
+    return success;
+}
+
+bool BatchRenderer::loadJsonPoses(QByteArray data) {
+    QJsonParseError parseError;
+    QJsonDocument document = QJsonDocument::fromJson(data, &parseError);
+    if(!document.isArray()) {
+        error(QString("Poses have to be a JSON array: %1").arg(parseError.errorString()));
+        return false;
+    }
+
+    QJsonArray poses = document.array();
+    for(int i = 0; i < poses.size(); i++) {
+        QJsonObject poseObject = poses[i].toObject();
+        QJsonArray position = poseObject["position"].toArray();
+        QJsonArray lookAt = poseObject["lookAt"].toArray();
+        if(position.size() != 3 || lookAt.size() != 3) {
+            error(QString("Pose %1 needs a position and a lookAt with three values each.").arg(i));
+            return false;
+        }
+
+        CameraPose pose;
+        pose._position = Glee3D::Vector3D(position[0].toDouble(), position[1].toDouble(), position[2].toDouble());
+        pose._lookAt = Glee3D::Vector3D(lookAt[0].toDouble(), lookAt[1].toDouble(), lookAt[2].toDouble());
+        pose._fieldOfView = poseObject["fieldOfView"].toDouble();
+        _poses.append(pose);
+    }
+    return true;
+}
+
+bool BatchRenderer::loadCsvPoses(QByteArray data) {
+    QStringList lines = QString(data).split('\n');
+    for(int i = 0; i < lines.size(); i++) {
+        QString line = lines[i].trimmed();
+        if(line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+
+        QStringList columns = line.split(',');
+        if(columns.size() < 6) {
+            error(QString("Line %1 needs at least six columns.").arg(i + 1));
+            return false;
+        }
+
+        double values[7] = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+        int valueCount = qMin(columns.size(), 7);
+        for(int c = 0; c < valueCount; c++) {
+            bool ok;
+            values[c] = columns[c].trimmed().toDouble(&ok);
+            if(!ok) {
+                error(QString("Line %1 contains an invalid number.").arg(i + 1));
+                return false;
+            }
+        }
+
+        CameraPose pose;
+        pose._position = Glee3D::Vector3D(values[0], values[1], values[2]);
+        pose._lookAt = Glee3D::Vector3D(values[3], values[4], values[5]);
+        pose._fieldOfView = values[6];
+        _poses.append(pose);
+    }
+    return true;
+}
+
+void BatchRenderer::setOutputDirectory(QString outputDirectory) {
+    _outputDirectory = outputDirectory;
+}
+
+void BatchRenderer::setImageSize(int width, int height) {
+    _width = width;
+    _height = height;
+}
+
+void BatchRenderer::setThreadCount(int threadCount) {
+    _threadCount = qMax(1, threadCount);
+}
+
+void BatchRenderer::setEncoderCount(int encoderCount) {
+    encoderCount = qMax(1, encoderCount);
+    _encoderPool.setMaxThreadCount(encoderCount);
+
+    // Keep memory bounded if encoding cannot keep up with rendering.
+    _encoderSlots.acquire(_encoderSlots.available());
+    _encoderSlots.release(encoderCount * 2);
+}
+
+bool BatchRenderer::run() {
+    if(!QDir().mkpath(_outputDirectory)) {
+        error(QString("Cannot create output directory %1.").arg(_outputDirectory));
+        return false;
+    }
+
+    _nextPose.store(0);
+    _failedImages.store(0);
+    _frameTimes.clear();
+
+    // Surfaces have to be created on this thread, the contexts are handed
+    // over to the workers afterwards.
+    int threadCount = qMin(_threadCount, _poses.size());
+    QList<Glee3D::Scene*> scenes;
+    QList<Glee3D::OffscreenRenderer*> renderers;
+    QList<RenderWorker*> workers;
+    bool success = true;
+    for(int i = 0; i < threadCount && success; i++) {
+        Glee3D::Scene *scene = new Glee3D::Scene();
+        scene->deserialize(_scene);
+        scenes.append(scene);
+
+        Glee3D::OffscreenRenderer *renderer = new Glee3D::OffscreenRenderer(_width, _height);
+        renderers.append(renderer);
+        if(!renderer->initialize()) {
+            success = false;
+            break;
+        }
+        renderer->doneCurrent();
+
+        RenderWorker *worker = new RenderWorker(this, scene, renderer);
+        renderer->moveToThread(worker);
+        workers.append(worker);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    if(success) {
+        foreach(RenderWorker *worker, workers) {
+            worker->start();
+        }
+        foreach(RenderWorker *worker, workers) {
+            worker->wait();
+        }
+        _encoderPool.waitForDone();
+    }
+    _wallTime = timer.nsecsElapsed();
+
+    qDeleteAll(workers);
+    qDeleteAll(renderers);
+    foreach(Glee3D::Scene *scene, scenes) {
+        qDeleteAll(scene->lightSources());
+    }
+    qDeleteAll(scenes);
+
+    if(!success) {
+        error("Failed creating offscreen renderers.");
+        return false;
+    }
+
+    if(_failedImages.load() > 0) {
+        error(QString("Failed writing %1 images.").arg(_failedImages.load()));
+        return false;
+    }
+    return true;
+}
+
+int BatchRenderer::nextPose() {
+    int index = _nextPose.fetchAndAddOrdered(1);
+    return index < _poses.size() ? index : -1;
+}
+
+CameraPose BatchRenderer::pose(int index) {
+    return _poses[index];
+}
+
+void BatchRenderer::frameFinished(int index, QImage image, qint64 nanoseconds) {
+    _mutex.lock();
+    _frameTimes.append(nanoseconds);
+    _mutex.unlock();
+
+    QString fileName = QDir(_outputDirectory).filePath(
+        QString("frame-%1.png").arg(index, 5, 10, QChar('0')));
+    _encoderSlots.acquire();
+    _encoderPool.start(new EncodeJob(this, image, fileName));
+}
+
+void BatchRenderer::imageWritten(bool success) {
+    if(!success) {
+        _failedImages.fetchAndAddOrdered(1);
+    }
+    _encoderSlots.release();
+}
+
+double BatchRenderer::percentile(QVector<qint64> sortedFrameTimes, double fraction) {
+    if(sortedFrameTimes.isEmpty()) {
+        return 0.0;
+    }
+
+    // Nearest rank.
+    int rank = (int)ceil(fraction * sortedFrameTimes.size()) - 1;
+    rank = qBound(0, rank, sortedFrameTimes.size() - 1);
+    return sortedFrameTimes[rank] / 1000000.0;
+}
+
+void BatchRenderer::printReport() {
+    QVector<qint64> frameTimes = _frameTimes;
+    std::sort(frameTimes.begin(), frameTimes.end());
+
+    double seconds = _wallTime / 1000000000.0;
+    QTextStream out(stdout);
+    out << "Frames:      " << frameTimes.size() << "\n";
+    out << "Wall time:   " << seconds << " s\n";
+    out << "Throughput:  " << (seconds > 0.0 ? frameTimes.size() / seconds : 0.0) << " fps\n";
+    out << "Frame time:  p50 " << percentile(frameTimes, 0.50) << " ms, "
+        << "p95 " << percentile(frameTimes, 0.95) << " ms, "
+        << "p99 " << percentile(frameTimes, 0.99) << " ms\n";
+}
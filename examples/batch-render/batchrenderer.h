@@ -0,0 +1,116 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef BATCHRENDERER_H
+#define BATCHRENDERER_H
+
+#include "core/g3d_logging.h"
+#include "math/g3d_vector3d.h"
+
+#include <QString>
+#include <QImage>
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QJsonObject>
+#include <QAtomicInt>
+
+/** A camera position to render the scene from. */
+struct CameraPose {
+    Glee3D::Vector3D _position;
+    Glee3D::Vector3D _lookAt;
+    /** Field of view in degrees, or 0 for the camera default. */
+    double _fieldOfView;
+};
+
+/**
+ * Renders a serialized scene from a list of camera poses into PNG files.
+ * Each render thread has its own offscreen renderer and its own copy of the
+ * scene. Finished images are handed to a separate pool of threads for PNG
+ * encoding, so that rendering does not wait for compression.
+ */
+class BatchRenderer : public Glee3D::Logging {
+public:
+    BatchRenderer();
+    ~BatchRenderer();
+
+    /** Loads the scene to render from a JSON file. */
+    bool loadScene(QString fileName);
+
+    /**
+     * Loads the camera poses from a file. JSON files contain an array of
+     * objects with "position" and "lookAt" arrays and an optional
+     * "fieldOfView". Any other file is read as CSV with the columns
+     * px, py, pz, lx, ly, lz and an optional field of view. Lines starting
+     * with # are ignored.
+     */
+    bool loadPoses(QString fileName);
+
+    void setOutputDirectory(QString outputDirectory);
+    void setImageSize(int width, int height);
+    void setThreadCount(int threadCount);
+    void setEncoderCount(int encoderCount);
+
+    /** Renders all poses and blocks until all images have been written. */
+    bool run();
+
+    /** Prints throughput and frame time percentiles of the last run. */
+    void printReport();
+
+    /** @returns the index of the next pose to render, or -1 if none is left. */
+    int nextPose();
+
+    /** @returns the pose with the given index. */
+    CameraPose pose(int index);
+
+    /**
+     * Records a rendered frame and queues its image for encoding. Blocks
+     * while too many images are waiting for encoding.
+     */
+    void frameFinished(int index, QImage image, qint64 nanoseconds);
+
+    /** Called by the encoders when an image has been written. */
+    void imageWritten(bool success);
+
+private:
+    bool loadJsonPoses(QByteArray data);
+    bool loadCsvPoses(QByteArray data);
+    double percentile(QVector<qint64> sortedFrameTimes, double fraction);
+
+    QJsonObject _scene;
+    QList<CameraPose> _poses;
+    QString _outputDirectory;
+    int _width;
+    int _height;
+    int _threadCount;
+
+    QAtomicInt _nextPose;
+    QAtomicInt _failedImages;
+    QThreadPool _encoderPool;
+    QSemaphore _encoderSlots;
+
+    QMutex _mutex;
+    QVector<qint64> _frameTimes;
+    qint64 _wallTime;
+};
+
+#endif // BATCHRENDERER_H
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QStringList>
+#include <QThread>
+
+#include "batchrenderer.h"
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication a(argc, argv);
+    Q_INIT_RESOURCE(g3d);
+
+    a.setApplicationName("Glee3D Batch Render");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Renders a serialized scene from a list of camera poses into PNG files.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("scene", "Serialized scene in JSON format.");
+    parser.addPositionalArgument("poses", "Camera poses as a JSON array or as CSV.");
+
+    QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory.", "directory", ".");
+    QCommandLineOption widthOption("width", "Image width.", "pixels", "512");
+    QCommandLineOption heightOption("height", "Image height.", "pixels", "512");
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads", "Number of render threads.",
+                                     "count", QString::number(QThread::idealThreadCount()));
+    QCommandLineOption encodersOption(QStringList() << "e" << "encoders", "Number of PNG encoding threads.",
+                                      "count", QString::number(QThread::idealThreadCount()));
+    parser.addOption(outputOption);
+    parser.addOption(widthOption);
+    parser.addOption(heightOption);
+    parser.addOption(threadsOption);
+    parser.addOption(encodersOption);
+    parser.process(a);
+
+    QStringList arguments = parser.positionalArguments();
+    if(arguments.size() != 2) {
+        parser.showHelp(1);
+    }
+
+    BatchRenderer batchRenderer;
+    batchRenderer.setOutputDirectory(parser.value(outputOption));
+    batchRenderer.setImageSize(parser.value(widthOption).toInt(), parser.value(heightOption).toInt());
+    batchRenderer.setThreadCount(parser.value(threadsOption).toInt());
+    batchRenderer.setEncoderCount(parser.value(encodersOption).toInt());
+
+    if(!batchRenderer.loadScene(arguments[0])
+    || !batchRenderer.loadPoses(arguments[1])) {
+        return 1;
+    }
+
+    bool success = batchRenderer.run();
+    batchRenderer.printReport();
+    return success ? 0 : 1;
+}
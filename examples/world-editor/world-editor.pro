@@ -17,7 +17,7 @@ TEMPLATE = app
 TARGET = world-editor
 CONFIG += debug_and_release
 
-QT += opengl
+QT += opengl concurrent
 
 CONFIG(release, debug|release) {
     DESTDIR =       bin/release
@@ -15,4 +15,6 @@
 
 TEMPLATE = subdirs
 SUBDIRS = src \
-	  examples/world-editor
+	  examples/world-editor \
+	  examples/batch-render \
+	  tests
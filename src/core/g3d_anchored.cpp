@@ -29,19 +29,27 @@ namespace Glee3D {
         _position = Vector3D(0.0, 0.0, 0.0);
     }
 
+    Anchored::~Anchored() {
+    }
+
     Vector3D Anchored::position() {
         return _position;
     }
 
     void Anchored::setPosition(Vector3D position) {
         _position = position;
+        positionChanged();
     }
 
     void Anchored::move(Vector3D delta) {
         _position += delta;
+        positionChanged();
     }
 
     Matrix4x4 Anchored::translationMatrix() {
         return Matrix4x4().withTranslation(_position);
     }
+
+    void Anchored::positionChanged() {
+    }
 } // namespace Glee3D
@@ -44,6 +44,9 @@ namespace Glee3D {
           */
         Anchored();
 
+        /** Destructor. */
+        virtual ~Anchored();
+
         /** @returns Position of this entity in relation to its parent. */
         Vector3D position();
 
@@ -60,6 +63,9 @@ namespace Glee3D {
         Matrix4x4 translationMatrix();
 
     protected:
+        /** Called whenever the position has been changed. */
+        virtual void positionChanged();
+
         /** Position for this widget. */
         Vector3D _position;
     };
@@ -54,6 +54,10 @@ namespace Glee3D {
         _fieldOfView = fieldOfView;
     }
 
+    double Camera::fieldOfView() {
+        return _fieldOfView;
+    }
+
     void Camera::setLookAt(Vector3D target) {
         _lookAt = target;
     }
@@ -64,6 +64,9 @@ namespace Glee3D {
          */
         void setFieldOfView(double fieldOfView);
 
+        /** @returns the vertical camera field of view in degrees. */
+        double fieldOfView();
+
         /**
           * Turns the camera so it looks at the specified point defined
           * in the virtual space.
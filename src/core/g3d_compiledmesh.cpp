@@ -20,158 +20,535 @@
 
 // Own includes
 #include "g3d_compiledmesh.h"
+#include "g3d_normalbuilder.h"
+#include "g3d_meshoptimizer.h"
+#include "g3d_program.h"
+#include "g3d_meshcompiler.h"
+#include "g3d_rendercounters.h"
 
 namespace Glee3D {
-    CompiledMesh::CompiledMesh(Mesh *mesh)
+    namespace {
+        /** Number of vertices or triangles processed at once when streaming. */
+        const int streamingChunkSize = 65536;
+    }
+
+    CompiledMesh::CompiledMesh(Mesh *mesh, int properties)
+        : Logging("CompiledMesh") {
+        initialize(properties);
+        if(_properties & StreamingCompile) {
+            compileStreaming(mesh);
+        } else {
+            compile(mesh);
+            upload();
+        }
+    }
+
+    CompiledMesh::CompiledMesh(int properties)
         : Logging("CompiledMesh") {
+        initialize(properties);
+    }
+
+    void CompiledMesh::initialize(int properties) {
+        _properties = properties;
+        _compiled = false;
+        _uploaded = false;
+        _vertexCount = 0;
+        _indexCount = 0;
+        _vertices = 0;
+        _compressedVertices = 0;
+        _shortIndices = 0;
+        _intIndices = 0;
+        _indexType = GL_UNSIGNED_SHORT;
+        _vertexArrayHandle = 0;
+        _verticesVBOHandle = 0;
+        _indicesVBOHandle = 0;
+        _collisionRadius = 0.0;
+        _boundingBox = AxisAlignedBox();
+        _boundingSphere = BoundingSphere();
+        _orientedBox = OrientedBox();
+    }
+
+    void CompiledMesh::compile(Mesh *mesh) {
         if(!mesh) {
             Q_ASSERT(false);
             error("A compiled mesh cannot be created with a null mesh.");
             return;
         }
-        allocateMemory(mesh->_triangleCount);
 
-        // Determine collision radius
+        if(_compiled) {
+            warning("Mesh has already been compiled.");
+            return;
+        }
+
+        // The optimizer reorders a copy, the given mesh may be shared.
+        Mesh *optimizedMesh = 0;
+        if(_properties & OptimizeVertexOrder) {
+            optimizedMesh = optimizedCopy(mesh);
+            mesh = optimizedMesh;
+        }
+
+        allocateMemory(mesh->_vertexCount, mesh->_triangleCount);
+        measure(mesh);
+
+        // Calculate vertex joint normals for smooth shadowing
+        NormalBuilder normalBuilder(normalWeighting());
+        QVector<Vector3D> vertexJointNormal = normalBuilder.build(mesh);
+
+        for(int i = 0; i < mesh->_vertexCount; i++) {
+            if(_properties & CompressedVertices) {
+                encodeVertex(mesh, i, vertexJointNormal[i], _compressedVertices[i]);
+            } else {
+                encodeVertex(mesh, i, vertexJointNormal[i], _vertices[i]);
+            }
+        }
+
+        // Copy triangle indices, skipping triangles that point outside
+        // of the vertex array.
+        _indexCount = 0;
+        for(int i = 0; i < mesh->_triangleCount; i++) {
+            if(!isValid(mesh, i)) {
+                continue;
+            }
+
+            for(int j = 0; j < 3; j++) {
+                int index = mesh->_triangles[i]._indices[j];
+                if(_indexType == GL_UNSIGNED_SHORT) {
+                    _shortIndices[_indexCount] = (GLushort)index;
+                } else {
+                    _intIndices[_indexCount] = (GLuint)index;
+                }
+                _indexCount++;
+            }
+        }
+
+        delete optimizedMesh;
+        _compiled = true;
+    }
+
+    void CompiledMesh::compileStreaming(Mesh *mesh) {
+        if(!mesh) {
+            Q_ASSERT(false);
+            error("A compiled mesh cannot be created with a null mesh.");
+            return;
+        }
+
+        if(_compiled) {
+            warning("Mesh has already been compiled.");
+            return;
+        }
+
+        // The optimizer reorders a copy, the given mesh may be shared.
+        Mesh *optimizedMesh = 0;
+        if(_properties & OptimizeVertexOrder) {
+            optimizedMesh = optimizedCopy(mesh);
+            mesh = optimizedMesh;
+        }
+
+        _vertexCount = mesh->_vertexCount;
+        _indexType = _vertexCount <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        measure(mesh);
+
+        int validTriangleCount = 0;
+        for(int i = 0; i < mesh->_triangleCount; i++) {
+            if(isValid(mesh, i)) {
+                validTriangleCount++;
+            }
+        }
+        _indexCount = validTriangleCount * 3;
+
+        int vertexSize = (_properties & CompressedVertices) ? sizeof(CompressedVertex) : sizeof(Vertex);
+        int indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+        glGenVertexArrays(1, &_vertexArrayHandle);
+        glGenBuffers(1, &_verticesVBOHandle);
+        glGenBuffers(1, &_indicesVBOHandle);
+        glBindVertexArray(_vertexArrayHandle);
+
+        // Build normals and vertices chunk by chunk, right into the buffer.
+        glBindBuffer(GL_ARRAY_BUFFER, _verticesVBOHandle);
+        glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)vertexSize * _vertexCount, 0, GL_STATIC_DRAW);
+
+        bool success = true;
+        NormalBuilder normalBuilder(normalWeighting());
+        normalBuilder.prepareRanges(mesh, streamingChunkSize);
+        Vector3D *normals = new Vector3D[streamingChunkSize];
+        for(int first = 0; success && first < _vertexCount; first += streamingChunkSize) {
+            int count = qMin(streamingChunkSize, _vertexCount - first);
+            normalBuilder.buildRange(first / streamingChunkSize, normals);
+
+            void *mapped = glMapBufferRange(GL_ARRAY_BUFFER,
+                                            (GLintptr)vertexSize * first,
+                                            (GLsizeiptr)vertexSize * count,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if(!mapped) {
+                success = false;
+                break;
+            }
+
+            for(int i = 0; i < count; i++) {
+                if(_properties & CompressedVertices) {
+                    encodeVertex(mesh, first + i, normals[i], ((CompressedVertex*)mapped)[i]);
+                } else {
+                    encodeVertex(mesh, first + i, normals[i], ((Vertex*)mapped)[i]);
+                }
+            }
+            success = glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE;
+        }
+        delete[] normals;
+
+        if(_properties & CompressedVertices) {
+            CompressedVertex::describeLayout();
+        } else {
+            Vertex::describeLayout();
+        }
+
+        // Copy indices chunk by chunk, skipping invalid triangles.
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indicesVBOHandle);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, (GLsizeiptr)indexSize * _indexCount, 0, GL_STATIC_DRAW);
+
+        int written = 0;
+        for(int first = 0; success && first < mesh->_triangleCount; first += streamingChunkSize) {
+            int end = qMin(first + streamingChunkSize, mesh->_triangleCount);
+            int count = 0;
+            for(int i = first; i < end; i++) {
+                if(isValid(mesh, i)) {
+                    count += 3;
+                }
+            }
+
+            if(count == 0) {
+                continue;
+            }
+
+            void *mapped = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER,
+                                            (GLintptr)indexSize * written,
+                                            (GLsizeiptr)indexSize * count,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+            if(!mapped) {
+                success = false;
+                break;
+            }
+
+            int k = 0;
+            for(int i = first; i < end; i++) {
+                if(!isValid(mesh, i)) {
+                    continue;
+                }
+                for(int j = 0; j < 3; j++) {
+                    int index = mesh->_triangles[i]._indices[j];
+                    if(_indexType == GL_UNSIGNED_SHORT) {
+                        ((GLushort*)mapped)[k++] = (GLushort)index;
+                    } else {
+                        ((GLuint*)mapped)[k++] = (GLuint)index;
+                    }
+                }
+            }
+            written += count;
+            success = glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE;
+        }
+
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        delete optimizedMesh;
+
+        if(!success) {
+            error("Failed writing to mapped buffers, the mesh cannot be rendered.");
+            glDeleteVertexArrays(1, &_vertexArrayHandle);
+            glDeleteBuffers(1, &_verticesVBOHandle);
+            glDeleteBuffers(1, &_indicesVBOHandle);
+            return;
+        }
+
+        _compiled = true;
+        _uploaded = true;
+    }
+
+    Mesh *CompiledMesh::optimizedCopy(Mesh *mesh) {
+        Mesh *copy = new Mesh(mesh->_vertexCount, mesh->_triangleCount);
+        for(int i = 0; i < mesh->_vertexCount; i++) {
+            copy->_vertices[i] = mesh->_vertices[i];
+            copy->_textureCoordinates[i] = mesh->_textureCoordinates[i];
+        }
+        for(int i = 0; i < mesh->_triangleCount; i++) {
+            copy->_triangles[i] = mesh->_triangles[i];
+        }
+
+        MeshOptimizer meshOptimizer;
+        meshOptimizer.optimize(copy);
+        return copy;
+    }
+
+    void CompiledMesh::measure(Mesh *mesh) {
+        // Determine collision radius and quantization bounds
         double maxDistance = 0.0;
+        Vector3D lower, upper;
+        Vector2D texLower, texUpper;
         for(int i = 0; i < mesh->_vertexCount; i++) {
-            double length = mesh->_vertices[i].length();
+            Vector3D& position = mesh->_vertices[i];
+            Vector2D& texCoord = mesh->_textureCoordinates[i];
+            double length = position.length();
             if(length > maxDistance) {
                 maxDistance = length;
             }
+
+            if(i == 0) {
+                lower = upper = position;
+                texLower = texUpper = texCoord;
+                continue;
+            }
+            lower = Vector3D(qMin(lower.x(), position.x()), qMin(lower.y(), position.y()), qMin(lower.z(), position.z()));
+            upper = Vector3D(qMax(upper.x(), position.x()), qMax(upper.y(), position.y()), qMax(upper.z(), position.z()));
+            texLower = Vector2D(qMin(texLower.x(), texCoord.x()), qMin(texLower.y(), texCoord.y()));
+            texUpper = Vector2D(qMax(texUpper.x(), texCoord.x()), qMax(texUpper.y(), texCoord.y()));
         }
         _collisionRadius = maxDistance;
+        _positionOffset = lower;
+        _positionScale = upper - lower;
+        _texCoordOffset = texLower;
+        _texCoordScale = texUpper - texLower;
 
-        // Compute surface normals.
-        Vector3D *surfaceNormals = new Vector3D[mesh->_triangleCount];
-        for(int i = 0; i < mesh->_triangleCount; i++) {
-            int i1 = mesh->_triangles[i]._indices[0];
-            int i2 = mesh->_triangles[i]._indices[1];
-            int i3 = mesh->_triangles[i]._indices[2];
-
-            // User the cross product to determine the normal of a material.
-            surfaceNormals[i] = ((mesh->_vertices[i2] - mesh->_vertices[i1])
-                    .crossProduct(mesh->_vertices[i3] - mesh->_vertices[i1])).normalize();
+        if(mesh->_vertexCount > 0) {
+            _boundingBox = AxisAlignedBox(lower, upper);
+        } else {
+            _boundingBox = AxisAlignedBox();
         }
+        _boundingSphere = BoundingSphere::fromPoints(mesh->_vertices, mesh->_vertexCount);
+        _orientedBox = OrientedBox::fromPoints(mesh->_vertices, mesh->_vertexCount);
+    }
 
-        // Calculate vertex joint normals for smooth shadowing
-        Vector3D vertexJointNormal[mesh->_vertexCount];
-        for(int i = 0; i < mesh->_vertexCount; i++) {
-            Vector3D cumulatedJointNormal;
-            for(int j = 0; j < mesh->_triangleCount; j++) {
-                if(mesh->_triangles[j]._indices[0] == i
-                || mesh->_triangles[j]._indices[1] == i
-                || mesh->_triangles[j]._indices[2] == i) {
-                    cumulatedJointNormal += surfaceNormals[j];
-                }
+    bool CompiledMesh::isValid(Mesh *mesh, int triangle) {
+        for(int j = 0; j < 3; j++) {
+            int index = mesh->_triangles[triangle]._indices[j];
+            if(index < 0 || index >= mesh->_vertexCount) {
+                return false;
             }
-            vertexJointNormal[i] = cumulatedJointNormal.normalize();
-        }
-        delete[] surfaceNormals;
-
-        int i;
-        for(i = 0; i < mesh->_triangleCount; i++) {
-            int i1 = mesh->_triangles[i]._indices[0];
-            int i2 = mesh->_triangles[i]._indices[1];
-            int i3 = mesh->_triangles[i]._indices[2];
-
-            _vertices[i * 9 + 0] = mesh->_vertices[i1].x();
-            _vertices[i * 9 + 1] = mesh->_vertices[i1].y();
-            _vertices[i * 9 + 2] = mesh->_vertices[i1].z();
-            _vertices[i * 9 + 3] = mesh->_vertices[i2].x();
-            _vertices[i * 9 + 4] = mesh->_vertices[i2].y();
-            _vertices[i * 9 + 5] = mesh->_vertices[i2].z();
-            _vertices[i * 9 + 6] = mesh->_vertices[i3].x();
-            _vertices[i * 9 + 7] = mesh->_vertices[i3].y();
-            _vertices[i * 9 + 8] = mesh->_vertices[i3].z();
-
-            _texCoords[i * 6 + 0] = mesh->_textureCoordinates[i1].x();
-            _texCoords[i * 6 + 1] = mesh->_textureCoordinates[i1].y();
-            _texCoords[i * 6 + 2] = mesh->_textureCoordinates[i2].x();
-            _texCoords[i * 6 + 3] = mesh->_textureCoordinates[i2].y();
-            _texCoords[i * 6 + 4] = mesh->_textureCoordinates[i3].x();
-            _texCoords[i * 6 + 5] = mesh->_textureCoordinates[i3].y();
-
-            _normals[i * 9 + 0] = vertexJointNormal[i1].x();
-            _normals[i * 9 + 1] = vertexJointNormal[i1].y();
-            _normals[i * 9 + 2] = vertexJointNormal[i1].z();
-            _normals[i * 9 + 3] = vertexJointNormal[i2].x();
-            _normals[i * 9 + 4] = vertexJointNormal[i2].y();
-            _normals[i * 9 + 5] = vertexJointNormal[i2].z();
-            _normals[i * 9 + 6] = vertexJointNormal[i3].x();
-            _normals[i * 9 + 7] = vertexJointNormal[i3].y();
-            _normals[i * 9 + 8] = vertexJointNormal[i3].z();
         }
+        return true;
+    }
 
-        postCompile();
+    NormalBuilder::Weighting CompiledMesh::normalWeighting() {
+        if(_properties & AngleWeightedNormals) {
+            return NormalBuilder::AngleWeighted;
+        } else if(_properties & AreaWeightedNormals) {
+            return NormalBuilder::AreaWeighted;
+        }
+        return NormalBuilder::Uniform;
+    }
+
+    void CompiledMesh::encodeVertex(Mesh *mesh, int index, Vector3D normal, Vertex& vertex) {
+        Vector3D& position = mesh->_vertices[index];
+        Vector2D& texCoord = mesh->_textureCoordinates[index];
+        vertex._position[0] = (GLfloat)position.x();
+        vertex._position[1] = (GLfloat)position.y();
+        vertex._position[2] = (GLfloat)position.z();
+
+        vertex._normal[0] = (GLfloat)normal.x();
+        vertex._normal[1] = (GLfloat)normal.y();
+        vertex._normal[2] = (GLfloat)normal.z();
+
+        vertex._texCoord[0] = (GLfloat)texCoord.x();
+        vertex._texCoord[1] = (GLfloat)texCoord.y();
+    }
+
+    void CompiledMesh::encodeVertex(Mesh *mesh, int index, Vector3D normal, CompressedVertex& vertex) {
+        Vector3D& position = mesh->_vertices[index];
+        Vector2D& texCoord = mesh->_textureCoordinates[index];
+        vertex._position[0] = CompressedVertex::quantize(position.x(), _positionOffset.x(), _positionScale.x());
+        vertex._position[1] = CompressedVertex::quantize(position.y(), _positionOffset.y(), _positionScale.y());
+        vertex._position[2] = CompressedVertex::quantize(position.z(), _positionOffset.z(), _positionScale.z());
+        vertex._position[3] = 0;
+
+        CompressedVertex::encodeNormal(normal, vertex._normal);
+
+        vertex._texCoord[0] = CompressedVertex::quantize(texCoord.x(), _texCoordOffset.x(), _texCoordScale.x());
+        vertex._texCoord[1] = CompressedVertex::quantize(texCoord.y(), _texCoordOffset.y(), _texCoordScale.y());
     }
 
     CompiledMesh::~CompiledMesh() {
-        glDeleteBuffers(1, &_normalsVBOHandle);
-        glDeleteBuffers(1, &_verticesVBOHandle);
-        glDeleteBuffers(1, &_texCoordsVBOHandle);
+        // Make sure no background compilation is still writing into us.
+        MeshCompiler::instance().cancel(this);
+
+        if(_uploaded) {
+            glDeleteVertexArrays(1, &_vertexArrayHandle);
+            glDeleteBuffers(1, &_verticesVBOHandle);
+            glDeleteBuffers(1, &_indicesVBOHandle);
+        }
+
+        delete[] _vertices;
+        delete[] _compressedVertices;
+        delete[] _shortIndices;
+        delete[] _intIndices;
     }
 
-    void CompiledMesh::allocateMemory(int triangleCount) {
-        // Each triangle has three vertices.
-        _count = triangleCount * 3;
+    void CompiledMesh::upload() {
+        if(!_compiled || _uploaded) {
+            return;
+        }
+        postCompile();
+        _uploaded = true;
+    }
 
-        // Each triangle has three normals, of which each has three
-        // coordinate values.
-        _normals = new double[_count * 3];
+    int CompiledMesh::uploadSize() {
+        if(!_compiled || _uploaded) {
+            return 0;
+        }
 
-        // Each triangle has three vertices, of which each has three
-        // coordinate values.
-        _vertices = new double[_count * 3];
+        int vertexSize = (_properties & CompressedVertices) ? sizeof(CompressedVertex) : sizeof(Vertex);
+        int indexSize = _indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        return _vertexCount * vertexSize + _indexCount * indexSize;
+    }
 
-        // Each triangle has three vertices, of which each has two
-        // coordinate values.
-        _texCoords = new double[_count * 2];
+    bool CompiledMesh::isReady() {
+        return _uploaded;
+    }
+
+    void CompiledMesh::allocateMemory(int vertexCount, int triangleCount) {
+        _vertexCount = vertexCount;
+
+        // Each vertex holds its position, normal and texture coordinates.
+        _vertices = 0;
+        _compressedVertices = 0;
+        if(_properties & CompressedVertices) {
+            _compressedVertices = new CompressedVertex[_vertexCount];
+        } else {
+            _vertices = new Vertex[_vertexCount];
+        }
+
+        // Each triangle has three indices. Use 16 bit indices whenever
+        // all vertices can be addressed with them.
+        _shortIndices = 0;
+        _intIndices = 0;
+        if(_vertexCount <= 65536) {
+            _indexType = GL_UNSIGNED_SHORT;
+            _shortIndices = new GLushort[triangleCount * 3];
+        } else {
+            _indexType = GL_UNSIGNED_INT;
+            _intIndices = new GLuint[triangleCount * 3];
+        }
     }
 
     void CompiledMesh::postCompile() {
-        // Generate vertex buffer obejcts
-        glGenBuffers(1, &_normalsVBOHandle);
+        // Generate vertex array and buffer objects
+        glGenVertexArrays(1, &_vertexArrayHandle);
         glGenBuffers(1, &_verticesVBOHandle);
-        glGenBuffers(1, &_texCoordsVBOHandle);
+        glGenBuffers(1, &_indicesVBOHandle);
+
+        glBindVertexArray(_vertexArrayHandle);
 
         // Upload vertex data to graphics card
-        glBindBuffer(GL_ARRAY_BUFFER, _normalsVBOHandle);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * _count * 3, _normals, GL_STATIC_DRAW);
         glBindBuffer(GL_ARRAY_BUFFER, _verticesVBOHandle);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * _count * 3, _vertices, GL_STATIC_DRAW);
-        glBindBuffer(GL_ARRAY_BUFFER, _texCoordsVBOHandle);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(double) * _count * 2, _texCoords, GL_STATIC_DRAW);
+        if(_properties & CompressedVertices) {
+            glBufferData(GL_ARRAY_BUFFER, sizeof(CompressedVertex) * _vertexCount, _compressedVertices, GL_STATIC_DRAW);
+            CompressedVertex::describeLayout();
+        } else {
+            glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _vertexCount, _vertices, GL_STATIC_DRAW);
+            Vertex::describeLayout();
+        }
+
+        // Upload index data to graphics card
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indicesVBOHandle);
+        if(_indexType == GL_UNSIGNED_SHORT) {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * _indexCount, _shortIndices, GL_STATIC_DRAW);
+        } else {
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * _indexCount, _intIndices, GL_STATIC_DRAW);
+        }
+
+        glBindVertexArray(0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
         // Free memory
-        delete[] _normals;
         delete[] _vertices;
-        delete[] _texCoords;
+        delete[] _compressedVertices;
+        delete[] _shortIndices;
+        delete[] _intIndices;
+        _vertices = 0;
+        _compressedVertices = 0;
+        _shortIndices = 0;
+        _intIndices = 0;
     }
 
     void CompiledMesh::render() {
-        glBindBuffer(GL_ARRAY_BUFFER, _verticesVBOHandle);
-        glVertexPointer(3, GL_DOUBLE, 0, 0L);
-        glBindBuffer(GL_ARRAY_BUFFER, _texCoordsVBOHandle);
-        glTexCoordPointer(2, GL_DOUBLE, 0, 0);
-        glBindBuffer(GL_ARRAY_BUFFER, _normalsVBOHandle);
-        glNormalPointer(GL_DOUBLE, 0, 0L);
+        if(!_uploaded) {
+            return;
+        }
+
+        if(bind()) {
+            draw();
+            release();
+        }
+    }
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glEnableClientState(GL_NORMAL_ARRAY);
+    bool CompiledMesh::bind() {
+        if(!_uploaded) {
+            return false;
+        }
+
+        if(_properties & CompressedVertices) {
+            Program *program = Program::current();
+            if(!program) {
+                warning("Compressed vertices can only be rendered with a shader program.");
+                return false;
+            }
+            program->setCompressedVertexDecoding(_positionOffset, _positionScale,
+                                                 _texCoordOffset, _texCoordScale);
+        }
 
-        glDrawArrays(GL_TRIANGLES, 0, _count * 3);
+        glBindVertexArray(_vertexArrayHandle);
+        G3D_COUNT_BUFFER_BINDS(1);
+        return true;
+    }
 
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-        glDisableClientState(GL_NORMAL_ARRAY);
+    void CompiledMesh::draw() {
+        if(!_uploaded) {
+            return;
+        }
 
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDrawElements(GL_TRIANGLES, _indexCount, _indexType, 0);
+        G3D_COUNT_DRAW_CALL(_indexCount / 3);
+    }
+
+    void CompiledMesh::drawInstanced(int instanceCount) {
+        if(!_uploaded || instanceCount <= 0) {
+            return;
+        }
+
+        glDrawElementsInstanced(GL_TRIANGLES, _indexCount, _indexType, 0, instanceCount);
+        G3D_COUNT_DRAW_CALL((qint64)_indexCount / 3 * instanceCount);
+    }
+
+    void CompiledMesh::release() {
+        if(!_uploaded) {
+            return;
+        }
+
+        glBindVertexArray(0);
+
+        Program *program = Program::current();
+        if((_properties & CompressedVertices) && program) {
+            program->resetVertexDecoding();
+        }
     }
 
     double CompiledMesh::collisionRadius() {
         return _collisionRadius;
     }
 
+    AxisAlignedBox CompiledMesh::boundingBox() {
+        return _boundingBox;
+    }
+
+    BoundingSphere CompiledMesh::boundingSphere() {
+        return _boundingSphere;
+    }
+
+    OrientedBox CompiledMesh::orientedBox() {
+        return _orientedBox;
+    }
+
+    int CompiledMesh::properties() {
+        return _properties;
+    }
+
 } // namespace Glee3D
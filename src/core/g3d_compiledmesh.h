@@ -24,6 +24,11 @@
 // Own includes
 #include "g3d_mesh.h"
 #include "g3d_logging.h"
+#include "g3d_vertex.h"
+#include "g3d_normalbuilder.h"
+#include "math/g3d_axisalignedbox.h"
+#include "math/g3d_boundingsphere.h"
+#include "math/g3d_orientedbox.h"
 
 // Qt includes
 #include <QGLWidget>
@@ -39,19 +44,101 @@ namespace Glee3D {
       *
       * Compiled meshes have already been loaded to the graphics card and
       * will be be rendered using vertex buffer objects directly on the card.
+      * Vertices shared between triangles are uploaded only once, the
+      * triangles are drawn from an index buffer. Meshes with less than
+      * 65536 vertices use 16 bit indices. Vertices are stored interleaved
+      * in single precision, the layout is recorded in a vertex array object.
+      *
+      * With the CompressedVertices property, vertices are quantized into the
+      * 16 byte CompressedVertex format instead and decoded by the shader.
+      *
+      * Compilation happens in two stages. compile() prepares all vertex data
+      * in main memory and does not need an OpenGL context, so it may run on
+      * any thread. upload() transfers the data to the graphics card and has
+      * to be called on the render thread. The MeshCompiler runs both stages
+      * in the background and under a per-frame budget respectively.
+      *
+      * Very large meshes can be compiled with the StreamingCompile property.
+      * The mesh is then processed in fixed-size chunks that are written
+      * straight into mapped buffer ranges, instead of building a full copy
+      * of the vertices. To keep normals linear in the mesh size, triangles
+      * are sorted into the chunks first, which takes one index per triangle,
+      * about a third of the memory of the triangles themselves. Streaming
+      * needs the OpenGL context, so it is only done by the constructor
+      * taking a mesh. Note that the OptimizeVertexOrder property still needs
+      * memory proportional to the mesh, for the optimized copy.
       */
     class CompiledMesh :
         public Logging {
     public:
-        /** Create a compiled mesh from the given mesh. */
-        CompiledMesh(Mesh *mesh);
+        /** @enum CompileProperties */
+        enum CompileProperties {
+            AreaWeightedNormals     = 1 << 0,
+            AngleWeightedNormals    = 1 << 1,
+            CompressedVertices      = 1 << 2,
+            OptimizeVertexOrder     = 1 << 3,
+            StreamingCompile        = 1 << 4
+        };
+
+        /**
+         * Create a compiled mesh from the given mesh. With the
+         * OptimizeVertexOrder property, a copy of the mesh is reordered by
+         * a MeshOptimizer first, the given mesh is never changed.
+         * @param mesh The mesh to compile.
+         * @param properties Compile properties.
+         */
+        CompiledMesh(Mesh *mesh, int properties = 0);
+
+        /**
+         * Create an empty compiled mesh, that has to be compiled and
+         * uploaded before it can be rendered.
+         * @param properties Compile properties.
+         */
+        explicit CompiledMesh(int properties);
 
         /** Destructor */
         ~CompiledMesh();
 
-        /** Render the compiled mesh. */
+        /**
+         * Prepares the vertex data of the given mesh for uploading. This does
+         * not require an OpenGL context.
+         * @param mesh The mesh to compile.
+         */
+        void compile(Mesh *mesh);
+
+        /** Uploads the compiled vertex data to the graphics card. */
+        void upload();
+
+        /** @returns the number of bytes upload() will transfer. */
+        int uploadSize();
+
+        /** @returns true, if the mesh has been uploaded and can be rendered. */
+        bool isReady();
+
+        /** Render the compiled mesh. Does nothing until it is ready. */
         void render();
 
+        /**
+         * Binds the vertex data of this mesh. Consecutive draw() calls render
+         * the mesh without binding it again, until release() is called or
+         * another mesh is bound. This is what render() does in one go.
+         * @returns false, if the mesh cannot be rendered.
+         */
+        bool bind();
+
+        /** Draws the mesh, which must have been bound before. */
+        void draw();
+
+        /**
+         * Draws the given number of instances of the mesh, which must have
+         * been bound before along with the instance attributes.
+         * @see InstanceAttributes
+         */
+        void drawInstanced(int instanceCount);
+
+        /** Releases the vertex data bound by bind(). */
+        void release();
+
         /**
          * @returns the calculated collision radius for this mesh. This is
          * typically used in collision detection algorithms, where you first
@@ -60,9 +147,24 @@ namespace Glee3D {
          */
         double collisionRadius();
 
+        /** @returns the axis aligned bounding box of the mesh in model space. */
+        AxisAlignedBox boundingBox();
+
+        /**
+         * @returns a tight bounding sphere of the mesh in model space. Unlike
+         * collisionRadius(), the sphere is not centered at the origin.
+         */
+        BoundingSphere boundingSphere();
+
+        /** @returns an oriented bounding box of the mesh in model space. */
+        OrientedBox orientedBox();
+
+        /** @returns the properties this mesh has been compiled with. */
+        int properties();
+
     protected:
         /** Allocate the needed memory. */
-        void allocateMemory(int triangleCount);
+        void allocateMemory(int vertexCount, int triangleCount);
 
         /**
          * Perform post compilation steps, for example uploading data to the
@@ -71,14 +173,36 @@ namespace Glee3D {
         void postCompile();
 
     private:
-        int _count;
-        double *_normals;
-        double *_vertices;
-        double *_texCoords;
-        GLuint   _normalsVBOHandle;
+        void initialize(int properties);
+        void compileStreaming(Mesh *mesh);
+        Mesh *optimizedCopy(Mesh *mesh);
+        void measure(Mesh *mesh);
+        bool isValid(Mesh *mesh, int triangle);
+        NormalBuilder::Weighting normalWeighting();
+        void encodeVertex(Mesh *mesh, int index, Vector3D normal, Vertex& vertex);
+        void encodeVertex(Mesh *mesh, int index, Vector3D normal, CompressedVertex& vertex);
+
+        int _properties;
+        bool _compiled;
+        bool _uploaded;
+        int _vertexCount;
+        int _indexCount;
+        Vertex   *_vertices;
+        CompressedVertex *_compressedVertices;
+        Vector3D _positionOffset;
+        Vector3D _positionScale;
+        Vector2D _texCoordOffset;
+        Vector2D _texCoordScale;
+        GLushort *_shortIndices;
+        GLuint   *_intIndices;
+        GLenum   _indexType;
+        GLuint   _vertexArrayHandle;
         GLuint   _verticesVBOHandle;
-        GLuint   _texCoordsVBOHandle;
+        GLuint   _indicesVBOHandle;
         double   _collisionRadius;
+        AxisAlignedBox _boundingBox;
+        BoundingSphere _boundingSphere;
+        OrientedBox _orientedBox;
     };
 
 } // namespace Glee3D
@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_compiledmeshregistry.h"
+
+// Qt includes
+#include <QCryptographicHash>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+
+namespace Glee3D {
+
+namespace {
+    /** Number of vertices or triangles hashed at once. */
+    const int keyBlockSize = 256;
+}
+
+CompiledMeshRegistry::CompiledMeshRegistry()
+    : Logging("CompiledMeshRegistry") {
+    _hits = 0;
+    _misses = 0;
+}
+
+QByteArray CompiledMeshRegistry::contentKey(Mesh *mesh, int properties) {
+    if(!mesh) {
+        return QByteArray();
+    }
+
+    int vertexCount = mesh->vertexCount();
+    int triangleCount = mesh->triangleCount();
+    quintptr context = (quintptr)QOpenGLContext::currentContext();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData((const char*)&context, sizeof(context));
+
+    int header[3] = { vertexCount, triangleCount, properties };
+    hash.addData((const char*)header, sizeof(header));
+
+    // The mesh is hashed in small blocks, so that keying does not need
+    // memory in proportion to the mesh.
+    int indexData[keyBlockSize * 3];
+    for(int first = 0; first < triangleCount; first += keyBlockSize) {
+        int count = qMin((int)keyBlockSize, triangleCount - first);
+        for(int i = 0; i < count; i++) {
+            Triangle triangle = mesh->triangle(first + i);
+            indexData[i * 3 + 0] = triangle._indices[0];
+            indexData[i * 3 + 1] = triangle._indices[1];
+            indexData[i * 3 + 2] = triangle._indices[2];
+        }
+        hash.addData((const char*)indexData, count * 3 * sizeof(int));
+    }
+
+    double vertexData[keyBlockSize * 5];
+    for(int first = 0; first < vertexCount; first += keyBlockSize) {
+        int count = qMin((int)keyBlockSize, vertexCount - first);
+        for(int i = 0; i < count; i++) {
+            Vector3D vertex = mesh->vertex(first + i);
+            Vector2D textureCoordinates = mesh->textureCoordinates(first + i);
+            vertexData[i * 5 + 0] = vertex.x();
+            vertexData[i * 5 + 1] = vertex.y();
+            vertexData[i * 5 + 2] = vertex.z();
+            vertexData[i * 5 + 3] = textureCoordinates.x();
+            vertexData[i * 5 + 4] = textureCoordinates.y();
+        }
+        hash.addData((const char*)vertexData, count * 5 * sizeof(double));
+    }
+    return hash.result();
+}
+
+CompiledMesh *CompiledMeshRegistry::acquire(QByteArray key) {
+    QMutexLocker locker(&_mutex);
+    if(!_entries.contains(key)) {
+        _misses++;
+        return 0;
+    }
+
+    Entry& entry = _entries[key];
+    entry._references++;
+    _hits++;
+    return entry._compiledMesh;
+}
+
+CompiledMesh *CompiledMeshRegistry::acquire(Mesh *mesh, int properties) {
+    if(!mesh) {
+        return 0;
+    }
+
+    QByteArray key = contentKey(mesh, properties);
+    CompiledMesh *compiledMesh = acquire(key);
+    if(!compiledMesh) {
+        compiledMesh = insert(key, new CompiledMesh(mesh, properties));
+    }
+    return compiledMesh;
+}
+
+CompiledMesh *CompiledMeshRegistry::insert(QByteArray key, CompiledMesh *compiledMesh) {
+    if(!compiledMesh) {
+        return 0;
+    }
+
+    QMutexLocker locker(&_mutex);
+    if(_entries.contains(key)) {
+        // Someone else has compiled the same mesh in the meantime.
+        Entry& entry = _entries[key];
+        if(entry._compiledMesh != compiledMesh) {
+            delete compiledMesh;
+        }
+        entry._references++;
+        return entry._compiledMesh;
+    }
+
+    Entry entry;
+    entry._compiledMesh = compiledMesh;
+    entry._references = 1;
+    _entries[key] = entry;
+    _keys[compiledMesh] = key;
+    return compiledMesh;
+}
+
+void CompiledMeshRegistry::release(CompiledMesh *compiledMesh) {
+    if(!compiledMesh) {
+        return;
+    }
+
+    QMutexLocker locker(&_mutex);
+    if(!_keys.contains(compiledMesh)) {
+        // Not shared, the caller was the only user.
+        delete compiledMesh;
+        return;
+    }
+
+    QByteArray key = _keys[compiledMesh];
+    Entry& entry = _entries[key];
+    entry._references--;
+    if(entry._references <= 0) {
+        _entries.remove(key);
+        _keys.remove(compiledMesh);
+        delete compiledMesh;
+    }
+}
+
+int CompiledMeshRegistry::hits() {
+    QMutexLocker locker(&_mutex);
+    return _hits;
+}
+
+int CompiledMeshRegistry::misses() {
+    QMutexLocker locker(&_mutex);
+    return _misses;
+}
+
+int CompiledMeshRegistry::size() {
+    QMutexLocker locker(&_mutex);
+    return _entries.size();
+}
+
+void CompiledMeshRegistry::resetCounters() {
+    QMutexLocker locker(&_mutex);
+    _hits = 0;
+    _misses = 0;
+}
+
+} // namespace Glee3D
@@ -0,0 +1,121 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_COMPILEDMESHREGISTRY_H
+#define G3D_COMPILEDMESHREGISTRY_H
+
+// Own includes
+#include "g3d_compiledmesh.h"
+#include "g3d_mesh.h"
+#include "g3d_logging.h"
+
+// Qt includes
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+
+namespace Glee3D {
+
+/**
+  * @class CompiledMeshRegistry
+  * Shares compiled meshes between entities with identical geometry. Compiled
+  * meshes are registered under a key derived from the mesh contents and the
+  * compile properties, and are reference counted. A compiled mesh is deleted
+  * when its last user releases it.
+  *
+  * Vertex array objects cannot be shared between OpenGL contexts, so the
+  * key also identifies the context that is current when it is created.
+  * Several render threads with their own contexts, like the offscreen
+  * renderers of a batch render, each get their own compiled meshes. The
+  * registry itself may be used from several threads at once.
+  */
+class CompiledMeshRegistry : public Logging {
+public:
+    static CompiledMeshRegistry& instance() {
+        static CompiledMeshRegistry compiledMeshRegistry;
+        return compiledMeshRegistry;
+    }
+
+    /**
+      * @returns a key identifying the vertices, triangles and texture
+      * coordinates of the given mesh together with the compile properties
+      * and the current OpenGL context.
+      */
+    static QByteArray contentKey(Mesh *mesh, int properties);
+
+    /**
+      * Looks up a compiled mesh and takes a reference on it.
+      * @param key Key the compiled mesh has been registered with.
+      * @returns the compiled mesh, or null if there is none.
+      */
+    CompiledMesh *acquire(QByteArray key);
+
+    /**
+      * Returns the shared compiled mesh for the given mesh, compiling and
+      * registering it if there is none yet. Takes a reference on it.
+      * @param mesh The mesh to compile.
+      * @param properties Compile properties.
+      */
+    CompiledMesh *acquire(Mesh *mesh, int properties = 0);
+
+    /**
+      * Registers a compiled mesh under the given key, holding one reference.
+      * If the key is already taken, the given compiled mesh is deleted and a
+      * reference on the registered one is taken instead.
+      * @returns the registered compiled mesh.
+      */
+    CompiledMesh *insert(QByteArray key, CompiledMesh *compiledMesh);
+
+    /**
+      * Gives up a reference on the given compiled mesh, deleting it when it
+      * was the last one.
+      */
+    void release(CompiledMesh *compiledMesh);
+
+    /** @returns the number of lookups that found a compiled mesh. */
+    int hits();
+
+    /** @returns the number of lookups that did not find a compiled mesh. */
+    int misses();
+
+    /** @returns the number of registered compiled meshes. */
+    int size();
+
+    /** Resets the hit and miss counters. */
+    void resetCounters();
+
+private:
+    CompiledMeshRegistry();
+
+    struct Entry {
+        CompiledMesh *_compiledMesh;
+        int _references;
+    };
+
+    QMutex _mutex;
+    QHash<QByteArray, Entry> _entries;
+    QHash<CompiledMesh*, QByteArray> _keys;
+    int _hits;
+    int _misses;
+};
+
+} // namespace Glee3D
+
+#endif // G3D_COMPILEDMESHREGISTRY_H
@@ -20,7 +20,6 @@
 
 // Own includes
 #include "g3d_display.h"
-#include "g3d_skybox.h"
 #include "g3d_texturestore.h"
 #include "g3d_utilities.h"
 #include "math/g3d_matrix4x4.h"
@@ -29,6 +28,11 @@
 #include <iostream>
 
 namespace Glee3D {
+    namespace {
+        /** Weight of the latest frame in the average frame time. */
+        const double frameTimeSmoothing = 0.1;
+    }
+
     Display::Display(QWidget *parent)
         : QGLWidget(parent),
           Logging("Display") {
@@ -38,19 +42,23 @@ namespace Glee3D {
             setFocus();
         }
 
+        // Statistics are handed to queued connections as well.
+        qRegisterMetaType<FrameProfiler::Statistics>("FrameProfiler::Statistics");
+        qRegisterMetaType<FrameProfiler::Statistics>("Glee3D::FrameProfiler::Statistics");
+
         _scene = 0;
         _activeCamera = new Camera();
         _mouseMoveMode = Normal;
 
         _framesPerSecondCounter = 0;
         _framesPerSecond = 0;
+        _targetFramesPerSecond = 60;
+        _benchmarkMode = false;
+        _averageFrameTime = 0.0;
 
-        _logicTimer.setInterval(20);
-        _logicTimer.setSingleShot(false);
-        connect(&_logicTimer, SIGNAL(timeout()), this, SLOT(processLogic()));
-
-        _refreshTimer.setInterval(1000 / 60);
-        _refreshTimer.setSingleShot(false);
+        // The refresh timer is restarted after each frame, see paintGL().
+        _refreshTimer.setInterval(0);
+        _refreshTimer.setSingleShot(true);
         connect(&_refreshTimer, SIGNAL(timeout()), this, SLOT(refresh()));
 
         _framesPerSecondTimer.setInterval(1000);
@@ -59,16 +67,35 @@ namespace Glee3D {
 
         _refreshTimer.start();
         _framesPerSecondTimer.start();
-        _logicTimer.start();
+
+        _renderer.setFrameProfiler(&_frameProfiler);
+
+        _logicThread.setCamera(_activeCamera);
+        _logicThread.start();
 
         _frameBuffer = 0;
         setAutoBufferSwap(false);
         setMouseTracking(true);
     }
 
+    Display::~Display() {
+        _logicThread.stop();
+
+        // The profiler releases its timer queries.
+        makeCurrent();
+        _renderer.releaseResources();
+    }
+
     void Display::setActiveCamera(Camera *camera) {
+        if(_scene) {
+            _scene->lockScene();
+        }
         _activeCamera = camera;
         _activeCamera->setAspectRatio(width(), height());
+        if(_scene) {
+            _scene->unlockScene();
+        }
+        _logicThread.setCamera(camera);
         updateGL();
     }
 
@@ -78,6 +105,7 @@ namespace Glee3D {
 
     void Display::setScene(Scene *scene) {
         _scene = scene;
+        _logicThread.setScene(scene);
     }
 
     Scene *Display::scene() {
@@ -142,6 +170,54 @@ namespace Glee3D {
         return point;
     }
 
+    int Display::drawnEntityCount() {
+        return _renderer.drawnEntityCount();
+    }
+
+    int Display::culledEntityCount() {
+        return _renderer.culledEntityCount();
+    }
+
+    RenderQueue& Display::renderQueue() {
+        return _renderer.renderQueue();
+    }
+
+    Renderer& Display::renderer() {
+        return _renderer;
+    }
+
+    LogicThread& Display::logicThread() {
+        return _logicThread;
+    }
+
+    FrameProfiler& Display::frameProfiler() {
+        return _frameProfiler;
+    }
+
+    RenderCounters::Counters Display::renderCounters() {
+        return _renderCounters;
+    }
+
+    void Display::setTargetFramesPerSecond(int framesPerSecond) {
+        _targetFramesPerSecond = qMax(1, framesPerSecond);
+    }
+
+    int Display::targetFramesPerSecond() {
+        return _targetFramesPerSecond;
+    }
+
+    void Display::setBenchmarkMode(bool on) {
+        _benchmarkMode = on;
+    }
+
+    bool Display::benchmarkMode() {
+        return _benchmarkMode;
+    }
+
+    double Display::averageFrameTime() {
+        return _averageFrameTime;
+    }
+
     void Display::initializeGL() {
         configureOpenGL();
 
@@ -149,17 +225,20 @@ namespace Glee3D {
             effect->initialize();
         }
 
-        information("Building per pixel renderer.");
-        if(!_renderProgram.build(":/shaders/glsl/perpixellighting.vert.glsl",
-                                 ":/shaders/glsl/perpixellighting.frag.glsl")) {
-           error("Failed building GL render program.");
-        }
+        _renderer.initialize();
     }
 
     void Display::resizeGL(int w, int h) {
         glViewport(0, 0, (GLint)w, (GLint)h);
         if(_activeCamera) {
+            // The camera belongs to the logic thread.
+            if(_scene) {
+                _scene->lockScene();
+            }
             _activeCamera->setAspectRatio(w, h);
+            if(_scene) {
+                _scene->unlockScene();
+            }
         }
 
         delete _frameBuffer;
@@ -167,79 +246,62 @@ namespace Glee3D {
     }
 
     void Display::paintGL() {
+        _frameTimer.start();
         makeCurrent();
-        _renderProgram.insert();
+        _frameProfiler.beginFrame();
+        RenderCounters::reset();
         _frameBuffer->clear();
-        if(_scene) {
-            _scene->lockScene();
-            if(_activeCamera) {
-                Matrix4x4 cameraProjectionMatrix = _activeCamera->projectionMatrix();
-                Matrix4x4 cameraModelViewMatrix = _activeCamera->modelviewMatrix();
-
-                _renderProgram.setProjectionMatrix(cameraProjectionMatrix);
-
-                SkyBox *s = _scene->skyBox();
-                if(s) {
-                    s->render();
-                }
-
-                QSet<LightSource*> lightSources = _scene->lightSources();
-                int i = 0;
-                foreach(LightSource* lightSource, lightSources) {
-                    lightSource->activate(GL_LIGHT0 + i);
-                    i++;
-                    if(i > 7) {
-                        i = 7;
-                        // TODO: Decide which light sources to use in order
-                        // to exceed OpenGLs limit of only eight light sources.
-
-                        // TODO: This should be handled by own shaders.
-                    }
-                }
-
-                // Render terrains.
-                QSet<Terrain*> terrains = _scene->terrains();
-                foreach(Terrain *terrain, terrains) {
-                    _renderProgram.setModelViewMatrix(terrain->translationMatrix().multiplicate(cameraModelViewMatrix));
-                    terrain->render();
-                }
-
-                // Render objects.
-                QSet<Entity*> objects = _scene->entities();
-                foreach(Entity *object, objects) {
-                    // Tell the object to render itself
-                    _renderProgram.setModelViewMatrix(object->rotationMatrix()
-                        .multiplicate(object->translationMatrix())
-                        .multiplicate(cameraModelViewMatrix));
-                    object->render();
-                }
-            }
-            _scene->unlockScene();
-        }
+
+        // Render the latest state published by the logic thread. The snapshot
+        // stays alive until we are done with it, even if a newer one arrives.
+        QSharedPointer<SceneSnapshot> snapshot = _logicThread.renderSnapshot();
+        _renderer.render(snapshot.data(), width(), height());
 
         _frameBuffer->release();
 
-        foreach(PostRenderEffect *effect, _postRenderEffects) {
-            effect->apply(_frameBuffer);
+        for(int i = 0; i < _postRenderEffects.size(); i++) {
+            FrameProfiler::ScopedPass pass(&_frameProfiler, FrameProfiler::PostRenderEffectPass + i);
+            _postRenderEffects[i]->apply(_frameBuffer);
         }
 
-        _renderProgram.setProjectionMatrix(Utilities::ortho(0, _frameBuffer->width(), 0, _frameBuffer->height(), -10, 10));
-        _renderProgram.setModelViewMatrix(Matrix4x4().withTranslation(Vector3D(0, 0, -6)));
-        _frameBuffer->copy();
-        swapBuffers();
-    }
+        {
+            FrameProfiler::ScopedPass pass(&_frameProfiler, FrameProfiler::CopyPass);
+            Program& renderProgram = _renderer.renderProgram();
+            renderProgram.setProjectionMatrix(Utilities::ortho(0, _frameBuffer->width(), 0, _frameBuffer->height(), -10, 10));
+            renderProgram.setModelViewMatrix(Matrix4x4().withTranslation(Vector3D(0, 0, -6)));
+            _frameBuffer->copy();
+        }
+        _frameProfiler.endFrame();
+        _renderCounters = RenderCounters::current();
 
-    void Display::refresh() {
+        // Destroyed objects may own OpenGL resources, so they are deleted
+        // here with the context current.
+        if(_scene) {
+            _scene->deleteDestroyed();
+        }
+
+        // Waiting for the buffer swap is not part of the frame cost. The GPU
+        // works in parallel, so its time is taken from the profiler, which
+        // reports it a few frames late, rather than waiting for it here.
+        double frameTime = (double)_frameTimer.nsecsElapsed() / 1000000.0;
+        FrameProfiler::FrameRecord frameRecord;
+        if(_frameProfiler.enabled() && _frameProfiler.record(0, frameRecord) && frameRecord._gpuFrameTime >= 0) {
+            frameTime = qMax(frameTime, (double)frameRecord._gpuFrameTime / 1000000.0);
+        }
+        _averageFrameTime += (frameTime - _averageFrameTime) * frameTimeSmoothing;
+        swapBuffers();
         _framesPerSecondCounter++;
-        QMetaObject::invokeMethod(this, "updateGL");
-    }
 
-    void Display::processLogic() {
-        if(_scene) {
-            _scene->lockScene();
-            _scene->processLogic(_keyStatusMap, _activeCamera);
-            _scene->unlockScene();
+        // Schedule the next frame, so that frames start at the target rate.
+        int delay = 0;
+        if(!_benchmarkMode) {
+            delay = qMax(0, (int)(1000.0 / _targetFramesPerSecond - _averageFrameTime));
         }
+        _refreshTimer.start(delay);
+    }
+
+    void Display::refresh() {
+        updateGL();
     }
 
     void Display::mousePressEvent(QMouseEvent *mouseEvent) {
@@ -262,7 +324,9 @@ namespace Glee3D {
         case Qt::LeftButton:
             _mouseMoveMode = Normal;
             if(_scene) {
+                _scene->lockScene();
                 _scene->endDrag(ray(mouseEvent->pos()), point(mouseEvent->pos()));
+                _scene->unlockScene();
             }
             break;
         default:
@@ -290,53 +354,48 @@ namespace Glee3D {
         _framesPerSecond = _framesPerSecondCounter;
         _framesPerSecondCounter = 0;
         emit framesPerSecond(_framesPerSecond);
+        if(_frameProfiler.enabled() && _framesPerSecond > 0) {
+            emit frameStatistics(_frameProfiler.statistics(_framesPerSecond));
+        }
     }
 
     void Display::leftButtonClick(QPoint displayPoint) {
         // Make sure any scene is set.
         if(_scene) {
+            _scene->lockScene();
             _scene->select(ray(displayPoint), point(displayPoint));
+            _scene->unlockScene();
         }
     }
 
     void Display::hover(QPoint hoverPoint) {
         if(_scene) {
+            _scene->lockScene();
             _scene->hover(ray(hoverPoint), point(hoverPoint));
+            _scene->unlockScene();
         }
     }
 
     void Display::drag(QPoint dragFrom, QPoint dragTo) {
         // Make sure any scene is set.
         if(_scene) {
+            _scene->lockScene();
             _scene->drag(ray(dragFrom), ray(dragTo), point(dragFrom), point(dragTo));
+            _scene->unlockScene();
         }
     }
 
     void Display::keyPressEvent(QKeyEvent *keyEvent) {
         _keyStatusMap[keyEvent->key()] = true;
+        _logicThread.setKeyStatusMap(_keyStatusMap);
     }
 
     void Display::keyReleaseEvent(QKeyEvent *keyEvent) {
         _keyStatusMap[keyEvent->key()] = false;
+        _logicThread.setKeyStatusMap(_keyStatusMap);
     }
 
     void Display::configureOpenGL() {
-        // Disable normalization since we will precalculate our normals.
-        glDisable(GL_NORMALIZE);
-        // Disable the default OpenGL lightning because we will provide our own
-        glDisable(GL_LIGHTING);
-
-        glEnable(GL_DEPTH_TEST);
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_SMOOTH);
-        glEnable(GL_POINT_SMOOTH);
-        glEnable(GL_LINE_SMOOTH);
-        glEnable(GL_POLYGON_SMOOTH);
-        glEnable(GL_TEXTURE_2D);
-        glEnable(GL_BLEND);
-
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        glPointSize(1.0);
-        glLineWidth(1.0);
+        _renderer.configureOpenGL();
     }
 } // namespace Glee3D
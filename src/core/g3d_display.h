@@ -28,12 +28,18 @@
 #include "g3d_framebuffer.h"
 #include "g3d_program.h"
 #include "g3d_logging.h"
+#include "g3d_renderer.h"
+#include "g3d_frameprofiler.h"
+#include "g3d_rendercounters.h"
+#include "g3d_logicthread.h"
+#include "g3d_scenesnapshot.h"
 #include "math/g3d_line3d.h"
 #include "effects/g3d_postrendereffect.h"
 
 // Qt includes
 #include <QGLWidget>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QWheelEvent>
 #include <QMouseEvent>
 #include <QMap>
@@ -50,6 +56,24 @@ namespace Glee3D {
       * @class Display
       * @author Jacob Dawid (jacob.dawid@omg-it.works)
       * @date 02.12.2012
+      *
+      * The scene logic runs on a LogicThread, which publishes a
+      * SceneSnapshot after every step. Frames are rendered from the latest
+      * snapshot without locking the scene, so a slow logic step does not
+      * stall rendering and vice versa.
+      *
+      * Frames are paced against their measured cost. After each frame, the
+      * next one is scheduled so that frames start at the target frame rate,
+      * instead of on a fixed timer that drifts against the logic and the
+      * display refresh. The cost of a frame is the larger of its CPU time and
+      * its GPU time as measured by the FrameProfiler, so the CPU never has to
+      * wait for the GPU. In benchmark mode, frames are rendered back to back
+      * and framesPerSecond() reports what is actually achievable. Note that
+      * buffer swaps may still wait for vertical sync, depending on the
+      * QGLFormat swap interval.
+      *
+      * Each frame is timed pass by pass with a FrameProfiler. Once per
+      * second, frameStatistics() reports the frames of the last second.
       */
     class Display :
         public QGLWidget,
@@ -63,6 +87,9 @@ namespace Glee3D {
          */
         Display(QWidget *parent = 0);
 
+        /** Destructor. Stops the logic thread. */
+        ~Display();
+
         /**
          * Sets the active camera for rendering the current scene.
          * @param camera The camera object.
@@ -98,10 +125,54 @@ namespace Glee3D {
         /** Constructs a point based on the information in the depth buffer. */
         Vector3D point(QPoint displayPoint);
 
+        /** @returns the number of entities drawn in the last frame. */
+        int drawnEntityCount();
+
+        /** @returns the number of entities skipped in the last frame, because
+          * they were outside of the viewing frustum. */
+        int culledEntityCount();
+
+        /** @returns the render queue entities are drawn with. */
+        RenderQueue& renderQueue();
+
+        /** @returns the renderer drawing the scene. */
+        Renderer& renderer();
+
+        /** @returns the thread running the scene logic. */
+        LogicThread& logicThread();
+
+        /** @returns the profiler timing the passes of each frame. */
+        FrameProfiler& frameProfiler();
+
+        /** @returns the OpenGL calls issued by the last frame. Calls are only
+          * counted in debug builds, release builds report zero counts.
+          * @see RenderCounters */
+        RenderCounters::Counters renderCounters();
+
+        /** Sets the frame rate frames are paced to. */
+        void setTargetFramesPerSecond(int framesPerSecond);
+
+        /** @returns the frame rate frames are paced to. */
+        int targetFramesPerSecond();
+
+        /** Sets whether frames are rendered as fast as possible. */
+        void setBenchmarkMode(bool on);
+
+        /** @returns true, if frames are rendered as fast as possible. */
+        bool benchmarkMode();
+
+        /** @returns the average cost of a frame in milliseconds, the larger of
+          * its CPU and GPU time. */
+        double averageFrameTime();
+
     signals:
         /** This signal will be emitted whenever a new fps value is available. */
         void framesPerSecond(int fps);
 
+        /** This signal will be emitted along with framesPerSecond(), holding
+          * the timings of the frames rendered since. */
+        void frameStatistics(const FrameProfiler::Statistics& statistics);
+
     protected:
         /** @overload */
         void initializeGL();
@@ -128,12 +199,9 @@ namespace Glee3D {
         void keyReleaseEvent(QKeyEvent *keyEvent);
 
     private slots:
-        /** Schedules a redraw of the displayed scene, returns immediately. */
+        /** Redraws the displayed scene. */
         void refresh();
 
-        /** Processes a logic step. */
-        void processLogic();
-
         /** Updates the current fps. */
         void updateFramesPerSecond();
 
@@ -158,14 +226,20 @@ namespace Glee3D {
         Camera *_activeCamera;
         FrameBuffer *_frameBuffer;
 
-        Program _renderProgram;
+        Renderer _renderer;
+        FrameProfiler _frameProfiler;
+        RenderCounters::Counters _renderCounters;
+        LogicThread _logicThread;
 
         QTimer _refreshTimer;
-        QTimer _logicTimer;
         QTimer _framesPerSecondTimer;
+        QElapsedTimer _frameTimer;
         QPoint _dragFrom;
         int _framesPerSecondCounter;
         int _framesPerSecond;
+        int _targetFramesPerSecond;
+        bool _benchmarkMode;
+        double _averageFrameTime;
 
         MouseMoveMode _mouseMoveMode;
 
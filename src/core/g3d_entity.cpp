@@ -20,27 +20,56 @@
 
 // Own includes
 #include "g3d_entity.h"
+#include "g3d_camera.h"
+#include "g3d_meshsimplifier.h"
+#include "g3d_compiledmeshregistry.h"
+#include "g3d_meshcompiler.h"
 
 // Qt includes
 #include <QGLWidget>
 
+// Standard includes
+#include <math.h>
+
 namespace Glee3D {
+    namespace {
+        /** Ratio of triangles kept from one level of detail to the next. */
+        const double levelOfDetailReduction = 0.5;
+
+        /** Relative margin around level thresholds that prevents popping. */
+        const double levelOfDetailHysteresis = 0.15;
+    }
+
     Entity::Entity()
         : Anchored(),
           Oriented(),
           Renderable(),
           Texturizable(),
           Serializable(),
-          Logging("Entity") {
+          Logging("Entity"),
+          _renderStateMutex(QMutex::Recursive) {
         _mesh = 0;
         _parent = 0;
         _compiledMesh = 0;
+        _compileProperties = 0;
+        _levelOfDetailCount = 1;
+        _levelOfDetail = 0;
+        _levelOfDetailThreshold = 0.25;
         _selected = false;
+        _modelMatrixDirty = true;
+        _worldMatrixDirty = true;
+        _dirtyDescendants = false;
+        _worldBoundingSphereValid = false;
     }
 
     Entity::~Entity() {
+        detach();
+        foreach(Entity *child, _children) {
+            child->_parent = 0;
+            child->invalidateWorldTransform();
+        }
         delete _mesh;
-        delete _compiledMesh;
+        releaseCompiledMeshes();
     }
 
     void Entity::setName(QString name) {
@@ -53,24 +82,38 @@ namespace Glee3D {
 
     void Entity::render(RenderMode renderMode) {
         Q_UNUSED(renderMode);
+        QMutexLocker locker(&_renderStateMutex);
         if(!_visible)
             return;
 
         if(!_compiledMesh) {
-            compile();
+            compileAsynchronously();
         }
 
-        if(_compiledMesh) {
+        CompiledMesh *compiledMesh = currentCompiledMesh();
+        if(compiledMesh) {
             if(_material) {
                 _material->activate();
             }
 
-            _compiledMesh->render();
+            compiledMesh->render();
+        }
+    }
+
+    CompiledMesh *Entity::currentCompiledMesh() {
+        QMutexLocker locker(&_renderStateMutex);
+        CompiledMesh *compiledMesh = _compiledMesh;
+        if(_levelOfDetail > 0 && _levelOfDetail <= _reducedCompiledMeshes.size()) {
+            CompiledMesh *reducedCompiledMesh = _reducedCompiledMeshes[_levelOfDetail - 1];
+            if(reducedCompiledMesh->isReady()) {
+                compiledMesh = reducedCompiledMesh;
+            }
         }
 
-        foreach(Entity* entity, _children) {
-            entity->render(renderMode);
+        if(compiledMesh && compiledMesh->isReady()) {
+            return compiledMesh;
         }
+        return 0;
     }
 
     bool Entity::selected() {
@@ -83,58 +126,323 @@ namespace Glee3D {
 
     void Entity::moveForward(double units) {
         _position += (front() * units);
+        positionChanged();
     }
 
     void Entity::moveBackward(double units) {
         _position += (- front() * units);
+        positionChanged();
     }
 
     bool Entity::collides(const Line3D& line) {
-        if(!_compiledMesh)
-            return false;
+        return worldBoundingSphere().intersects(line);
+    }
+
+    Matrix4x4 Entity::modelMatrix() {
+        if(_modelMatrixDirty) {
+            _modelMatrix = rotationMatrix().multiplicate(translationMatrix());
+            _modelMatrixDirty = false;
+        }
+        return _modelMatrix;
+    }
+
+    Matrix4x4 Entity::worldMatrix() {
+        if(_worldMatrixDirty) {
+            if(_parent) {
+                _worldMatrix = modelMatrix().multiplicate(_parent->worldMatrix());
+            } else {
+                _worldMatrix = modelMatrix();
+            }
+            _worldMatrixDirty = false;
+        }
+        return _worldMatrix;
+    }
+
+    void Entity::updateWorldTransform() {
+        // Subtrees without any dirty entity are skipped entirely.
+        if(!_worldMatrixDirty && !_dirtyDescendants) {
+            return;
+        }
+
+        // Parents come first, so worldMatrix() never has to walk up.
+        worldMatrix();
+        foreach(Entity *child, _children) {
+            child->updateWorldTransform();
+        }
+        _dirtyDescendants = false;
+    }
 
-        double area = ((_position - line._positionVector).crossProduct(line._directionVector)).length();
-        double distance = area / line._directionVector.length();
+    void Entity::positionChanged() {
+        _modelMatrixDirty = true;
+        invalidateWorldTransform();
+        markDirtyDescendants();
+    }
 
-        if(distance < _compiledMesh->collisionRadius()) {
-            return true;
+    void Entity::rotationChanged() {
+        _modelMatrixDirty = true;
+        invalidateWorldTransform();
+        markDirtyDescendants();
+    }
 
-//            for(int i = 0; i < _triangleCount; i++) {
-//                int i1 = _triangles[i]._indices[0];
-//                int i2 = _triangles[i]._indices[1];
-//                int i3 = _triangles[i]._indices[2];
+    void Entity::invalidateWorldTransform() {
+        _renderStateMutex.lock();
+        _worldBoundingSphereValid = false;
+        _renderStateMutex.unlock();
 
-//                Plane3D p(_vertices[i1], _vertices[i2], _vertices[i3]);
-//                Vector3D i = p.intersection(line);
-//                double alpha = i._x / p._directionVector1._x;
-//                double beta  = i._x / p._directionVector2._x;
+        // A dirty entity has dirty children already.
+        if(_worldMatrixDirty) {
+            return;
+        }
 
-//                if(alpha >= 0.0 && beta >= 0.0) {
-//                    if(alpha + beta < 1.0) {
-//                        return true;
-//                    }
-//                }
-//            }
+        _worldMatrixDirty = true;
+        foreach(Entity *child, _children) {
+            child->invalidateWorldTransform();
         }
-        return false;
+    }
+
+    void Entity::markDirtyDescendants() {
+        Entity *ancestor = _parent;
+        while(ancestor && !ancestor->_dirtyDescendants) {
+            ancestor->_dirtyDescendants = true;
+            ancestor = ancestor->_parent;
+        }
+    }
+
+    AxisAlignedBox Entity::worldBoundingBox() {
+        QMutexLocker locker(&_renderStateMutex);
+        if(!_compiledMesh || !_compiledMesh->isReady()) {
+            return AxisAlignedBox();
+        }
+        return _compiledMesh->boundingBox().transformed(worldMatrix());
+    }
+
+    BoundingSphere Entity::boundingSphere() {
+        QMutexLocker locker(&_renderStateMutex);
+        if(!_compiledMesh || !_compiledMesh->isReady()) {
+            return BoundingSphere();
+        }
+        return _compiledMesh->boundingSphere();
+    }
+
+    BoundingSphere Entity::worldBoundingSphere() {
+        QMutexLocker locker(&_renderStateMutex);
+        if(!_compiledMesh || !_compiledMesh->isReady()) {
+            return BoundingSphere();
+        }
+
+        // Culling asks for the sphere several times per frame.
+        if(!_worldBoundingSphereValid) {
+            _worldBoundingSphere = boundingSphere().transformed(worldMatrix());
+            _worldBoundingSphereValid = true;
+        }
+        return _worldBoundingSphere;
+    }
+
+    OrientedBox Entity::worldOrientedBox() {
+        QMutexLocker locker(&_renderStateMutex);
+        if(!_compiledMesh || !_compiledMesh->isReady()) {
+            return OrientedBox();
+        }
+        return _compiledMesh->orientedBox().transformed(worldMatrix());
+    }
+
+    bool Entity::hierarchyBoundingSphere(BoundingSphere& sphere) {
+        sphere = worldBoundingSphere();
+        if(_mesh && sphere.isEmpty()) {
+            return false;
+        }
+
+        foreach(Entity *child, _children) {
+            BoundingSphere childSphere;
+            if(!child->hierarchyBoundingSphere(childSphere)) {
+                return false;
+            }
+            sphere.extend(childSphere);
+        }
+        return true;
     }
 
     void Entity::compile() {
-        if(_compiledMesh) {
-            delete _compiledMesh;
-            _compiledMesh = 0;
+        QMutexLocker locker(&_renderStateMutex);
+        releaseCompiledMeshes();
+        if(!_mesh) {
+            return;
         }
 
-        if(_mesh) {
-            _compiledMesh = new CompiledMesh(_mesh);
+        // Entities with identical geometry share their compiled meshes.
+        CompiledMeshRegistry& registry = CompiledMeshRegistry::instance();
+        QByteArray key = CompiledMeshRegistry::contentKey(_mesh, _compileProperties);
+        _compiledMesh = registry.acquire(key);
+        if(!_compiledMesh) {
+            _compiledMesh = registry.insert(key, new CompiledMesh(_mesh, _compileProperties));
+        }
+
+        for(int level = 1; level < _levelOfDetailCount; level++) {
+            QByteArray levelKey = key + QByteArray::number(level);
+            CompiledMesh *reducedCompiledMesh = registry.acquire(levelKey);
+            if(reducedCompiledMesh) {
+                _reducedCompiledMeshes.append(reducedCompiledMesh);
+                continue;
+            }
+
+            // Build the missing levels.
+            MeshSimplifier meshSimplifier;
+            QList<Mesh*> reducedMeshes =
+                meshSimplifier.simplifyChain(_mesh, _levelOfDetailCount - 1, levelOfDetailReduction);
+            for(int i = level - 1; i < reducedMeshes.size(); i++) {
+                levelKey = key + QByteArray::number(i + 1);
+                _reducedCompiledMeshes.append(
+                    registry.insert(levelKey, new CompiledMesh(reducedMeshes[i], _compileProperties)));
+            }
+            qDeleteAll(reducedMeshes);
+            break;
         }
     }
 
+    bool Entity::isCompiled() {
+        QMutexLocker locker(&_renderStateMutex);
+        return _compiledMesh != 0;
+    }
+
+    void Entity::compileAsynchronously() {
+        QMutexLocker locker(&_renderStateMutex);
+        if(_compileProperties & CompiledMesh::StreamingCompile) {
+            // Streaming writes into mapped buffers and needs the context.
+            compile();
+            return;
+        }
+
+        releaseCompiledMeshes();
+        if(!_mesh) {
+            return;
+        }
+
+        CompiledMeshRegistry& registry = CompiledMeshRegistry::instance();
+        MeshCompiler& meshCompiler = MeshCompiler::instance();
+        QByteArray key = CompiledMeshRegistry::contentKey(_mesh, _compileProperties);
+        _compiledMesh = registry.acquire(key);
+        if(!_compiledMesh) {
+            _compiledMesh = registry.insert(key, new CompiledMesh(_compileProperties));
+            meshCompiler.schedule(_mesh, _compiledMesh);
+        }
+
+        // Levels that are already registered are shared, the missing ones
+        // are generated in a single job.
+        QList<CompiledMesh*> missingLevels;
+        bool levelsMissing = false;
+        for(int level = 1; level < _levelOfDetailCount; level++) {
+            QByteArray levelKey = key + QByteArray::number(level);
+            CompiledMesh *reducedCompiledMesh = registry.acquire(levelKey);
+            if(reducedCompiledMesh) {
+                missingLevels.append(0);
+            } else {
+                reducedCompiledMesh = registry.insert(levelKey, new CompiledMesh(_compileProperties));
+                missingLevels.append(reducedCompiledMesh);
+                levelsMissing = true;
+            }
+            _reducedCompiledMeshes.append(reducedCompiledMesh);
+        }
+
+        if(levelsMissing) {
+            meshCompiler.scheduleLevelsOfDetail(_mesh, missingLevels, levelOfDetailReduction);
+        }
+    }
+
+    void Entity::releaseCompiledMeshes() {
+        QMutexLocker locker(&_renderStateMutex);
+        CompiledMeshRegistry& registry = CompiledMeshRegistry::instance();
+        registry.release(_compiledMesh);
+        _compiledMesh = 0;
+
+        foreach(CompiledMesh *reducedCompiledMesh, _reducedCompiledMeshes) {
+            registry.release(reducedCompiledMesh);
+        }
+        _reducedCompiledMeshes.clear();
+        _levelOfDetail = 0;
+        _worldBoundingSphereValid = false;
+    }
+
+    void Entity::setCompileProperties(int properties) {
+        QMutexLocker locker(&_renderStateMutex);
+        _compileProperties = properties;
+    }
+
+    int Entity::compileProperties() {
+        QMutexLocker locker(&_renderStateMutex);
+        return _compileProperties;
+    }
+
+    void Entity::setLevelOfDetailCount(int levelCount) {
+        QMutexLocker locker(&_renderStateMutex);
+        _levelOfDetailCount = levelCount > 1 ? levelCount : 1;
+    }
+
+    int Entity::levelOfDetailCount() {
+        QMutexLocker locker(&_renderStateMutex);
+        return _levelOfDetailCount;
+    }
+
+    void Entity::setLevelOfDetailThreshold(double projectedSize) {
+        QMutexLocker locker(&_renderStateMutex);
+        _levelOfDetailThreshold = projectedSize;
+    }
+
+    double Entity::levelOfDetailThreshold() {
+        QMutexLocker locker(&_renderStateMutex);
+        return _levelOfDetailThreshold;
+    }
+
+    void Entity::updateLevelOfDetail(Camera *camera) {
+        QMutexLocker locker(&_renderStateMutex);
+        updateLevelOfDetail(camera, worldBoundingSphere());
+    }
+
+    void Entity::updateLevelOfDetail(Camera *camera, BoundingSphere sphere) {
+        QMutexLocker locker(&_renderStateMutex);
+        if(!camera || !_compiledMesh || !_compiledMesh->isReady() || _reducedCompiledMeshes.isEmpty()
+        || sphere.isEmpty()) {
+            _levelOfDetail = 0;
+            return;
+        }
+
+        double radius = sphere._radius;
+        double distance = (sphere._center - camera->position()).length();
+        if(distance <= radius) {
+            _levelOfDetail = 0;
+            return;
+        }
+
+        double halfFieldOfView = camera->fieldOfView() * M_PI / 360.0;
+        double projectedSize = radius / (distance * tan(halfFieldOfView));
+
+        // Level i is used below threshold(i). The screen area halves along
+        // with the triangle count, so thresholds shrink by sqrt(reduction).
+        int levelCount = _reducedCompiledMeshes.size() + 1;
+        double step = sqrt(levelOfDetailReduction);
+        int level = _levelOfDetail < levelCount ? _levelOfDetail : levelCount - 1;
+        while(level + 1 < levelCount
+           && projectedSize < _levelOfDetailThreshold * pow(step, level) * (1.0 - levelOfDetailHysteresis)) {
+            level++;
+        }
+        while(level > 0
+           && projectedSize > _levelOfDetailThreshold * pow(step, level - 1) * (1.0 + levelOfDetailHysteresis)) {
+            level--;
+        }
+        _levelOfDetail = level;
+    }
+
+    int Entity::levelOfDetail() {
+        QMutexLocker locker(&_renderStateMutex);
+        return _levelOfDetail;
+    }
+
     Mesh *Entity::mesh() {
+        QMutexLocker locker(&_renderStateMutex);
         return _mesh;
     }
 
     void Entity::setMesh(Mesh *mesh) {
+        QMutexLocker locker(&_renderStateMutex);
         _mesh = mesh;
     }
 
@@ -142,9 +450,27 @@ namespace Glee3D {
         if(child) {
             child->_parent = this;
             _children.append(child);
+            child->invalidateWorldTransform();
+            child->markDirtyDescendants();
+        }
+    }
+
+    void Entity::detach() {
+        if(_parent) {
+            _parent->_children.removeAll(this);
+            _parent = 0;
+            invalidateWorldTransform();
         }
     }
 
+    Entity *Entity::parent() {
+        return _parent;
+    }
+
+    QList<Entity*> Entity::children() {
+        return _children;
+    }
+
     QString Entity::className() {
         return "Entity";
     }
@@ -162,6 +488,7 @@ namespace Glee3D {
         if(_material) {
             jsonObject["material"]  = _material->serialize();
         }
+        jsonObject["position"]  = _position.serialize();
         jsonObject["rotation"]  = _rotationAnglesAroundAxis.serialize();
 
         return jsonObject;
@@ -176,24 +503,25 @@ namespace Glee3D {
         if(jsonObject.contains("name")
         && jsonObject.contains("selected")
         && jsonObject.contains("visible")
-        && jsonObject.contains("rotation")
-        && jsonObject.contains("spin")
-        && jsonObject.contains("velocity")) {
+        && jsonObject.contains("rotation")) {
             if(jsonObject["class"] == className()) {
                 _name       = jsonObject["name"].toString();
                 _selected   = jsonObject["selected"].toBool();
                 _visible    = jsonObject["visible"].toBool();
 
                 if(jsonObject.contains("mesh")) {
-                    if(_mesh) {
-                        delete _mesh;
-                    }
-                    _mesh = new Mesh();
-                    if(!_mesh->deserialize(jsonObject["mesh"].toObject())) {
-                        _deserializationError = _mesh->deserializationError();
+                    // The render thread may be compiling the current mesh.
+                    Mesh *mesh = new Mesh();
+                    if(!mesh->deserialize(jsonObject["mesh"].toObject())) {
+                        _deserializationError = mesh->deserializationError();
+                        delete mesh;
                         error("Couldn't deserialize mesh.");
                         return false;
                     }
+
+                    QMutexLocker locker(&_renderStateMutex);
+                    delete _mesh;
+                    _mesh = mesh;
                 }
 
                 if(jsonObject.contains("material")) {
@@ -205,12 +533,24 @@ namespace Glee3D {
                     }
                 }
 
+                // Older files do not store the position.
+                if(jsonObject.contains("position")) {
+                    if(!_position.deserialize(jsonObject["position"].toObject())) {
+                        _deserializationError = _position.deserializationError();
+                        return false;
+                    }
+                    positionChanged();
+                }
+
                 if(!_rotationAnglesAroundAxis.deserialize(jsonObject["rotation"].toObject())) {
                     _deserializationError = _rotationAnglesAroundAxis.deserializationError();
                     return false;
                 }
+                rotationChanged();
 
-                compile();
+                // There may be no OpenGL context yet, the entity is compiled
+                // when it is rendered for the first time.
+                releaseCompiledMeshes();
                 _deserializationError = Serializable::NoError;
                 return true;
             } else {
@@ -37,6 +37,7 @@
 // Qt includes
 #include <QHash>
 #include <QList>
+#include <QMutex>
 
 /**
  * @namespace Glee3D
@@ -44,6 +45,8 @@
  */
 namespace Glee3D {
 
+class Camera;
+
 /**
   * @class Entity
   * @author Jacob Dawid (jacob.dawid@omg-it.works)
@@ -53,6 +56,22 @@ namespace Glee3D {
   * and an orientation. It may contain an indefinite number of sub-entities,
   * which themselves are positioned and orientated relative to the entity they
   * have been assigned to.
+  *
+  * Compiled meshes are shared with all entities of identical geometry
+  * through the CompiledMeshRegistry.
+  *
+  * An entity can hold several levels of detail of its mesh, which are
+  * generated when compiling. Before rendering, the level is chosen by how
+  * large the entity appears on screen.
+  *
+  * The mesh, the compiled meshes, the level of detail and the cached world
+  * bounding sphere are used by the render thread while the logic thread
+  * changes the entity, so they are guarded by a lock of their own.
+  *
+  * The model and world matrices are cached. Changing the position or the
+  * rotation of an entity marks its world matrix and the world matrices of
+  * all subordinated entities as dirty, they are recomputed when needed or
+  * all at once by updateWorldTransform().
   */
 class Entity :
     public Anchored,
@@ -96,7 +115,9 @@ public:
       */
     void moveBackward(double units);
 
-    /** Renders this object using OpenGL commands. */
+    /** Renders this object using OpenGL commands. Subordinated entities
+      * are not rendered, they are traversed by the display so that each of
+      * them can be culled on its own. */
     virtual void render(RenderMode renderMode = Textured);
 
     /** Check whether this object collides with the given line.
@@ -105,12 +126,107 @@ public:
       */
     bool collides(const Line3D& line);
 
+    /** @returns the matrix transforming model space into the space of the
+      * parent entity. */
+    Matrix4x4 modelMatrix();
+
+    /** @returns the matrix transforming model space into world space. */
+    Matrix4x4 worldMatrix();
+
+    /** Recomputes the dirty world matrices of this entity and all of its
+      * subordinated entities, parents before children. */
+    void updateWorldTransform();
+
+    /** @returns the bounding sphere in model space. The sphere is empty
+      * until the compiled mesh is ready. */
+    BoundingSphere boundingSphere();
+
+    /** @returns the axis aligned bounding box in world space. The box is
+      * empty until the compiled mesh is ready. */
+    AxisAlignedBox worldBoundingBox();
+
+    /** @returns the bounding sphere in world space. The sphere is empty
+      * until the compiled mesh is ready. */
+    BoundingSphere worldBoundingSphere();
+
+    /** @returns the oriented bounding box in world space. The box is empty
+      * until the compiled mesh is ready. */
+    OrientedBox worldOrientedBox();
+
+    /** Determines a sphere in world space enclosing this entity and all of
+      * its subordinated entities.
+      * @param sphere Receives the sphere.
+      * @returns false, if the extent is not known yet because a mesh has not
+      * been compiled.
+      */
+    bool hierarchyBoundingSphere(BoundingSphere& sphere);
+
     /** Compiles the current object, ie. prepares the object information for
       * fast rendering. This is supposed to be called before the object will
       * be rendered. When subclassing, you may overwrite the default behaviour.
       */
     virtual void compile();
 
+    /** Compiles the current object in the background. Until the compiled
+      * mesh has been uploaded, the object is not rendered. This is what
+      * render() does when the object has not been compiled yet.
+      * @see MeshCompiler
+      */
+    void compileAsynchronously();
+
+    /** @returns true, if compiling has been started or is done. */
+    bool isCompiled();
+
+    /** Sets the properties that will be used when compiling the mesh.
+      * @param properties Compile properties.
+      * @see CompiledMesh::CompileProperties
+      */
+    void setCompileProperties(int properties);
+
+    /** @returns the properties that will be used when compiling the mesh. */
+    int compileProperties();
+
+    /** Sets the number of levels of detail generated when compiling. Each
+      * level has half the triangles of the previous one.
+      * @param levelCount Number of levels, 1 disables levels of detail.
+      */
+    void setLevelOfDetailCount(int levelCount);
+
+    /** @returns the number of levels of detail generated when compiling. */
+    int levelOfDetailCount();
+
+    /** Sets the projected size below which the first reduced level of
+      * detail is used. Further levels follow at smaller sizes.
+      * @param projectedSize Ratio of the bounding sphere diameter to the
+      * viewport height.
+      */
+    void setLevelOfDetailThreshold(double projectedSize);
+
+    /** @returns the projected size below which the first reduced level of
+      * detail is used. */
+    double levelOfDetailThreshold();
+
+    /** Chooses the level of detail for the next render from the projected
+      * size of this entity as seen by the given camera.
+      * @param camera Camera the entity will be rendered with.
+      */
+    void updateLevelOfDetail(Camera *camera);
+
+    /** Chooses the level of detail like updateLevelOfDetail(Camera*), but
+      * with the given world space bounding sphere. This is used when
+      * rendering from a SceneSnapshot.
+      * @param camera Camera the entity will be rendered with.
+      * @param sphere World space bounding sphere of the full mesh.
+      */
+    void updateLevelOfDetail(Camera *camera, BoundingSphere sphere);
+
+    /** @returns the currently used level of detail, 0 being the full mesh. */
+    int levelOfDetail();
+
+    /** @returns the compiled mesh for the current level of detail, or 0 if
+      * no compiled mesh is ready to be rendered yet. */
+    CompiledMesh *currentCompiledMesh();
+
     /** @returns the current mesh. */
     Mesh *mesh();
 
@@ -120,6 +236,15 @@ public:
     /** Subordinates the given entity as a part of this entity. */
     void subordinate(Entity *child);
 
+    /** Detaches this entity from the entity it has been subordinated to. */
+    void detach();
+
+    /** @returns the entity this entity has been subordinated to, if any. */
+    Entity *parent();
+
+    /** @returns the entities subordinated to this entity. */
+    QList<Entity*> children();
+
     /** @overload */
     virtual QString className();
 
@@ -130,15 +255,44 @@ public:
     virtual bool deserialize(QJsonObject jsonObject);
 
 protected:
+    /** Gives up the compiled meshes of this entity. */
+    void releaseCompiledMeshes();
+
+    /** @overload */
+    void positionChanged();
+
+    /** @overload */
+    void rotationChanged();
+
     QString _name;
     bool _selected;
 
     Mesh *_mesh;
     CompiledMesh *_compiledMesh;
+    int _compileProperties;
+
+    QList<CompiledMesh*> _reducedCompiledMeshes;
+    int _levelOfDetailCount;
+    int _levelOfDetail;
+    double _levelOfDetailThreshold;
 
 private:
+    void invalidateWorldTransform();
+    void markDirtyDescendants();
+
     Entity *_parent;
     QList<Entity*> _children;
+
+    Matrix4x4 _modelMatrix;
+    Matrix4x4 _worldMatrix;
+    bool _modelMatrixDirty;
+    bool _worldMatrixDirty;
+    bool _dirtyDescendants;
+    BoundingSphere _worldBoundingSphere;
+    bool _worldBoundingSphereValid;
+
+    /** Guards the render state shared with the render thread. */
+    QMutex _renderStateMutex;
 };
 
 } // namespace Glee3D
@@ -194,6 +194,23 @@ void FrameBuffer::clear() {
     glClear(GL_COLOR_BUFFER_BIT | ((_properties & DepthBuffer) ? GL_DEPTH_BUFFER_BIT : 0));
 }
 
+void FrameBuffer::readPixels(GLubyte *pixels) {
+    GLint previousFrameBuffer = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previousFrameBuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, _frameBufferObject);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, _width, _height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+    glBindFramebuffer(GL_FRAMEBUFFER, previousFrameBuffer);
+}
+
+QImage FrameBuffer::image() {
+    QImage image(_width, _height, QImage::Format_RGBA8888);
+    readPixels(image.bits());
+
+    // OpenGL stores the bottom row first.
+    return image.mirrored();
+}
+
 void FrameBuffer::setClearColor(RgbaColor color) {
     _clearColor = color;
 }
@@ -27,6 +27,7 @@
 
 // Qt includes
 #include <QGLWidget>
+#include <QImage>
 
 namespace Glee3D {
 /**
@@ -84,6 +85,16 @@ public:
     /** Clears the framebuffer object. */
     void clear();
 
+    /**
+      * Reads back the contents of the framebuffer.
+      * @param pixels Receives width() * height() pixels as 8 bit RGBA,
+      * starting with the bottom row.
+      */
+    void readPixels(GLubyte *pixels);
+
+    /** @returns a copy of the contents of the framebuffer. */
+    QImage image();
+
     /** Sets the clear color. */
     void setClearColor(RgbaColor color);
 
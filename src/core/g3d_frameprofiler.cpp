@@ -0,0 +1,375 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_frameprofiler.h"
+
+// Qt includes
+#include <QOpenGLContext>
+#include <QVector>
+
+// Standard includes
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+
+namespace Glee3D {
+    namespace {
+        /** @returns the given percentile of sorted nanoseconds in milliseconds. */
+        double percentile(const QVector<qint64>& sortedTimes, double fraction) {
+            if(sortedTimes.isEmpty()) {
+                return 0.0;
+            }
+
+            // Nearest rank.
+            int rank = (int)ceil(fraction * sortedTimes.size()) - 1;
+            rank = qBound(0, rank, sortedTimes.size() - 1);
+            return sortedTimes[rank] / 1000000.0;
+        }
+
+        void clearRecord(FrameProfiler::FrameRecord& record) {
+            record._frame = 0;
+            record._cpuFrameTime = -1;
+            record._gpuFrameTime = -1;
+            for(int pass = 0; pass < FrameProfiler::PassCount; pass++) {
+                record._cpuPassTimes[pass] = -1;
+                record._gpuPassTimes[pass] = -1;
+            }
+        }
+    }
+
+    FrameProfiler::ScopedPass::ScopedPass(FrameProfiler *frameProfiler, int pass) {
+        _frameProfiler = frameProfiler;
+        _pass = pass;
+        if(_frameProfiler) {
+            _frameProfiler->beginPass(_pass);
+        }
+    }
+
+    FrameProfiler::ScopedPass::~ScopedPass() {
+        if(_frameProfiler) {
+            _frameProfiler->endPass(_pass);
+        }
+    }
+
+    FrameProfiler::FrameProfiler()
+        : Logging("FrameProfiler") {
+        _enabled = true;
+        _gpuTimingChecked = false;
+        _gpuTimingSupported = false;
+        _frameOpen = false;
+        _activeQueryPass = -1;
+        _currentPendingFrame = 0;
+        _publishedFrameCount.store(0);
+
+        for(int pass = 0; pass < PassCount; pass++) {
+            _passStarts[pass] = 0;
+        }
+
+        for(int i = 0; i < PendingFrameCount; i++) {
+            _pendingFrames[i]._active = false;
+            for(int pass = 0; pass < PassCount; pass++) {
+                _pendingFrames[i]._queried[pass] = false;
+                _pendingFrames[i]._queries[pass] = 0;
+            }
+            clearRecord(_pendingFrames[i]._record);
+        }
+
+        for(int i = 0; i < RecordCount; i++) {
+            _ring[i]._sequence.store(0);
+            clearRecord(_ring[i]._record);
+        }
+    }
+
+    FrameProfiler::~FrameProfiler() {
+        for(int i = 0; i < PendingFrameCount; i++) {
+            if(_pendingFrames[i]._queries[0]) {
+                glDeleteQueries(PassCount, _pendingFrames[i]._queries);
+            }
+        }
+    }
+
+    void FrameProfiler::setEnabled(bool on) {
+        _enabled = on;
+    }
+
+    bool FrameProfiler::enabled() {
+        return _enabled;
+    }
+
+    QString FrameProfiler::passName(int pass) {
+        switch(pass) {
+        case SkyBoxPass: return "Skybox";
+        case LightsPass: return "Lights";
+        case TerrainPass: return "Terrain";
+        case EntitiesPass: return "Entities";
+        case TranslucentPass: return "Translucent";
+        case CopyPass: return "Copy";
+        default:
+            if(pass >= PostRenderEffectPass && pass < PassCount) {
+                return QString("Post render effect %1").arg(pass - PostRenderEffectPass + 1);
+            }
+            return QString();
+        }
+    }
+
+    void FrameProfiler::beginFrame() {
+        if(!_enabled) {
+            return;
+        }
+
+        if(!_gpuTimingChecked) {
+            QOpenGLContext *context = QOpenGLContext::currentContext();
+            if(context) {
+                QSurfaceFormat format = context->format();
+                _gpuTimingSupported = context->hasExtension("GL_ARB_timer_query")
+                        || format.majorVersion() > 3
+                        || (format.majorVersion() == 3 && format.minorVersion() >= 3);
+                _gpuTimingChecked = true;
+                if(!_gpuTimingSupported) {
+                    information("Timer queries are not supported, measuring the CPU only.");
+                }
+            }
+        }
+
+        collectFinishedFrames();
+
+        // If the GPU is that far behind, give up waiting for the oldest frame.
+        _currentPendingFrame = (_currentPendingFrame + 1) % PendingFrameCount;
+        PendingFrame& pendingFrame = _pendingFrames[_currentPendingFrame];
+        if(pendingFrame._active) {
+            collect(pendingFrame, true);
+        }
+
+        if(_gpuTimingSupported && !pendingFrame._queries[0]) {
+            glGenQueries(PassCount, pendingFrame._queries);
+        }
+
+        for(int pass = 0; pass < PassCount; pass++) {
+            pendingFrame._queried[pass] = false;
+        }
+        clearRecord(pendingFrame._record);
+        _activeQueryPass = -1;
+        _frameOpen = true;
+        _frameTimer.start();
+    }
+
+    void FrameProfiler::endFrame() {
+        if(!_frameOpen) {
+            return;
+        }
+
+        if(_activeQueryPass >= 0) {
+            glEndQuery(GL_TIME_ELAPSED);
+            _activeQueryPass = -1;
+        }
+
+        PendingFrame& pendingFrame = _pendingFrames[_currentPendingFrame];
+        pendingFrame._record._cpuFrameTime = _frameTimer.nsecsElapsed();
+        pendingFrame._active = true;
+        _frameOpen = false;
+    }
+
+    void FrameProfiler::beginPass(int pass) {
+        if(!_frameOpen) {
+            return;
+        }
+
+        pass = clampPass(pass);
+        _passStarts[pass] = _frameTimer.nsecsElapsed();
+
+        PendingFrame& pendingFrame = _pendingFrames[_currentPendingFrame];
+        if(_gpuTimingSupported && _activeQueryPass < 0 && !pendingFrame._queried[pass]) {
+            glBeginQuery(GL_TIME_ELAPSED, pendingFrame._queries[pass]);
+            _activeQueryPass = pass;
+        }
+    }
+
+    void FrameProfiler::endPass(int pass) {
+        if(!_frameOpen) {
+            return;
+        }
+
+        pass = clampPass(pass);
+        PendingFrame& pendingFrame = _pendingFrames[_currentPendingFrame];
+        qint64& cpuPassTime = pendingFrame._record._cpuPassTimes[pass];
+        cpuPassTime = qMax((qint64)0, cpuPassTime) + _frameTimer.nsecsElapsed() - _passStarts[pass];
+
+        if(_activeQueryPass == pass) {
+            glEndQuery(GL_TIME_ELAPSED);
+            pendingFrame._queried[pass] = true;
+            _activeQueryPass = -1;
+        }
+    }
+
+    quint64 FrameProfiler::publishedFrameCount() {
+        return _publishedFrameCount.loadAcquire();
+    }
+
+    bool FrameProfiler::record(int age, FrameRecord& record) {
+        // Readers retry if the writer got in the way.
+        for(int attempt = 0; attempt < 4; attempt++) {
+            quint64 count = _publishedFrameCount.loadAcquire();
+            if(age < 0 || age >= RecordCount || (quint64)age >= count) {
+                return false;
+            }
+
+            quint64 frame = count - 1 - age;
+            Slot& slot = _ring[frame % RecordCount];
+            int sequence = slot._sequence.loadAcquire();
+            if(sequence & 1) {
+                continue;
+            }
+
+            record = slot._record;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot._sequence.load() == sequence && record._frame == frame) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    FrameProfiler::Statistics FrameProfiler::statistics(int frameCount) {
+        Statistics statistics;
+        statistics._frameCount = 0;
+        statistics._averageCpuFrameTime = 0.0;
+        statistics._averageGpuFrameTime = 0.0;
+
+        double cpuPassTotals[PassCount];
+        double gpuPassTotals[PassCount];
+        int cpuPassCounts[PassCount];
+        int gpuPassCounts[PassCount];
+        for(int pass = 0; pass < PassCount; pass++) {
+            cpuPassTotals[pass] = gpuPassTotals[pass] = 0.0;
+            cpuPassCounts[pass] = gpuPassCounts[pass] = 0;
+        }
+
+        QVector<qint64> cpuFrameTimes;
+        QVector<qint64> gpuFrameTimes;
+        frameCount = qMin(frameCount, (int)RecordCount);
+        FrameRecord frameRecord;
+        for(int age = 0; age < frameCount && record(age, frameRecord); age++) {
+            cpuFrameTimes.append(frameRecord._cpuFrameTime);
+            if(frameRecord._gpuFrameTime >= 0) {
+                gpuFrameTimes.append(frameRecord._gpuFrameTime);
+            }
+            for(int pass = 0; pass < PassCount; pass++) {
+                if(frameRecord._cpuPassTimes[pass] >= 0) {
+                    cpuPassTotals[pass] += frameRecord._cpuPassTimes[pass];
+                    cpuPassCounts[pass]++;
+                }
+                if(frameRecord._gpuPassTimes[pass] >= 0) {
+                    gpuPassTotals[pass] += frameRecord._gpuPassTimes[pass];
+                    gpuPassCounts[pass]++;
+                }
+            }
+        }
+
+        statistics._frameCount = cpuFrameTimes.size();
+        for(int pass = 0; pass < PassCount; pass++) {
+            statistics._averageCpuPassTimes[pass] = cpuPassCounts[pass] ? cpuPassTotals[pass] / cpuPassCounts[pass] / 1000000.0 : 0.0;
+            statistics._averageGpuPassTimes[pass] = gpuPassCounts[pass] ? gpuPassTotals[pass] / gpuPassCounts[pass] / 1000000.0 : 0.0;
+        }
+
+        double total = 0.0;
+        foreach(qint64 time, cpuFrameTimes) {
+            total += time;
+        }
+        if(!cpuFrameTimes.isEmpty()) {
+            statistics._averageCpuFrameTime = total / cpuFrameTimes.size() / 1000000.0;
+        }
+
+        total = 0.0;
+        foreach(qint64 time, gpuFrameTimes) {
+            total += time;
+        }
+        if(!gpuFrameTimes.isEmpty()) {
+            statistics._averageGpuFrameTime = total / gpuFrameTimes.size() / 1000000.0;
+        }
+
+        std::sort(cpuFrameTimes.begin(), cpuFrameTimes.end());
+        std::sort(gpuFrameTimes.begin(), gpuFrameTimes.end());
+        statistics._cpuFrameTimeP50 = percentile(cpuFrameTimes, 0.50);
+        statistics._cpuFrameTimeP95 = percentile(cpuFrameTimes, 0.95);
+        statistics._cpuFrameTimeP99 = percentile(cpuFrameTimes, 0.99);
+        statistics._gpuFrameTimeP50 = percentile(gpuFrameTimes, 0.50);
+        statistics._gpuFrameTimeP95 = percentile(gpuFrameTimes, 0.95);
+        statistics._gpuFrameTimeP99 = percentile(gpuFrameTimes, 0.99);
+        return statistics;
+    }
+
+    void FrameProfiler::collectFinishedFrames() {
+        // Frames are published in order, so stop at the first one that is
+        // still waiting for the GPU.
+        for(int i = 1; i <= PendingFrameCount; i++) {
+            PendingFrame& pendingFrame = _pendingFrames[(_currentPendingFrame + i) % PendingFrameCount];
+            if(pendingFrame._active && !collect(pendingFrame, false)) {
+                return;
+            }
+        }
+    }
+
+    bool FrameProfiler::collect(PendingFrame& pendingFrame, bool force) {
+        bool available[PassCount];
+        for(int pass = 0; pass < PassCount; pass++) {
+            available[pass] = false;
+            if(pendingFrame._queried[pass]) {
+                GLuint result = 0;
+                glGetQueryObjectuiv(pendingFrame._queries[pass], GL_QUERY_RESULT_AVAILABLE, &result);
+                available[pass] = (result != 0);
+                if(!available[pass] && !force) {
+                    return false;
+                }
+            }
+        }
+
+        FrameRecord& record = pendingFrame._record;
+        for(int pass = 0; pass < PassCount; pass++) {
+            if(available[pass]) {
+                GLuint64 nanoseconds = 0;
+                glGetQueryObjectui64v(pendingFrame._queries[pass], GL_QUERY_RESULT, &nanoseconds);
+                record._gpuPassTimes[pass] = (qint64)nanoseconds;
+                record._gpuFrameTime = qMax((qint64)0, record._gpuFrameTime) + (qint64)nanoseconds;
+            }
+        }
+
+        publish(record);
+        pendingFrame._active = false;
+        return true;
+    }
+
+    void FrameProfiler::publish(FrameRecord& record) {
+        // Only the render thread writes, so the count can be read plainly.
+        // An odd sequence tells readers that the slot is being written.
+        quint64 frame = _publishedFrameCount.load();
+        record._frame = frame;
+        Slot& slot = _ring[frame % RecordCount];
+        slot._sequence.fetchAndAddOrdered(1);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot._record = record;
+        slot._sequence.fetchAndAddOrdered(1);
+        _publishedFrameCount.storeRelease(frame + 1);
+    }
+
+    int FrameProfiler::clampPass(int pass) {
+        return qBound(0, pass, (int)PassCount - 1);
+    }
+} // namespace Glee3D
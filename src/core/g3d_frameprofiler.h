@@ -0,0 +1,194 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_FRAMEPROFILER_H
+#define G3D_FRAMEPROFILER_H
+
+// Own includes
+#include "g3d_logging.h"
+
+// Qt includes
+#include <QGLWidget>
+#include <QElapsedTimer>
+#include <QAtomicInt>
+#include <QString>
+#include <QMetaType>
+
+namespace Glee3D {
+    /**
+      * @class FrameProfiler
+      * Measures how long each pass of a frame takes on the CPU and, where
+      * timer queries are supported, on the GPU. Passes are wrapped in
+      * beginPass() and endPass(), or more conveniently in a ScopedPass.
+      *
+      * GPU results arrive a few frames late, so a frame is published once
+      * its queries are available. Published frames are kept in a ring of
+      * the last RecordCount frames. The render thread is the only writer,
+      * any other thread may read records and statistics without locking.
+      *
+      * Timer queries cannot overlap, so the GPU frame time is the sum of the
+      * measured passes and nested passes are only timed on the CPU. A pass
+      * measured twice in a frame adds up on the CPU, but only its first
+      * occurrence is timed on the GPU, so separate parts of a frame should
+      * be measured as separate passes.
+      */
+    class FrameProfiler :
+        public Logging {
+    public:
+        /**
+          * @enum Pass
+          * Passes of a frame. Post render effects are counted from
+          * PostRenderEffectPass on, effects beyond the last slot share it.
+          */
+        enum Pass {
+            SkyBoxPass,
+            LightsPass,
+            TerrainPass,
+            EntitiesPass,
+            TranslucentPass,
+            CopyPass,
+            PostRenderEffectPass,
+            PassCount = PostRenderEffectPass + 8
+        };
+
+        /** Number of frames kept. */
+        enum { RecordCount = 256 };
+
+        /** Timings of a single frame in nanoseconds, -1 if not measured. */
+        struct FrameRecord {
+            quint64 _frame;
+            qint64 _cpuFrameTime;
+            qint64 _gpuFrameTime;
+            qint64 _cpuPassTimes[PassCount];
+            qint64 _gpuPassTimes[PassCount];
+        };
+
+        /** Timings over several frames in milliseconds. */
+        struct Statistics {
+            int _frameCount;
+            double _averageCpuFrameTime;
+            double _averageGpuFrameTime;
+            double _cpuFrameTimeP50;
+            double _cpuFrameTimeP95;
+            double _cpuFrameTimeP99;
+            double _gpuFrameTimeP50;
+            double _gpuFrameTimeP95;
+            double _gpuFrameTimeP99;
+            double _averageCpuPassTimes[PassCount];
+            double _averageGpuPassTimes[PassCount];
+        };
+
+        /**
+          * @class ScopedPass
+          * Measures a pass from construction until destruction. Does nothing
+          * if the profiler is null.
+          */
+        class ScopedPass {
+        public:
+            ScopedPass(FrameProfiler *frameProfiler, int pass);
+            ~ScopedPass();
+
+        private:
+            FrameProfiler *_frameProfiler;
+            int _pass;
+        };
+
+        /** Creates a new, enabled frame profiler. */
+        FrameProfiler();
+
+        /** Destructor. Needs the OpenGL context current if queries were made. */
+        ~FrameProfiler();
+
+        /** Sets whether frames are measured. */
+        void setEnabled(bool on);
+
+        /** @returns true, if frames are measured. */
+        bool enabled();
+
+        /** @returns a readable name for the given pass. */
+        static QString passName(int pass);
+
+        /** Starts measuring a frame. Call with the OpenGL context current. */
+        void beginFrame();
+
+        /** Finishes measuring the current frame. */
+        void endFrame();
+
+        /** Starts measuring the given pass of the current frame. */
+        void beginPass(int pass);
+
+        /** Finishes measuring the given pass of the current frame. */
+        void endPass(int pass);
+
+        /** @returns the number of frames published so far. */
+        quint64 publishedFrameCount();
+
+        /**
+         * Reads a published frame.
+         * @param age 0 for the latest frame, 1 for the one before and so on.
+         * @param record Receives the frame.
+         * @returns false, if the frame is not available (anymore).
+         */
+        bool record(int age, FrameRecord& record);
+
+        /** @returns statistics over the given number of latest frames. */
+        Statistics statistics(int frameCount = RecordCount);
+
+    private:
+        /** Frames stay pending for up to this many frames until their GPU
+          * results are available. */
+        enum { PendingFrameCount = 4 };
+
+        struct PendingFrame {
+            bool _active;
+            bool _queried[PassCount];
+            GLuint _queries[PassCount];
+            FrameRecord _record;
+        };
+
+        struct Slot {
+            QAtomicInt _sequence;
+            FrameRecord _record;
+        };
+
+        void collectFinishedFrames();
+        bool collect(PendingFrame& pendingFrame, bool force);
+        void publish(FrameRecord& record);
+        int clampPass(int pass);
+
+        bool _enabled;
+        bool _gpuTimingChecked;
+        bool _gpuTimingSupported;
+        bool _frameOpen;
+        int _activeQueryPass;
+
+        QElapsedTimer _frameTimer;
+        qint64 _passStarts[PassCount];
+        PendingFrame _pendingFrames[PendingFrameCount];
+        int _currentPendingFrame;
+
+        Slot _ring[RecordCount];
+        QAtomicInteger<quint64> _publishedFrameCount;
+    };
+} // namespace Glee3D
+
+Q_DECLARE_METATYPE(Glee3D::FrameProfiler::Statistics)
+
+#endif // G3D_FRAMEPROFILER_H
@@ -0,0 +1,103 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_heightmap.h"
+
+namespace Glee3D {
+    Heightmap::Heightmap()
+        : Logging("Heightmap") {
+        _data = 0;
+        _width = 0;
+        _height = 0;
+    }
+
+    Heightmap::~Heightmap() {
+        unmap();
+    }
+
+    bool Heightmap::map(QString fileName, int width, int height) {
+        unmap();
+
+        if(width < 2 || height < 2) {
+            error(QString("Invalid heightmap size: %1x%2").arg(width).arg(height));
+            return false;
+        }
+
+        _file.setFileName(fileName);
+        if(!_file.open(QIODevice::ReadOnly)) {
+            error(QString("Could not open heightmap %1: %2").arg(fileName).arg(_file.errorString()));
+            return false;
+        }
+
+        qint64 size = (qint64)width * height * 2;
+        if(_file.size() != size) {
+            error(QString("Heightmap %1 has %2 bytes, expected %3.").arg(fileName).arg(_file.size()).arg(size));
+            _file.close();
+            return false;
+        }
+
+        _data = _file.map(0, size);
+        if(!_data) {
+            error(QString("Could not map heightmap %1: %2").arg(fileName).arg(_file.errorString()));
+            _file.close();
+            return false;
+        }
+
+        _width = width;
+        _height = height;
+        return true;
+    }
+
+    void Heightmap::unmap() {
+        if(_data) {
+            _file.unmap((uchar*)_data);
+            _data = 0;
+        }
+        if(_file.isOpen()) {
+            _file.close();
+        }
+        _width = 0;
+        _height = 0;
+    }
+
+    bool Heightmap::isMapped() const {
+        return _data != 0;
+    }
+
+    int Heightmap::width() const {
+        return _width;
+    }
+
+    int Heightmap::height() const {
+        return _height;
+    }
+
+    void Heightmap::read(int x, int y, int width, int height, float *heights) const {
+        for(int row = 0; row < height; row++) {
+            const uchar *source = _data + ((qint64)(y + row) * _width + x) * 2;
+            for(int column = 0; column < width; column++) {
+                int value = source[0] | (source[1] << 8);
+                *heights++ = (float)(value - 32768) / 256.0f;
+                source += 2;
+            }
+        }
+    }
+} // namespace Glee3D
@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_HEIGHTMAP_H
+#define G3D_HEIGHTMAP_H
+
+// Own includes
+#include "g3d_logging.h"
+
+// Qt includes
+#include <QString>
+#include <QFile>
+
+namespace Glee3D {
+    /**
+      * @class Heightmap
+      * A raw heightmap file mapped into memory. The file holds unsigned
+      * 16 bit little endian heights, row by row, without any header.
+      * Only the parts that are read are paged in by the operating system,
+      * so the file may be much larger than the available memory.
+      *
+      * Heights are converted to the range of 8 bit heightmap images. A
+      * value v is the height (v - 32768) / 256, so 256 times the image value
+      * b gives b - 128, exactly the height Terrain::generate() decodes from
+      * the image. Scaling an 8 bit heightmap by 256 therefore yields the same
+      * terrain, with 256 finer steps between image values.
+      */
+    class Heightmap : public Logging {
+    public:
+        Heightmap();
+        virtual ~Heightmap();
+
+        /**
+         * Maps the given file into memory.
+         * @param fileName Path to the raw heightmap.
+         * @param width Number of heights per row.
+         * @param height Number of rows.
+         * @returns true on success, false if the file could not be mapped
+         * or its size does not match the given dimensions.
+         */
+        bool map(QString fileName, int width, int height);
+
+        /** Unmaps the file. */
+        void unmap();
+
+        /** @returns true, if a file is mapped. */
+        bool isMapped() const;
+
+        /** @returns the number of heights per row. */
+        int width() const;
+
+        /** @returns the number of rows. */
+        int height() const;
+
+        /**
+         * Copies a region of the heightmap. This may be called from any
+         * thread while the file is mapped.
+         * @param x First column of the region.
+         * @param y First row of the region.
+         * @param width Number of columns of the region.
+         * @param height Number of rows of the region.
+         * @param heights Receives width times height heights in row-major
+         * order.
+         */
+        void read(int x, int y, int width, int height, float *heights) const;
+
+    private:
+        QFile _file;
+        const uchar *_data;
+        int _width;
+        int _height;
+    };
+} // namespace Glee3D
+
+#endif // G3D_HEIGHTMAP_H
@@ -20,6 +20,7 @@
 
 // Own includes
 #include "g3d_lightsource.h"
+#include "g3d_rendercounters.h"
 
 namespace Glee3D {
     LightSource::LightSource()
@@ -66,6 +67,7 @@ namespace Glee3D {
                                (GLfloat)_position.z(),
                                1.0f };
         glLightfv(glLight, GL_POSITION, position);
+        G3D_COUNT_LIGHT_CALLS(4);
 
         switch(_lightSourceType) {
             case Punctual: {
@@ -79,6 +81,7 @@ namespace Glee3D {
                 glLightfv(glLight, GL_SPOT_DIRECTION, spotDirection);
                 glLightf(glLight, GL_SPOT_CUTOFF, _spotCutoff);
                 glLightf(glLight, GL_SPOT_EXPONENT, _spotExponent);
+                G3D_COUNT_LIGHT_CALLS(3);
             } break;
         }
 
@@ -150,6 +153,7 @@ namespace Glee3D {
         jsonObject["class"] = className();
 
         jsonObject["switchedOn"] = _switchedOn;
+        jsonObject["position"] = _position.serialize();
         jsonObject["ambientLight"] = _ambientLight.serialize();
         jsonObject["diffuseLight"] = _diffuseLight.serialize();
         jsonObject["specularLight"] = _specularLight.serialize();
@@ -182,6 +186,13 @@ namespace Glee3D {
             if(jsonObject["class"] == className()) {
                 _switchedOn = jsonObject["switchedOn"].toBool();
 
+                // Older files do not store the position.
+                if(jsonObject.contains("position")
+                && !_position.deserialize(jsonObject.value("position").toObject())) {
+                    _deserializationError = _position.deserializationError();
+                    return false;
+                }
+
                 if(!_ambientLight.deserialize(jsonObject.value("ambientLight").toObject())) {
                     _deserializationError = _ambientLight.deserializationError();
                     return false;
@@ -0,0 +1,166 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_logicthread.h"
+#include "g3d_scene.h"
+#include "g3d_camera.h"
+
+// Qt includes
+#include <QMutexLocker>
+
+namespace Glee3D {
+    namespace {
+        /** After a stall, at most this many steps are run to catch up. The
+          * rest of the lost time is dropped, so that slow steps cannot make
+          * the logic fall further and further behind. */
+        const int maximumCatchUpSteps = 5;
+    }
+
+    LogicThread::LogicThread(QObject *parent)
+        : QThread(parent),
+          Logging("LogicThread") {
+        _scene = 0;
+        _camera = 0;
+        _interval = 20;
+        _interpolationEnabled = true;
+        _tick = 0;
+        _latestSnapshotTime = 0;
+        _clock.start();
+    }
+
+    LogicThread::~LogicThread() {
+        stop();
+    }
+
+    void LogicThread::setScene(Scene *scene) {
+        QMutexLocker locker(&_mutex);
+        _scene = scene;
+        _previousSnapshot.clear();
+        _latestSnapshot.clear();
+    }
+
+    void LogicThread::setCamera(Camera *camera) {
+        QMutexLocker locker(&_mutex);
+        _camera = camera;
+    }
+
+    void LogicThread::setKeyStatusMap(QMap<int, bool> keyStatusMap) {
+        QMutexLocker locker(&_mutex);
+        _keyStatusMap = keyStatusMap;
+    }
+
+    void LogicThread::setInterval(int milliseconds) {
+        QMutexLocker locker(&_mutex);
+        _interval = milliseconds;
+    }
+
+    int LogicThread::interval() {
+        QMutexLocker locker(&_mutex);
+        return _interval;
+    }
+
+    void LogicThread::setInterpolationEnabled(bool on) {
+        QMutexLocker locker(&_mutex);
+        _interpolationEnabled = on;
+    }
+
+    bool LogicThread::interpolationEnabled() {
+        QMutexLocker locker(&_mutex);
+        return _interpolationEnabled;
+    }
+
+    QSharedPointer<SceneSnapshot> LogicThread::latestSnapshot() {
+        QMutexLocker locker(&_mutex);
+        return _latestSnapshot;
+    }
+
+    QSharedPointer<SceneSnapshot> LogicThread::renderSnapshot() {
+        _mutex.lock();
+        QSharedPointer<SceneSnapshot> previous = _previousSnapshot;
+        QSharedPointer<SceneSnapshot> latest = _latestSnapshot;
+        qint64 latestTime = _latestSnapshotTime;
+        qint64 interval = (qint64)_interval * 1000000;
+        bool interpolationEnabled = _interpolationEnabled;
+        _mutex.unlock();
+
+        if(!interpolationEnabled || !previous || !latest || interval <= 0) {
+            return latest;
+        }
+
+        double factor = (double)(_clock.nsecsElapsed() - latestTime) / (double)interval;
+        if(factor >= 1.0) {
+            return latest;
+        }
+        return QSharedPointer<SceneSnapshot>(SceneSnapshot::interpolate(*previous, *latest, qMax(0.0, factor)));
+    }
+
+    void LogicThread::stop() {
+        if(isRunning()) {
+            requestInterruption();
+            wait();
+        }
+    }
+
+    void LogicThread::run() {
+        qint64 accumulator = 0;
+        qint64 previousTime = _clock.nsecsElapsed();
+        while(!isInterruptionRequested()) {
+            qint64 time = _clock.nsecsElapsed();
+            accumulator += time - previousTime;
+            previousTime = time;
+
+            qint64 timestep = (qint64)qMax(1, interval()) * 1000000;
+            accumulator = qMin(accumulator, timestep * maximumCatchUpSteps);
+            while(accumulator >= timestep) {
+                step();
+                accumulator -= timestep;
+            }
+
+            msleep((unsigned long)((timestep - accumulator) / 1000000));
+        }
+    }
+
+    void LogicThread::step() {
+        _mutex.lock();
+        Scene *scene = _scene;
+        Camera *camera = _camera;
+        QMap<int, bool> keyStatusMap = _keyStatusMap;
+        _mutex.unlock();
+
+        if(!scene) {
+            return;
+        }
+
+        scene->lockScene();
+        scene->processLogic(keyStatusMap, camera);
+        QSharedPointer<SceneSnapshot> snapshot(SceneSnapshot::capture(scene, camera, ++_tick));
+        scene->unlockScene();
+
+        // The previous snapshot is freed as soon as the render thread is
+        // done with it.
+        QMutexLocker locker(&_mutex);
+        if(_scene == scene) {
+            _previousSnapshot = _latestSnapshot;
+            _latestSnapshot = snapshot;
+            _latestSnapshotTime = _clock.nsecsElapsed();
+        }
+    }
+} // namespace Glee3D
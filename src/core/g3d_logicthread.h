@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_LOGICTHREAD_H
+#define G3D_LOGICTHREAD_H
+
+// Own includes
+#include "g3d_logging.h"
+#include "g3d_scenesnapshot.h"
+
+// Qt includes
+#include <QThread>
+#include <QMutex>
+#include <QMap>
+#include <QSharedPointer>
+#include <QElapsedTimer>
+
+namespace Glee3D {
+    class Scene;
+    class Camera;
+
+    /**
+      * @class LogicThread
+      * Runs the logic of a scene on its own thread. After each logic step,
+      * the thread captures a SceneSnapshot while still holding the scene
+      * lock and publishes it. The render thread picks up the latest snapshot
+      * and never has to wait for the logic step to finish.
+      *
+      * Logic steps advance the scene by a fixed timestep. Elapsed time is
+      * accumulated and as many steps are run as fit into it, so the
+      * simulation keeps its pace no matter how long a single step takes.
+      * For rendering, renderSnapshot() blends the two latest snapshots
+      * according to the time left in the accumulator. This shows the scene
+      * one step late, but moves smoothly at any frame rate.
+      *
+      * The logic thread owns the transforms, materials, visibility and the
+      * hierarchy of all entities. Compiled meshes and levels of detail are
+      * used by both threads and guarded by each entity. Objects removed
+      * with Scene::destroy() are deleted by the render thread after a frame,
+      * once neither the retained snapshots nor a frame being rendered
+      * reference them.
+      * Anything else touching the scene from another thread has to hold the
+      * scene lock.
+      */
+    class LogicThread :
+        public QThread,
+        public Logging {
+    public:
+        /** Creates a new logic thread, that has to be started. */
+        LogicThread(QObject *parent = 0);
+
+        /** Destructor. Stops the thread. */
+        ~LogicThread();
+
+        /** Sets the scene to process, may be 0. */
+        void setScene(Scene *scene);
+
+        /** Sets the camera passed to the scene logic, may be 0. */
+        void setCamera(Camera *camera);
+
+        /** Sets the key states passed to the scene logic. */
+        void setKeyStatusMap(QMap<int, bool> keyStatusMap);
+
+        /** Sets the fixed timestep of the logic in milliseconds. */
+        void setInterval(int milliseconds);
+
+        /** @returns the fixed timestep of the logic in milliseconds. */
+        int interval();
+
+        /** Sets whether renderSnapshot() blends consecutive snapshots. */
+        void setInterpolationEnabled(bool on);
+
+        /** @returns true, if renderSnapshot() blends consecutive snapshots. */
+        bool interpolationEnabled();
+
+        /** @returns the latest published snapshot, which may be null. */
+        QSharedPointer<SceneSnapshot> latestSnapshot();
+
+        /**
+         * @returns the snapshot to render right now, which may be null. With
+         * interpolation enabled, this is a blend of the two latest snapshots,
+         * otherwise it is the latest snapshot.
+         */
+        QSharedPointer<SceneSnapshot> renderSnapshot();
+
+        /** Requests the thread to stop and waits until it has finished. */
+        void stop();
+
+    protected:
+        /** @overload */
+        void run();
+
+    private:
+        /** Runs a single logic step and publishes its snapshot. */
+        void step();
+
+        QMutex _mutex;
+        QElapsedTimer _clock;
+        Scene *_scene;
+        Camera *_camera;
+        QMap<int, bool> _keyStatusMap;
+        int _interval;
+        bool _interpolationEnabled;
+        quint64 _tick;
+        qint64 _latestSnapshotTime;
+        QSharedPointer<SceneSnapshot> _previousSnapshot;
+        QSharedPointer<SceneSnapshot> _latestSnapshot;
+    };
+} // namespace Glee3D
+
+#endif // G3D_LOGICTHREAD_H
@@ -22,6 +22,7 @@
 #include "g3d_display.h"
 #include "g3d_material.h"
 #include "g3d_texturestore.h"
+#include "g3d_rendercounters.h"
 
 // Qt includes
 #include <QGLWidget>
@@ -156,6 +157,11 @@ namespace Glee3D {
     }
 
     void Material::activate() {
+        activateColors();
+        TextureStore::instance().activateTexture(_textureId);
+    }
+
+    void Material::activateColors() {
         float ambientReflection[]
                 = { _ambientReflection._red,
                     _ambientReflection._green,
@@ -184,8 +190,26 @@ namespace Glee3D {
                     _emission._blue,
                     _emission._alpha };
         glMaterialfv(GL_FRONT, GL_EMISSION, emission);
+        G3D_COUNT_MATERIAL_CALLS(5);
+    }
 
-        TextureStore::instance().activateTexture(_textureId);
+    bool Material::isTranslucent() {
+        return _diffuseReflection._alpha < 1.0;
+    }
+
+    QByteArray Material::appearanceKey() {
+        float values[] = {
+            _ambientReflection._red, _ambientReflection._green,
+            _ambientReflection._blue, _ambientReflection._alpha,
+            _diffuseReflection._red, _diffuseReflection._green,
+            _diffuseReflection._blue, _diffuseReflection._alpha,
+            _specularReflection._red, _specularReflection._green,
+            _specularReflection._blue, _specularReflection._alpha,
+            _shininess
+        };
+        QByteArray key((const char*)values, sizeof(values));
+        key.append(_textureId.toUtf8());
+        return key;
     }
 
     RgbaColor Material::ambientReflection() {
@@ -28,6 +28,7 @@
 
 // Qt includes
 #include <QString>
+#include <QByteArray>
 
 namespace Glee3D {
     /**
@@ -71,6 +72,17 @@ namespace Glee3D {
         /** Activates this material. */
         void activate();
 
+        /** Activates the reflection and emission colors of this material,
+          * without touching the texture. */
+        void activateColors();
+
+        /** @returns true, if this material is partially transparent. */
+        bool isTranslucent();
+
+        /** @returns a key that is equal for all materials that look the
+          * same apart from their emission. */
+        QByteArray appearanceKey();
+
         /** @returns Color of the ambient reflection. */
         RgbaColor ambientReflection();
 
@@ -80,6 +80,14 @@ namespace Glee3D {
         return _textureCoordinates[index];
     }
 
+    int Mesh::vertexCount() {
+        return _vertexCount;
+    }
+
+    int Mesh::triangleCount() {
+        return _triangleCount;
+    }
+
     QString Mesh::className() {
         return "Mesh";
     }
@@ -98,6 +98,8 @@ class Mesh
     : public Serializable,
       public Logging {
 friend class CompiledMesh;
+friend class NormalBuilder;
+friend class MeshOptimizer;
 public:
     /**
       * Creates a new mesh.
@@ -150,6 +152,12 @@ public:
     /** @returns the texture coordinates of the specified index. */
     Vector2D textureCoordinates(int index);
 
+    /** @returns the number of vertices. */
+    int vertexCount();
+
+    /** @returns the number of triangles. */
+    int triangleCount();
+
     /** @overload */
     QString className();
 
@@ -0,0 +1,286 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_meshcompiler.h"
+#include "g3d_compiledmesh.h"
+#include "g3d_meshsimplifier.h"
+
+// Qt includes
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QOpenGLContext>
+
+namespace Glee3D {
+
+namespace {
+    Mesh *copyMesh(Mesh *mesh) {
+        Mesh *copy = new Mesh(mesh->vertexCount(), mesh->triangleCount());
+        for(int i = 0; i < mesh->vertexCount(); i++) {
+            copy->setVertex(i, mesh->vertex(i));
+            copy->setTextureCoordinates(i, mesh->textureCoordinates(i));
+        }
+        for(int i = 0; i < mesh->triangleCount(); i++) {
+            copy->setTriangle(i, mesh->triangle(i));
+        }
+        return copy;
+    }
+}
+
+/**
+  * A mesh compiled on the thread pool. Targets are set to null when they
+  * are cancelled, which is guarded by the mutex of the compiler.
+  */
+class MeshCompiler::Job : public QRunnable {
+public:
+    enum State {
+        Queued,
+        Running,
+        Finished,
+        Uploading
+    };
+
+    Job(MeshCompiler *compiler,
+        QOpenGLContext *context,
+        Mesh *mesh,
+        QList<CompiledMesh*> targets,
+        bool levelsOfDetail,
+        double reduction) {
+        _compiler = compiler;
+        _context = context;
+        _mesh = mesh;
+        _targets = targets;
+        _levelsOfDetail = levelsOfDetail;
+        _reduction = reduction;
+        _state = Queued;
+        setAutoDelete(false);
+    }
+
+    ~Job() {
+        delete _mesh;
+    }
+
+    bool hasTargets() {
+        foreach(CompiledMesh *target, _targets) {
+            if(target) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run() {
+        {
+            QMutexLocker locker(&_compiler->_mutex);
+            if(!hasTargets()) {
+                locker.unlock();
+                _compiler->finished(this);
+                return;
+            }
+            _state = Running;
+        }
+
+        // Targets cannot be cancelled while we are running.
+        if(_levelsOfDetail) {
+            MeshSimplifier meshSimplifier;
+            QList<Mesh*> reducedMeshes = meshSimplifier.simplifyChain(_mesh, _targets.size(), _reduction);
+            for(int i = 0; i < _targets.size(); i++) {
+                Mesh *source = _mesh;
+                if(!reducedMeshes.isEmpty()) {
+                    source = reducedMeshes[i < reducedMeshes.size() ? i : reducedMeshes.size() - 1];
+                }
+                if(_targets[i]) {
+                    _targets[i]->compile(source);
+                }
+            }
+            qDeleteAll(reducedMeshes);
+        } else if(_targets[0]) {
+            _targets[0]->compile(_mesh);
+        }
+
+        _compiler->finished(this);
+    }
+
+    MeshCompiler *_compiler;
+    QOpenGLContext *_context;
+    Mesh *_mesh;
+    QList<CompiledMesh*> _targets;
+    bool _levelsOfDetail;
+    double _reduction;
+    State _state;
+};
+
+MeshCompiler::MeshCompiler()
+    : Logging("MeshCompiler") {
+    _uploadBudgetBytes = 4 * 1024 * 1024;
+    _uploadBudgetMilliseconds = 2;
+}
+
+MeshCompiler::~MeshCompiler() {
+    _threadPool.waitForDone();
+    qDeleteAll(_jobs);
+}
+
+void MeshCompiler::schedule(Mesh *mesh, CompiledMesh *target) {
+    if(!mesh || !target) {
+        return;
+    }
+
+    QList<CompiledMesh*> targets;
+    targets.append(target);
+    Job *job = new Job(this, QOpenGLContext::currentContext(), copyMesh(mesh), targets, false, 1.0);
+
+    QMutexLocker locker(&_mutex);
+    _jobs.append(job);
+    _threadPool.start(job);
+}
+
+void MeshCompiler::scheduleLevelsOfDetail(Mesh *mesh, QList<CompiledMesh*> targets, double reduction) {
+    if(!mesh || targets.isEmpty()) {
+        return;
+    }
+
+    Job *job = new Job(this, QOpenGLContext::currentContext(), copyMesh(mesh), targets, true, reduction);
+
+    QMutexLocker locker(&_mutex);
+    _jobs.append(job);
+    _threadPool.start(job);
+}
+
+void MeshCompiler::cancel(CompiledMesh *target) {
+    QMutexLocker locker(&_mutex);
+    for(int j = 0; j < _jobs.size(); j++) {
+        Job *job = _jobs[j];
+        if(!job->_targets.contains(target)) {
+            continue;
+        }
+
+        if(job->_state == Job::Running || job->_state == Job::Uploading) {
+            // The job list may change while we wait, so start over.
+            _jobFinished.wait(&_mutex);
+            j = -1;
+            continue;
+        }
+
+        for(int i = 0; i < job->_targets.size(); i++) {
+            if(job->_targets[i] == target) {
+                job->_targets[i] = 0;
+            }
+        }
+
+        if(job->_state == Job::Finished && !job->hasTargets()) {
+            _jobs.removeAt(j);
+            delete job;
+            j--;
+        }
+    }
+}
+
+void MeshCompiler::uploadFinished() {
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QElapsedTimer timer;
+    timer.start();
+    int bytes = 0;
+    bool uploadedAny = false;
+
+    while(true) {
+        // Uploading jobs are left alone by cancel(), so the upload itself
+        // does not need the lock and workers can keep finishing jobs.
+        Job *job = 0;
+        {
+            QMutexLocker locker(&_mutex);
+            foreach(Job *candidate, _jobs) {
+                if(candidate->_state == Job::Finished
+                && (!candidate->_context || candidate->_context == context)) {
+                    job = candidate;
+                    break;
+                }
+            }
+
+            if(!job) {
+                return;
+            }
+            job->_state = Job::Uploading;
+        }
+
+        bool complete = true;
+        foreach(CompiledMesh *target, job->_targets) {
+            if(!target || target->isReady()) {
+                continue;
+            }
+
+            int size = target->uploadSize();
+            if(uploadedAny
+            && (bytes + size > _uploadBudgetBytes
+             || timer.elapsed() >= _uploadBudgetMilliseconds)) {
+                // Continue next frame.
+                complete = false;
+                break;
+            }
+
+            target->upload();
+            bytes += size;
+            uploadedAny = true;
+        }
+
+        QMutexLocker locker(&_mutex);
+        if(complete) {
+            _jobs.removeAll(job);
+            delete job;
+        } else {
+            job->_state = Job::Finished;
+        }
+        _jobFinished.wakeAll();
+
+        if(!complete) {
+            return;
+        }
+    }
+}
+
+void MeshCompiler::setUploadBudget(int bytes, int milliseconds) {
+    _uploadBudgetBytes = bytes;
+    _uploadBudgetMilliseconds = milliseconds;
+}
+
+int MeshCompiler::uploadBudgetBytes() {
+    return _uploadBudgetBytes;
+}
+
+int MeshCompiler::uploadBudgetMilliseconds() {
+    return _uploadBudgetMilliseconds;
+}
+
+int MeshCompiler::pendingCount() {
+    QMutexLocker locker(&_mutex);
+    return _jobs.size();
+}
+
+void MeshCompiler::finished(Job *job) {
+    QMutexLocker locker(&_mutex);
+    job->_state = Job::Finished;
+    if(!job->hasTargets()) {
+        _jobs.removeAll(job);
+        delete job;
+    }
+    _jobFinished.wakeAll();
+}
+
+} // namespace Glee3D
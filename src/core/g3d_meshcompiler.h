@@ -0,0 +1,130 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_MESHCOMPILER_H
+#define G3D_MESHCOMPILER_H
+
+// Own includes
+#include "g3d_mesh.h"
+#include "g3d_logging.h"
+
+// Qt includes
+#include <QList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+namespace Glee3D {
+
+class CompiledMesh;
+
+/**
+  * @class MeshCompiler
+  * Compiles meshes in the background. The CPU side of compilation, such as
+  * generating normals, optimizing and simplifying, runs on a thread pool.
+  * Finished meshes are uploaded to the graphics card on the render thread,
+  * a few per frame, so that streaming in content does not stall rendering.
+  *
+  * Each mesh is uploaded into the OpenGL context that was current when it
+  * was scheduled, which is also the context CompiledMeshRegistry keys it
+  * by. Meshes scheduled without a current context are uploaded by the
+  * first context that asks for them.
+  */
+class MeshCompiler : public Logging {
+public:
+    static MeshCompiler& instance() {
+        static MeshCompiler meshCompiler;
+        return meshCompiler;
+    }
+
+    /**
+      * Compiles a copy of the given mesh into the given empty compiled mesh
+      * in the background. It will be uploaded into the current context.
+      * @param mesh Mesh to compile. It is copied, so it may change or be
+      * deleted afterwards.
+      * @param target Empty compiled mesh that receives the result.
+      */
+    void schedule(Mesh *mesh, CompiledMesh *target);
+
+    /**
+      * Compiles successively simplified copies of the given mesh into the
+      * given empty compiled meshes in the background. If the mesh cannot be
+      * simplified far enough, the remaining targets receive the coarsest
+      * level that could be generated.
+      * @param mesh Mesh to simplify. It is copied.
+      * @param targets Empty compiled meshes, from the finest to the coarsest.
+      * Levels that are not needed may be null.
+      * @param reduction Ratio of triangles kept from one level to the next.
+      */
+    void scheduleLevelsOfDetail(Mesh *mesh, QList<CompiledMesh*> targets, double reduction);
+
+    /**
+      * Makes sure the given compiled mesh is not touched by the compiler
+      * anymore. Waits if it is being compiled right now. This is called
+      * when a compiled mesh is destroyed.
+      */
+    void cancel(CompiledMesh *target);
+
+    /**
+      * Uploads compiled meshes that are finished and belong to the current
+      * OpenGL context, until the upload budget for this frame is used up.
+      * Call this once per frame on each render thread with its context
+      * current. At least one mesh is uploaded per call if there is one
+      * waiting.
+      */
+    void uploadFinished();
+
+    /**
+      * Sets the budget for uploading finished meshes per frame.
+      * @param bytes Maximum number of bytes uploaded per frame.
+      * @param milliseconds Maximum time spent on uploads per frame.
+      */
+    void setUploadBudget(int bytes, int milliseconds);
+
+    /** @returns the maximum number of bytes uploaded per frame. */
+    int uploadBudgetBytes();
+
+    /** @returns the maximum time in milliseconds spent on uploads per frame. */
+    int uploadBudgetMilliseconds();
+
+    /** @returns the number of meshes that are compiling or waiting for upload. */
+    int pendingCount();
+
+private:
+    MeshCompiler();
+    ~MeshCompiler();
+
+    class Job;
+    friend class Job;
+
+    void finished(Job *job);
+
+    QThreadPool _threadPool;
+    QMutex _mutex;
+    QWaitCondition _jobFinished;
+    QList<Job*> _jobs;
+
+    int _uploadBudgetBytes;
+    int _uploadBudgetMilliseconds;
+};
+
+} // namespace Glee3D
+
+#endif // G3D_MESHCOMPILER_H
@@ -0,0 +1,408 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_meshoptimizer.h"
+
+// Standard includes
+#include <algorithm>
+#include <limits.h>
+
+namespace Glee3D {
+    namespace {
+        /**
+          * A cluster ends once its cache miss ratio has fallen to this factor
+          * times the ratio of the surrounding dead end free run. Sander et
+          * al. suggest values slightly above one.
+          */
+        const double clusterThreshold = 1.05;
+
+        /** Loads the vertices of a triangle into a simulated FIFO cache.
+          * @returns the number of cache misses. */
+        int loadTriangle(const Triangle& t, QVector<int>& loadedAt, int& time, int cacheSize) {
+            int misses = 0;
+            for(int j = 0; j < 3; j++) {
+                int v = t._indices[j];
+                if(loadedAt[v] == INT_MIN || time - loadedAt[v] >= cacheSize) {
+                    loadedAt[v] = time;
+                    time++;
+                    misses++;
+                }
+            }
+            return misses;
+        }
+
+        /** A range of triangles that can be moved as a whole. */
+        struct Cluster {
+            int _begin;
+            int _end;
+            double _sortKey;
+        };
+
+        /** Orders clusters from the outside of the mesh to the inside. */
+        struct OutwardFirst {
+            bool operator()(const Cluster& a, const Cluster& b) const {
+                return a._sortKey > b._sortKey;
+            }
+        };
+    }
+
+    MeshOptimizer::MeshOptimizer(int cacheSize)
+        : Logging("MeshOptimizer") {
+        setCacheSize(cacheSize);
+    }
+
+    void MeshOptimizer::setCacheSize(int cacheSize) {
+        _cacheSize = cacheSize > 3 ? cacheSize : 3;
+    }
+
+    int MeshOptimizer::cacheSize() {
+        return _cacheSize;
+    }
+
+    bool MeshOptimizer::optimize(Mesh *mesh) {
+        if(!mesh) {
+            error("Cannot optimize a null mesh.");
+            return false;
+        }
+
+        if(!validate(mesh)) {
+            warning("Mesh references invalid vertices and will not be optimized.");
+            return false;
+        }
+
+        Statistics before = statistics(mesh);
+        QVector<int> deadEnds = optimizeVertexCache(mesh);
+        QVector<int> clusters = splitClusters(mesh, deadEnds);
+        optimizeOverdraw(mesh, clusters);
+        optimizeVertexFetch(mesh);
+        Statistics after = statistics(mesh);
+
+        information(QString("Optimized %1 triangles in %2 clusters. ACMR %3 -> %4, ATVR %5 -> %6.")
+                    .arg(mesh->_triangleCount)
+                    .arg(clusters.size())
+                    .arg(before._acmr, 0, 'f', 3)
+                    .arg(after._acmr, 0, 'f', 3)
+                    .arg(before._atvr, 0, 'f', 3)
+                    .arg(after._atvr, 0, 'f', 3));
+        return true;
+    }
+
+    MeshOptimizer::Statistics MeshOptimizer::statistics(Mesh *mesh) {
+        Statistics result;
+        result._acmr = 0.0;
+        result._atvr = 0.0;
+        if(!mesh || !validate(mesh) || mesh->_triangleCount == 0) {
+            return result;
+        }
+
+        // A vertex is in the FIFO cache if less than cacheSize vertices
+        // have been loaded since it was loaded itself.
+        QVector<int> loadedAt(mesh->_vertexCount, INT_MIN);
+        QVector<bool> referenced(mesh->_vertexCount, false);
+        int misses = 0;
+        int referencedCount = 0;
+        for(int i = 0; i < mesh->_triangleCount; i++) {
+            for(int j = 0; j < 3; j++) {
+                int v = mesh->_triangles[i]._indices[j];
+                if(loadedAt[v] == INT_MIN || misses - loadedAt[v] >= _cacheSize) {
+                    loadedAt[v] = misses;
+                    misses++;
+                }
+                if(!referenced[v]) {
+                    referenced[v] = true;
+                    referencedCount++;
+                }
+            }
+        }
+
+        result._acmr = (double)misses / (double)mesh->_triangleCount;
+        result._atvr = (double)misses / (double)referencedCount;
+        return result;
+    }
+
+    bool MeshOptimizer::validate(Mesh *mesh) {
+        for(int i = 0; i < mesh->_triangleCount; i++) {
+            for(int j = 0; j < 3; j++) {
+                int index = mesh->_triangles[i]._indices[j];
+                if(index < 0 || index >= mesh->_vertexCount) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    QVector<int> MeshOptimizer::optimizeVertexCache(Mesh *mesh) {
+        int vertexCount = mesh->_vertexCount;
+        int triangleCount = mesh->_triangleCount;
+
+        // Vertex to triangle adjacency in compressed row storage. The live
+        // count of a vertex is the number of its triangles not yet emitted.
+        QVector<int> liveCount(vertexCount, 0);
+        for(int i = 0; i < triangleCount; i++) {
+            for(int j = 0; j < 3; j++) {
+                liveCount[mesh->_triangles[i]._indices[j]]++;
+            }
+        }
+
+        QVector<int> offsets(vertexCount + 1, 0);
+        for(int v = 0; v < vertexCount; v++) {
+            offsets[v + 1] = offsets[v] + liveCount[v];
+        }
+
+        QVector<int> fill = offsets;
+        QVector<int> adjacency(triangleCount * 3);
+        for(int i = 0; i < triangleCount; i++) {
+            for(int j = 0; j < 3; j++) {
+                adjacency[fill[mesh->_triangles[i]._indices[j]]++] = i;
+            }
+        }
+
+        QVector<int> cacheTime(vertexCount, 0);
+        QVector<bool> emitted(triangleCount, false);
+        QVector<int> deadEnds;
+        QVector<int> candidates;
+        QVector<Triangle> output;
+        QVector<int> clusters;
+        deadEnds.reserve(triangleCount * 3);
+        output.reserve(triangleCount);
+
+        int time = _cacheSize + 1;
+        int cursor = 0;
+        int fanning = -1;
+        while(cursor < vertexCount && liveCount[cursor] == 0) {
+            cursor++;
+        }
+        if(cursor < vertexCount) {
+            fanning = cursor;
+            clusters.append(0);
+        }
+
+        while(fanning >= 0) {
+            // Emit all remaining triangles around the fanning vertex
+            candidates.clear();
+            for(int k = offsets[fanning]; k < offsets[fanning + 1]; k++) {
+                int t = adjacency[k];
+                if(emitted[t]) {
+                    continue;
+                }
+
+                for(int j = 0; j < 3; j++) {
+                    int v = mesh->_triangles[t]._indices[j];
+                    deadEnds.append(v);
+                    candidates.append(v);
+                    liveCount[v]--;
+                    if(time - cacheTime[v] > _cacheSize) {
+                        cacheTime[v] = time;
+                        time++;
+                    }
+                }
+                emitted[t] = true;
+                output.append(mesh->_triangles[t]);
+            }
+
+            // Continue with the candidate that will still be in the cache
+            // after all of its triangles have been emitted, preferring the
+            // oldest one.
+            int next = -1;
+            int bestPriority = -1;
+            foreach(int v, candidates) {
+                if(liveCount[v] > 0) {
+                    int priority = 0;
+                    if(time - cacheTime[v] + 2 * liveCount[v] <= _cacheSize) {
+                        priority = time - cacheTime[v];
+                    }
+                    if(priority > bestPriority) {
+                        bestPriority = priority;
+                        next = v;
+                    }
+                }
+            }
+
+            if(next == -1) {
+                // Dead end, go back to recently used vertices first, then
+                // scan for any vertex with triangles left.
+                while(!deadEnds.isEmpty()) {
+                    int v = deadEnds.last();
+                    deadEnds.removeLast();
+                    if(liveCount[v] > 0) {
+                        next = v;
+                        break;
+                    }
+                }
+
+                while(next == -1 && cursor < vertexCount) {
+                    if(liveCount[cursor] > 0) {
+                        next = cursor;
+                    }
+                    cursor++;
+                }
+
+                if(next != -1) {
+                    clusters.append(output.size());
+                }
+            }
+
+            fanning = next;
+        }
+
+        for(int i = 0; i < triangleCount; i++) {
+            mesh->_triangles[i] = output[i];
+        }
+        return clusters;
+    }
+
+    QVector<int> MeshOptimizer::splitClusters(Mesh *mesh, const QVector<int>& deadEnds) {
+        int triangleCount = mesh->_triangleCount;
+        QVector<int> loadedAt(mesh->_vertexCount, INT_MIN);
+        QVector<int> clusters;
+        int time = 0;
+
+        // Within each run between dead ends, start a new cluster wherever
+        // the cache could be flushed without making the run much worse
+        // than it is as a whole.
+        for(int d = 0; d < deadEnds.size(); d++) {
+            int begin = deadEnds[d];
+            int end = d + 1 < deadEnds.size() ? deadEnds[d + 1] : triangleCount;
+
+            time += _cacheSize;
+            int runMisses = 0;
+            for(int i = begin; i < end; i++) {
+                runMisses += loadTriangle(mesh->_triangles[i], loadedAt, time, _cacheSize);
+            }
+            double threshold = clusterThreshold * runMisses / (end - begin);
+
+            time += _cacheSize;
+            clusters.append(begin);
+            int clusterMisses = 0;
+            int clusterSize = 0;
+            for(int i = begin; i < end - 1; i++) {
+                clusterMisses += loadTriangle(mesh->_triangles[i], loadedAt, time, _cacheSize);
+                clusterSize++;
+                if(clusterMisses <= threshold * clusterSize) {
+                    clusters.append(i + 1);
+                    time += _cacheSize;
+                    clusterMisses = 0;
+                    clusterSize = 0;
+                }
+            }
+        }
+        return clusters;
+    }
+
+    void MeshOptimizer::optimizeOverdraw(Mesh *mesh, const QVector<int>& clusters) {
+        int triangleCount = mesh->_triangleCount;
+        if(clusters.size() < 2) {
+            return;
+        }
+
+        // Area weighted centroid and normal for each cluster.
+        QVector<Cluster> sortedClusters(clusters.size());
+        QVector<Vector3D> centroids(clusters.size());
+        QVector<Vector3D> normals(clusters.size());
+        Vector3D meshCentroid;
+        double meshArea = 0.0;
+        for(int c = 0; c < clusters.size(); c++) {
+            Cluster& cluster = sortedClusters[c];
+            cluster._begin = clusters[c];
+            cluster._end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+
+            Vector3D centroid;
+            Vector3D normal;
+            double area = 0.0;
+            for(int i = cluster._begin; i < cluster._end; i++) {
+                const Triangle& t = mesh->_triangles[i];
+                const Vector3D& v1 = mesh->_vertices[t._indices[0]];
+                const Vector3D& v2 = mesh->_vertices[t._indices[1]];
+                const Vector3D& v3 = mesh->_vertices[t._indices[2]];
+                Vector3D cross = (v2 - v1).crossProduct(v3 - v1);
+                double triangleArea = cross.length() * 0.5;
+                centroid += (v1 + v2 + v3) * (triangleArea / 3.0);
+                normal += cross;
+                area += triangleArea;
+            }
+
+            meshCentroid += centroid;
+            meshArea += area;
+            centroids[c] = area > 0.0 ? centroid * (1.0 / area) : centroid;
+            normals[c] = normal.length() > 0.0 ? normal.normalize() : normal;
+        }
+
+        if(meshArea > 0.0) {
+            meshCentroid = meshCentroid * (1.0 / meshArea);
+        }
+
+        // Clusters that face away from the center of the mesh are likely
+        // to occlude others and should be drawn first.
+        for(int c = 0; c < clusters.size(); c++) {
+            sortedClusters[c]._sortKey = (centroids[c] - meshCentroid).scalarProduct(normals[c]);
+        }
+        std::stable_sort(sortedClusters.begin(), sortedClusters.end(), OutwardFirst());
+
+        QVector<Triangle> output;
+        output.reserve(triangleCount);
+        foreach(const Cluster& cluster, sortedClusters) {
+            for(int i = cluster._begin; i < cluster._end; i++) {
+                output.append(mesh->_triangles[i]);
+            }
+        }
+
+        for(int i = 0; i < triangleCount; i++) {
+            mesh->_triangles[i] = output[i];
+        }
+    }
+
+    void MeshOptimizer::optimizeVertexFetch(Mesh *mesh) {
+        int vertexCount = mesh->_vertexCount;
+
+        // Number vertices in order of their first use, unused vertices go
+        // to the end.
+        QVector<int> remap(vertexCount, -1);
+        int next = 0;
+        for(int i = 0; i < mesh->_triangleCount; i++) {
+            for(int j = 0; j < 3; j++) {
+                int& index = mesh->_triangles[i]._indices[j];
+                if(remap[index] == -1) {
+                    remap[index] = next++;
+                }
+                index = remap[index];
+            }
+        }
+
+        for(int v = 0; v < vertexCount; v++) {
+            if(remap[v] == -1) {
+                remap[v] = next++;
+            }
+        }
+
+        QVector<Vector3D> vertices(vertexCount);
+        QVector<Vector2D> textureCoordinates(vertexCount);
+        for(int v = 0; v < vertexCount; v++) {
+            vertices[remap[v]] = mesh->_vertices[v];
+            textureCoordinates[remap[v]] = mesh->_textureCoordinates[v];
+        }
+
+        for(int v = 0; v < vertexCount; v++) {
+            mesh->_vertices[v] = vertices[v];
+            mesh->_textureCoordinates[v] = textureCoordinates[v];
+        }
+    }
+} // namespace Glee3D
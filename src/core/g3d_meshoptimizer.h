@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_MESHOPTIMIZER_H
+#define G3D_MESHOPTIMIZER_H
+
+// Own includes
+#include "g3d_mesh.h"
+#include "g3d_logging.h"
+
+// Qt includes
+#include <QVector>
+
+namespace Glee3D {
+    /**
+      * @class MeshOptimizer
+      * Reorders the triangles and vertices of a mesh for faster rendering.
+      * Triangles are first put into an order that reuses the post-transform
+      * vertex cache of the graphics card (Tipsify, Sander et al. 2007). That
+      * order is split into clusters at its dead ends and wherever the cache
+      * could be flushed at little cost. The clusters are then sorted so that
+      * outward facing parts of the mesh are drawn first, which reduces
+      * overdraw. Finally the vertices are
+      * renumbered in the order they are first referenced, so they are fetched
+      * sequentially from memory.
+      *
+      * The mesh is optimized in place, its geometry stays the same.
+      */
+    class MeshOptimizer :
+        public Logging {
+    public:
+        /**
+          * @struct Statistics
+          * Vertex cache efficiency of a mesh, as simulated with a FIFO cache.
+          */
+        struct Statistics {
+            /** Average cache miss ratio, vertex transforms per triangle. */
+            double _acmr;
+            /** Average transform to vertex ratio, 1.0 is optimal. */
+            double _atvr;
+        };
+
+        /**
+         * Creates a new mesh optimizer.
+         * @param cacheSize Number of vertices in the simulated vertex cache.
+         */
+        MeshOptimizer(int cacheSize = 16);
+
+        /** Sets the number of vertices in the simulated vertex cache. */
+        void setCacheSize(int cacheSize);
+
+        /** @returns the number of vertices in the simulated vertex cache. */
+        int cacheSize();
+
+        /**
+         * Optimizes the triangle and vertex order of the given mesh. The
+         * vertex cache statistics before and after are logged.
+         * @param mesh The mesh to optimize.
+         * @returns false, if the mesh could not be optimized because it
+         * references invalid vertices.
+         */
+        bool optimize(Mesh *mesh);
+
+        /** @returns the vertex cache statistics for the given mesh. */
+        Statistics statistics(Mesh *mesh);
+
+    private:
+        bool validate(Mesh *mesh);
+        QVector<int> optimizeVertexCache(Mesh *mesh);
+        QVector<int> splitClusters(Mesh *mesh, const QVector<int>& deadEnds);
+        void optimizeOverdraw(Mesh *mesh, const QVector<int>& clusters);
+        void optimizeVertexFetch(Mesh *mesh);
+
+        int _cacheSize;
+    };
+} // namespace Glee3D
+
+#endif // G3D_MESHOPTIMIZER_H
@@ -0,0 +1,417 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_meshsimplifier.h"
+
+// Qt includes
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QSet>
+
+// Standard includes
+#include <queue>
+#include <vector>
+
+namespace Glee3D {
+    namespace {
+        /** Weight of the planes that keep open boundaries in place. */
+        const double boundaryWeight = 1000.0;
+
+        /**
+          * Symmetric 4x4 matrix measuring the sum of squared distances to a
+          * set of planes.
+          */
+        struct Quadric {
+            // Upper triangle: aa ab ac ad bb bc bd cc cd dd
+            double _q[10];
+
+            Quadric() {
+                for(int i = 0; i < 10; i++) {
+                    _q[i] = 0.0;
+                }
+            }
+
+            /** Quadric of the plane ax + by + cz + d = 0. */
+            Quadric(double a, double b, double c, double d, double weight) {
+                _q[0] = a * a * weight; _q[1] = a * b * weight; _q[2] = a * c * weight; _q[3] = a * d * weight;
+                _q[4] = b * b * weight; _q[5] = b * c * weight; _q[6] = b * d * weight;
+                _q[7] = c * c * weight; _q[8] = c * d * weight;
+                _q[9] = d * d * weight;
+            }
+
+            Quadric& operator+=(const Quadric& other) {
+                for(int i = 0; i < 10; i++) {
+                    _q[i] += other._q[i];
+                }
+                return *this;
+            }
+
+            Quadric operator+(const Quadric& other) const {
+                Quadric result = *this;
+                result += other;
+                return result;
+            }
+
+            double error(Vector3D v) const {
+                double x = v.x(), y = v.y(), z = v.z();
+                return _q[0] * x * x + 2.0 * _q[1] * x * y + 2.0 * _q[2] * x * z + 2.0 * _q[3] * x
+                     + _q[4] * y * y + 2.0 * _q[5] * y * z + 2.0 * _q[6] * y
+                     + _q[7] * z * z + 2.0 * _q[8] * z
+                     + _q[9];
+            }
+        };
+
+        Quadric planeQuadric(Vector3D normal, Vector3D point, double weight) {
+            return Quadric(normal.x(), normal.y(), normal.z(),
+                           -normal.scalarProduct(point), weight);
+        }
+
+        /** A candidate edge collapse that moves _keep and removes _remove. */
+        struct Collapse {
+            double _cost;
+            int _keep;
+            int _remove;
+            int _keepStamp;
+            int _removeStamp;
+            Vector3D _position;
+            Vector2D _texCoord;
+        };
+
+        struct CheaperFirst {
+            bool operator()(const Collapse& a, const Collapse& b) const {
+                return a._cost > b._cost;
+            }
+        };
+
+        typedef std::priority_queue<Collapse, std::vector<Collapse>, CheaperFirst> CollapseQueue;
+
+        typedef QPair<int, int> Edge;
+
+        Edge edgeKey(int a, int b) {
+            return a < b ? Edge(a, b) : Edge(b, a);
+        }
+
+        /** Working state of a single simplification. */
+        struct State {
+            QVector<Vector3D> _positions;
+            QVector<Vector2D> _texCoords;
+            QVector<Quadric> _quadrics;
+            QVector<int> _stamps;
+            QVector<bool> _vertexRemoved;
+            QVector<QVector<int> > _vertexTriangles;
+            QVector<Triangle> _triangles;
+            QVector<bool> _triangleRemoved;
+
+            Vector3D faceNormal(const Triangle& t, int movedVertex, Vector3D movedPosition) {
+                Vector3D p[3];
+                for(int j = 0; j < 3; j++) {
+                    p[j] = t._indices[j] == movedVertex ? movedPosition : _positions[t._indices[j]];
+                }
+                return (p[1] - p[0]).crossProduct(p[2] - p[0]);
+            }
+
+            Collapse evaluate(int a, int b) {
+                Quadric q = _quadrics[a] + _quadrics[b];
+                Vector3D candidates[3] = {
+                    _positions[a],
+                    _positions[b],
+                    (_positions[a] + _positions[b]) * 0.5
+                };
+                Vector2D texCoords[3] = {
+                    _texCoords[a],
+                    _texCoords[b],
+                    (_texCoords[a] + _texCoords[b]) * 0.5
+                };
+
+                Collapse collapse;
+                collapse._keep = a;
+                collapse._remove = b;
+                collapse._keepStamp = _stamps[a];
+                collapse._removeStamp = _stamps[b];
+                collapse._cost = -1.0;
+                for(int i = 0; i < 3; i++) {
+                    double cost = q.error(candidates[i]);
+                    if(collapse._cost < 0.0 || cost < collapse._cost) {
+                        collapse._cost = cost;
+                        collapse._position = candidates[i];
+                        collapse._texCoord = texCoords[i];
+                    }
+                }
+                return collapse;
+            }
+
+            bool isStale(const Collapse& c) {
+                return _vertexRemoved[c._keep] || _vertexRemoved[c._remove]
+                    || _stamps[c._keep] != c._keepStamp
+                    || _stamps[c._remove] != c._removeStamp;
+            }
+
+            /** @returns true, if the collapse would turn a triangle over. */
+            bool flips(const Collapse& c) {
+                int vertices[2] = { c._keep, c._remove };
+                for(int k = 0; k < 2; k++) {
+                    int v = vertices[k];
+                    foreach(int t, _vertexTriangles[v]) {
+                        if(_triangleRemoved[t]) {
+                            continue;
+                        }
+
+                        const Triangle& triangle = _triangles[t];
+                        bool shared = false;
+                        for(int j = 0; j < 3; j++) {
+                            int other = triangle._indices[j];
+                            if(other != v && (other == c._keep || other == c._remove)) {
+                                shared = true;
+                            }
+                        }
+                        if(shared) {
+                            // This triangle disappears with the collapse.
+                            continue;
+                        }
+
+                        Vector3D before = faceNormal(triangle, v, _positions[v]);
+                        Vector3D after = faceNormal(triangle, v, c._position);
+                        if(before.length() > 0.0 && before.scalarProduct(after) <= 0.0) {
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            }
+        };
+    }
+
+    MeshSimplifier::MeshSimplifier()
+        : Logging("MeshSimplifier") {
+    }
+
+    Mesh *MeshSimplifier::simplify(Mesh *mesh, int targetTriangleCount) {
+        if(!mesh) {
+            error("Cannot simplify a null mesh.");
+            return 0;
+        }
+
+        int vertexCount = mesh->vertexCount();
+        int triangleCount = mesh->triangleCount();
+
+        State state;
+        state._positions.resize(vertexCount);
+        state._texCoords.resize(vertexCount);
+        state._quadrics.resize(vertexCount);
+        state._stamps.fill(0, vertexCount);
+        state._vertexRemoved.fill(false, vertexCount);
+        state._vertexTriangles.resize(vertexCount);
+        state._triangles.resize(triangleCount);
+        state._triangleRemoved.fill(false, triangleCount);
+
+        for(int i = 0; i < vertexCount; i++) {
+            state._positions[i] = mesh->vertex(i);
+            state._texCoords[i] = mesh->textureCoordinates(i);
+        }
+
+        QHash<Edge, int> edgeUsage;
+        for(int i = 0; i < triangleCount; i++) {
+            Triangle t = mesh->triangle(i);
+            for(int j = 0; j < 3; j++) {
+                if(t._indices[j] < 0 || t._indices[j] >= vertexCount) {
+                    error("Cannot simplify a mesh with invalid vertex indices.");
+                    return 0;
+                }
+            }
+            state._triangles[i] = t;
+
+            for(int j = 0; j < 3; j++) {
+                int v = t._indices[j];
+                if(!state._vertexTriangles[v].contains(i)) {
+                    state._vertexTriangles[v].append(i);
+                }
+                edgeUsage[edgeKey(v, t._indices[(j + 1) % 3])]++;
+            }
+        }
+
+        // Accumulate the planes of all adjacent faces into each vertex,
+        // weighted by face area. Boundary edges add a perpendicular plane.
+        for(int i = 0; i < triangleCount; i++) {
+            const Triangle& t = state._triangles[i];
+            Vector3D p0 = state._positions[t._indices[0]];
+            Vector3D normal = state.faceNormal(t, -1, Vector3D());
+            double area = normal.length() * 0.5;
+            if(area <= 0.0) {
+                continue;
+            }
+            normal.normalize();
+
+            Quadric faceQuadric = planeQuadric(normal, p0, area);
+            for(int j = 0; j < 3; j++) {
+                int a = t._indices[j];
+                int b = t._indices[(j + 1) % 3];
+                state._quadrics[a] += faceQuadric;
+
+                if(edgeUsage.value(edgeKey(a, b)) == 1) {
+                    Vector3D edge = state._positions[b] - state._positions[a];
+                    Vector3D boundaryNormal = edge.crossProduct(normal);
+                    if(boundaryNormal.length() > 0.0) {
+                        boundaryNormal.normalize();
+                        Quadric boundaryQuadric = planeQuadric(boundaryNormal, state._positions[a],
+                                                               boundaryWeight * edge.scalarProduct(edge));
+                        state._quadrics[a] += boundaryQuadric;
+                        state._quadrics[b] += boundaryQuadric;
+                    }
+                }
+            }
+        }
+
+        CollapseQueue queue;
+        foreach(Edge edge, edgeUsage.keys()) {
+            if(edge.first != edge.second) {
+                queue.push(state.evaluate(edge.first, edge.second));
+            }
+        }
+
+        int liveTriangles = triangleCount;
+        while(liveTriangles > targetTriangleCount && !queue.empty()) {
+            Collapse collapse = queue.top();
+            queue.pop();
+
+            if(state.isStale(collapse) || state.flips(collapse)) {
+                continue;
+            }
+
+            int keep = collapse._keep;
+            int remove = collapse._remove;
+            state._positions[keep] = collapse._position;
+            state._texCoords[keep] = collapse._texCoord;
+            state._quadrics[keep] += state._quadrics[remove];
+
+            foreach(int t, state._vertexTriangles[remove]) {
+                if(state._triangleRemoved[t]) {
+                    continue;
+                }
+
+                Triangle& triangle = state._triangles[t];
+                bool hasKeep = false;
+                for(int j = 0; j < 3; j++) {
+                    if(triangle._indices[j] == keep) {
+                        hasKeep = true;
+                    }
+                }
+
+                if(hasKeep) {
+                    state._triangleRemoved[t] = true;
+                    liveTriangles--;
+                } else {
+                    for(int j = 0; j < 3; j++) {
+                        if(triangle._indices[j] == remove) {
+                            triangle._indices[j] = keep;
+                        }
+                    }
+                    state._vertexTriangles[keep].append(t);
+                }
+            }
+
+            state._vertexRemoved[remove] = true;
+            state._vertexTriangles[remove].clear();
+            state._stamps[keep]++;
+
+            // Drop removed triangles and queue the new edges around keep
+            QVector<int> liveAroundKeep;
+            QSet<int> neighbors;
+            foreach(int t, state._vertexTriangles[keep]) {
+                if(state._triangleRemoved[t]) {
+                    continue;
+                }
+                liveAroundKeep.append(t);
+                for(int j = 0; j < 3; j++) {
+                    if(state._triangles[t]._indices[j] != keep) {
+                        neighbors.insert(state._triangles[t]._indices[j]);
+                    }
+                }
+            }
+            state._vertexTriangles[keep] = liveAroundKeep;
+
+            foreach(int neighbor, neighbors) {
+                queue.push(state.evaluate(keep, neighbor));
+            }
+        }
+
+        // Compact the remaining vertices and triangles into a new mesh
+        QVector<int> remap(vertexCount, -1);
+        int newVertexCount = 0;
+        for(int i = 0; i < triangleCount; i++) {
+            if(state._triangleRemoved[i]) {
+                continue;
+            }
+            for(int j = 0; j < 3; j++) {
+                int v = state._triangles[i]._indices[j];
+                if(remap[v] == -1) {
+                    remap[v] = newVertexCount++;
+                }
+            }
+        }
+
+        Mesh *result = new Mesh(newVertexCount, liveTriangles);
+        for(int v = 0; v < vertexCount; v++) {
+            if(remap[v] != -1) {
+                result->setVertex(remap[v], state._positions[v]);
+                result->setTextureCoordinates(remap[v], state._texCoords[v]);
+            }
+        }
+
+        int index = 0;
+        for(int i = 0; i < triangleCount; i++) {
+            if(state._triangleRemoved[i]) {
+                continue;
+            }
+            const Triangle& t = state._triangles[i];
+            result->setTriangle(index++, Triangle(remap[t._indices[0]],
+                                                  remap[t._indices[1]],
+                                                  remap[t._indices[2]]));
+        }
+
+        return result;
+    }
+
+    QList<Mesh*> MeshSimplifier::simplifyChain(Mesh *mesh, int levelCount, double reduction) {
+        QList<Mesh*> chain;
+        Mesh *previous = mesh;
+        for(int level = 0; level < levelCount && previous; level++) {
+            int target = (int)(previous->triangleCount() * reduction);
+            Mesh *next = simplify(previous, target);
+            if(!next) {
+                break;
+            }
+
+            if(next->triangleCount() >= previous->triangleCount()) {
+                // Nothing left to collapse.
+                delete next;
+                break;
+            }
+
+            information(QString("Simplified level %1 to %2 triangles.")
+                        .arg(level + 1)
+                        .arg(next->triangleCount()));
+            chain.append(next);
+            previous = next;
+        }
+        return chain;
+    }
+} // namespace Glee3D
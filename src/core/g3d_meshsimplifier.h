@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_MESHSIMPLIFIER_H
+#define G3D_MESHSIMPLIFIER_H
+
+// Own includes
+#include "g3d_mesh.h"
+#include "g3d_logging.h"
+
+// Qt includes
+#include <QList>
+
+namespace Glee3D {
+    /**
+      * @class MeshSimplifier
+      * Reduces the number of triangles of a mesh by repeatedly collapsing the
+      * edge that changes the surface the least, as measured by the quadric
+      * error metric (Garland and Heckbert 1997). Edges on open boundaries
+      * are penalized, so the outline of a mesh is kept as long as possible.
+      * Collapses that would flip a triangle are rejected.
+      */
+    class MeshSimplifier :
+        public Logging {
+    public:
+        /** Creates a new mesh simplifier. */
+        MeshSimplifier();
+
+        /**
+         * Creates a simplified copy of the given mesh.
+         * @param mesh The mesh to simplify.
+         * @param targetTriangleCount Number of triangles to reduce to. The
+         * result may have more triangles if no further edge can be collapsed.
+         * @returns a new mesh, or null if the mesh is invalid.
+         */
+        Mesh *simplify(Mesh *mesh, int targetTriangleCount);
+
+        /**
+         * Creates a chain of successively simplified copies of the given mesh.
+         * @param mesh The mesh to simplify.
+         * @param levelCount Number of simplified levels to create.
+         * @param reduction Ratio of triangles kept from one level to the next.
+         * @returns the simplified meshes, from the finest to the coarsest.
+         * The caller takes ownership.
+         */
+        QList<Mesh*> simplifyChain(Mesh *mesh, int levelCount, double reduction = 0.5);
+    };
+} // namespace Glee3D
+
+#endif // G3D_MESHSIMPLIFIER_H
@@ -0,0 +1,367 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_normalbuilder.h"
+
+// Qt includes
+#include <QThread>
+#include <QList>
+#include <QtConcurrentMap>
+
+// Standard includes
+#include <math.h>
+
+namespace Glee3D {
+    namespace {
+        /** Meshes below this triangle count are not worth spreading over threads. */
+        const int minimumTrianglesPerThread = 4096;
+
+        /** A range of triangles or vertices processed by a single thread.
+          * Triangles are numbered locally if there are triangle ids, and all
+          * of them are valid if there are no valid flags. */
+        struct Job {
+            int _begin;
+            int _end;
+            NormalBuilder::Weighting _weighting;
+            const Vector3D *_vertices;
+            const Triangle *_triangles;
+            const int *_triangleIds;
+            const bool *_validTriangles;
+            const int *_offsets;
+            const int *_corners;
+            Vector3D *_faceNormals;
+            Vector3D *_vertexNormals;
+        };
+
+        /** @returns the angle of the given triangle at the given corner. */
+        double cornerAngle(const Vector3D *vertices, const Triangle& t, int corner) {
+            Vector3D a = vertices[t._indices[(corner + 1) % 3]] - vertices[t._indices[corner]];
+            Vector3D b = vertices[t._indices[(corner + 2) % 3]] - vertices[t._indices[corner]];
+            double lengths = a.length() * b.length();
+            if(lengths <= 0.0) {
+                return 0.0;
+            }
+            double cosine = a.scalarProduct(b) / lengths;
+            cosine = cosine > 1.0 ? 1.0 : (cosine < -1.0 ? -1.0 : cosine);
+            return acos(cosine);
+        }
+
+        Vector3D faceNormal(const Vector3D *vertices, const Triangle& t,
+                            NormalBuilder::Weighting weighting) {
+            const Vector3D& v1 = vertices[t._indices[0]];
+            const Vector3D& v2 = vertices[t._indices[1]];
+            const Vector3D& v3 = vertices[t._indices[2]];
+
+            // The length of the cross product is twice the triangle area,
+            // so leaving it unnormalized gives us area weighting for free.
+            Vector3D normal = (v2 - v1).crossProduct(v3 - v1);
+            if(weighting != NormalBuilder::AreaWeighted) {
+                normal.normalize();
+            }
+            return normal;
+        }
+
+        /** @returns the mesh triangle of the given job triangle. */
+        const Triangle& triangle(const Job& job, int i) {
+            return job._triangles[job._triangleIds ? job._triangleIds[i] : i];
+        }
+
+        void buildFaceNormals(Job& job) {
+            for(int i = job._begin; i < job._end; i++) {
+                if(!job._validTriangles || job._validTriangles[i]) {
+                    job._faceNormals[i] = faceNormal(job._vertices, triangle(job, i), job._weighting);
+                }
+            }
+        }
+
+        void accumulateVertexNormals(Job& job) {
+            for(int i = job._begin; i < job._end; i++) {
+                Vector3D vertexNormal;
+                for(int j = job._offsets[i]; j < job._offsets[i + 1]; j++) {
+                    int t = job._corners[j] / 3;
+                    if(job._weighting == NormalBuilder::AngleWeighted) {
+                        vertexNormal += job._faceNormals[t]
+                                * cornerAngle(job._vertices, triangle(job, t), job._corners[j] % 3);
+                    } else {
+                        vertexNormal += job._faceNormals[t];
+                    }
+                }
+                job._vertexNormals[i] = vertexNormal.normalize();
+            }
+        }
+
+        /** Splits count items into one job per thread. */
+        QList<Job> split(const Job& prototype, int count, int threadCount) {
+            QList<Job> jobs;
+            int chunkSize = (count + threadCount - 1) / threadCount;
+            for(int begin = 0; begin < count; begin += chunkSize) {
+                Job job = prototype;
+                job._begin = begin;
+                job._end = qMin(begin + chunkSize, count);
+                jobs.append(job);
+            }
+            return jobs;
+        }
+
+        /** Builds face normals for the given number of triangles and then
+          * accumulates them into the given number of vertices. */
+        void run(Job prototype, int triangleCount, int vertexCount, int threadCount) {
+            threadCount = qMax(1, qMin(threadCount, triangleCount / minimumTrianglesPerThread));
+            if(threadCount == 1) {
+                prototype._end = triangleCount;
+                buildFaceNormals(prototype);
+                prototype._end = vertexCount;
+                accumulateVertexNormals(prototype);
+            } else {
+                QList<Job> faceJobs = split(prototype, triangleCount, threadCount);
+                QtConcurrent::blockingMap(faceJobs, buildFaceNormals);
+                QList<Job> vertexJobs = split(prototype, vertexCount, threadCount);
+                QtConcurrent::blockingMap(vertexJobs, accumulateVertexNormals);
+            }
+        }
+    }
+
+    NormalBuilder::NormalBuilder(Weighting weighting)
+        : Logging("NormalBuilder") {
+        _weighting = weighting;
+        _threadCount = QThread::idealThreadCount();
+        _rangeMesh = 0;
+        _rangeSize = 0;
+    }
+
+    void NormalBuilder::setWeighting(Weighting weighting) {
+        _weighting = weighting;
+    }
+
+    NormalBuilder::Weighting NormalBuilder::weighting() {
+        return _weighting;
+    }
+
+    void NormalBuilder::setThreadCount(int threadCount) {
+        _threadCount = threadCount;
+    }
+
+    int NormalBuilder::threadCount() {
+        return _threadCount;
+    }
+
+    QVector<Vector3D> NormalBuilder::build(Mesh *mesh) {
+        if(!mesh) {
+            error("Cannot build normals for a null mesh.");
+            return QVector<Vector3D>();
+        }
+
+        int vertexCount = mesh->_vertexCount;
+        int triangleCount = mesh->_triangleCount;
+
+        // Skip triangles referring to vertices that do not exist.
+        QVector<bool> validTriangles(triangleCount, true);
+        int invalidTriangleCount = 0;
+        for(int i = 0; i < triangleCount; i++) {
+            for(int c = 0; c < 3; c++) {
+                int index = mesh->_triangles[i]._indices[c];
+                if(index < 0 || index >= vertexCount) {
+                    validTriangles[i] = false;
+                }
+            }
+            if(!validTriangles[i]) {
+                invalidTriangleCount++;
+            }
+        }
+
+        if(invalidTriangleCount > 0) {
+            warning(QString("Ignoring %1 triangles with invalid vertex indices.")
+                    .arg(invalidTriangleCount));
+        }
+
+        // Build a compact vertex-to-triangle adjacency list. Corners are
+        // inserted in ascending triangle order, so the accumulation order per
+        // vertex does not depend on how the work is split between threads.
+        QVector<int> offsets(vertexCount + 1, 0);
+        for(int i = 0; i < triangleCount; i++) {
+            if(validTriangles[i]) {
+                for(int c = 0; c < 3; c++) {
+                    offsets[mesh->_triangles[i]._indices[c] + 1]++;
+                }
+            }
+        }
+
+        for(int i = 0; i < vertexCount; i++) {
+            offsets[i + 1] += offsets[i];
+        }
+
+        QVector<int> corners(offsets[vertexCount]);
+        QVector<int> insertPositions(offsets);
+        for(int i = 0; i < triangleCount; i++) {
+            if(validTriangles[i]) {
+                for(int c = 0; c < 3; c++) {
+                    corners[insertPositions[mesh->_triangles[i]._indices[c]]++] = i * 3 + c;
+                }
+            }
+        }
+
+        QVector<Vector3D> faceNormals(triangleCount);
+        QVector<Vector3D> vertexNormals(vertexCount);
+
+        Job prototype;
+        prototype._begin = 0;
+        prototype._end = 0;
+        prototype._weighting = _weighting;
+        prototype._vertices = mesh->_vertices;
+        prototype._triangles = mesh->_triangles;
+        prototype._triangleIds = 0;
+        prototype._validTriangles = validTriangles.constData();
+        prototype._offsets = offsets.constData();
+        prototype._corners = corners.constData();
+        prototype._faceNormals = faceNormals.data();
+        prototype._vertexNormals = vertexNormals.data();
+
+        run(prototype, triangleCount, vertexCount, _threadCount);
+        return vertexNormals;
+    }
+
+    bool NormalBuilder::prepareRanges(Mesh *mesh, int rangeSize) {
+        _rangeMesh = 0;
+        _rangeOffsets.clear();
+        _rangeTriangles.clear();
+        if(!mesh) {
+            error("Cannot build normals for a null mesh.");
+            return false;
+        }
+
+        if(rangeSize <= 0) {
+            error("Cannot build normals for empty ranges.");
+            return false;
+        }
+
+        // Sort triangles into the ranges of their vertices, like the
+        // corners in build(). Triangles stay in ascending order within each
+        // range, so the normals come out the same.
+        int rangeCount = (mesh->_vertexCount + rangeSize - 1) / rangeSize;
+        QVector<int> offsets(rangeCount + 1, 0);
+        for(int pass = 0; pass < 2; pass++) {
+            QVector<int> insertPositions(offsets);
+            for(int i = 0; i < mesh->_triangleCount; i++) {
+                const Triangle& t = mesh->_triangles[i];
+                int ranges[3];
+                bool valid = true;
+                for(int c = 0; c < 3; c++) {
+                    int index = t._indices[c];
+                    if(index < 0 || index >= mesh->_vertexCount) {
+                        valid = false;
+                    }
+                    ranges[c] = index / rangeSize;
+                }
+
+                if(!valid) {
+                    continue;
+                }
+
+                for(int c = 0; c < 3; c++) {
+                    if((c > 0 && ranges[c] == ranges[0]) || (c > 1 && ranges[c] == ranges[1])) {
+                        continue;
+                    }
+                    if(pass == 0) {
+                        offsets[ranges[c] + 1]++;
+                    } else {
+                        _rangeTriangles[insertPositions[ranges[c]]++] = i;
+                    }
+                }
+            }
+
+            if(pass == 0) {
+                for(int r = 0; r < rangeCount; r++) {
+                    offsets[r + 1] += offsets[r];
+                }
+                _rangeTriangles.resize(offsets[rangeCount]);
+            }
+        }
+
+        _rangeMesh = mesh;
+        _rangeSize = rangeSize;
+        _rangeOffsets = offsets;
+        return true;
+    }
+
+    bool NormalBuilder::buildRange(int range, Vector3D *normals) {
+        if(!_rangeMesh || !normals) {
+            error("Ranges have to be prepared before building them.");
+            return false;
+        }
+
+        if(range < 0 || range >= _rangeOffsets.size() - 1) {
+            error("Cannot build normals for vertices outside of the mesh.");
+            return false;
+        }
+
+        Mesh *mesh = _rangeMesh;
+        int firstVertex = range * _rangeSize;
+        int vertexCount = qMin(_rangeSize, mesh->_vertexCount - firstVertex);
+        const int *triangleIds = _rangeTriangles.constData() + _rangeOffsets[range];
+        int triangleCount = _rangeOffsets[range + 1] - _rangeOffsets[range];
+
+        // Adjacency of the vertices in this range, as in build().
+        QVector<int> offsets(vertexCount + 1, 0);
+        for(int i = 0; i < triangleCount; i++) {
+            const Triangle& t = mesh->_triangles[triangleIds[i]];
+            for(int c = 0; c < 3; c++) {
+                int index = t._indices[c] - firstVertex;
+                if(index >= 0 && index < vertexCount) {
+                    offsets[index + 1]++;
+                }
+            }
+        }
+
+        for(int i = 0; i < vertexCount; i++) {
+            offsets[i + 1] += offsets[i];
+        }
+
+        QVector<int> corners(offsets[vertexCount]);
+        QVector<int> insertPositions(offsets);
+        for(int i = 0; i < triangleCount; i++) {
+            const Triangle& t = mesh->_triangles[triangleIds[i]];
+            for(int c = 0; c < 3; c++) {
+                int index = t._indices[c] - firstVertex;
+                if(index >= 0 && index < vertexCount) {
+                    corners[insertPositions[index]++] = i * 3 + c;
+                }
+            }
+        }
+
+        QVector<Vector3D> faceNormals(triangleCount);
+
+        Job prototype;
+        prototype._begin = 0;
+        prototype._end = 0;
+        prototype._weighting = _weighting;
+        prototype._vertices = mesh->_vertices;
+        prototype._triangles = mesh->_triangles;
+        prototype._triangleIds = triangleIds;
+        prototype._validTriangles = 0;
+        prototype._offsets = offsets.constData();
+        prototype._corners = corners.constData();
+        prototype._faceNormals = faceNormals.data();
+        prototype._vertexNormals = normals;
+
+        run(prototype, triangleCount, vertexCount, _threadCount);
+        return true;
+    }
+} // namespace Glee3D
@@ -0,0 +1,122 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_NORMALBUILDER_H
+#define G3D_NORMALBUILDER_H
+
+// Own includes
+#include "g3d_mesh.h"
+#include "g3d_logging.h"
+#include "math/g3d_vector3d.h"
+
+// Qt includes
+#include <QVector>
+
+namespace Glee3D {
+    /**
+      * @class NormalBuilder
+      * Generates smooth vertex normals for a mesh. The face normals of all
+      * triangles are accumulated into the vertices they reference in a single
+      * pass over the triangle list, so the cost grows linearly with the size
+      * of the mesh. Large meshes are split into ranges that are processed
+      * concurrently on all available cores.
+      *
+      * For meshes too large to hold all normals at once, the normals can
+      * also be built for one range of vertices after another.
+      */
+    class NormalBuilder :
+        public Logging {
+    public:
+        /**
+          * @enum Weighting
+          * Defines how much each adjacent face contributes to a vertex normal.
+          */
+        enum Weighting {
+            /** Every adjacent face contributes equally. */
+            Uniform,
+            /** Faces contribute in proportion to their area. */
+            AreaWeighted,
+            /** Faces contribute in proportion to the angle at the vertex. */
+            AngleWeighted
+        };
+
+        /** Creates a new normal builder with the given weighting. */
+        NormalBuilder(Weighting weighting = Uniform);
+
+        /** Sets the weighting used for accumulating face normals. */
+        void setWeighting(Weighting weighting);
+
+        /** @returns the weighting used for accumulating face normals. */
+        Weighting weighting();
+
+        /**
+         * Sets the number of threads used to build normals. By default, this
+         * is the ideal thread count for the current machine.
+         * @param threadCount Number of threads, 1 disables multithreading.
+         */
+        void setThreadCount(int threadCount);
+
+        /** @returns the number of threads used to build normals. */
+        int threadCount();
+
+        /**
+         * Builds the vertex normals for the given mesh.
+         * @param mesh The mesh to build normals for.
+         * @returns a normalized normal for each vertex of the mesh. Vertices
+         * that are not referenced by any triangle get a null normal.
+         */
+        QVector<Vector3D> build(Mesh *mesh);
+
+        /**
+         * Prepares building normals range by range with buildRange(), for
+         * meshes too large to hold all normals at once. The triangles are
+         * sorted into the ranges of vertices they reference, which takes
+         * about one index per triangle.
+         * @param mesh The mesh to build normals for. It must not change
+         * until all ranges have been built.
+         * @param rangeSize Number of vertices per range.
+         * @returns false, if the mesh is null or the range size is invalid.
+         */
+        bool prepareRanges(Mesh *mesh, int rangeSize);
+
+        /**
+         * Builds the vertex normals for a range of vertices of the mesh
+         * given to prepareRanges(). Only the triangles of that range are
+         * visited, so building all ranges takes linear time. The normals
+         * are exactly the ones build() returns.
+         * @param range Index of the range, which starts at the vertex
+         * range times the range size.
+         * @param normals Receives a normal for each vertex in the range.
+         * @returns false, if the range is invalid.
+         */
+        bool buildRange(int range, Vector3D *normals);
+
+    private:
+        Weighting _weighting;
+        int _threadCount;
+
+        Mesh *_rangeMesh;
+        int _rangeSize;
+        QVector<int> _rangeOffsets;
+        QVector<int> _rangeTriangles;
+    };
+} // namespace Glee3D
+
+#endif // G3D_NORMALBUILDER_H
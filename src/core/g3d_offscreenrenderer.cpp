@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_offscreenrenderer.h"
+#include "g3d_scene.h"
+#include "g3d_camera.h"
+#include "g3d_entity.h"
+#include "g3d_scenesnapshot.h"
+
+// Qt includes
+#include <QSurfaceFormat>
+
+namespace Glee3D {
+    OffscreenRenderer::OffscreenRenderer(int width, int height)
+        : Logging("OffscreenRenderer") {
+        _width = width;
+        _height = height;
+        _surface = 0;
+        _context = 0;
+        _frameBuffer = 0;
+    }
+
+    OffscreenRenderer::~OffscreenRenderer() {
+        // Everything owning OpenGL objects has to release them while the
+        // context still exists.
+        if(_context && makeCurrent()) {
+            _renderer.releaseResources();
+            delete _frameBuffer;
+            _context->doneCurrent();
+        }
+        delete _context;
+        delete _surface;
+    }
+
+    bool OffscreenRenderer::initialize() {
+        if(_context) {
+            return true;
+        }
+
+        // The renderer relies on the fixed function state of the
+        // compatibility profile.
+        QSurfaceFormat format;
+        format.setProfile(QSurfaceFormat::CompatibilityProfile);
+        format.setDepthBufferSize(24);
+
+        _surface = new QOffscreenSurface();
+        _surface->setFormat(format);
+        _surface->create();
+        if(!_surface->isValid()) {
+            error("Failed creating offscreen surface.");
+            return false;
+        }
+
+        _context = new QOpenGLContext();
+        _context->setFormat(format);
+        if(!_context->create()) {
+            error("Failed creating OpenGL context.");
+            delete _context;
+            _context = 0;
+            return false;
+        }
+
+        if(!makeCurrent()) {
+            return false;
+        }
+
+        _renderer.configureOpenGL();
+        if(!_renderer.initialize()) {
+            return false;
+        }
+
+        _frameBuffer = new FrameBuffer(_width, _height, FrameBuffer::DepthBuffer);
+        return true;
+    }
+
+    bool OffscreenRenderer::makeCurrent() {
+        if(!_context || !_context->makeCurrent(_surface)) {
+            error("Cannot make the OpenGL context current.");
+            return false;
+        }
+        return true;
+    }
+
+    void OffscreenRenderer::doneCurrent() {
+        if(_context) {
+            _context->doneCurrent();
+        }
+    }
+
+    void OffscreenRenderer::moveToThread(QThread *thread) {
+        if(_context) {
+            _context->moveToThread(thread);
+        }
+    }
+
+    bool OffscreenRenderer::render(Scene *scene, Camera *camera) {
+        if(!_frameBuffer || !makeCurrent()) {
+            error("Cannot render before the renderer has been initialized.");
+            return false;
+        }
+
+        SceneSnapshot *snapshot = 0;
+        if(scene) {
+            scene->lockScene();
+            compile(scene);
+            snapshot = SceneSnapshot::capture(scene, camera, 0);
+            scene->unlockScene();
+        }
+
+        glViewport(0, 0, _width, _height);
+        _frameBuffer->clear();
+        _renderer.render(snapshot, _width, _height);
+        _frameBuffer->release();
+        glFinish();
+
+        delete snapshot;
+        if(scene) {
+            scene->deleteDestroyed();
+        }
+        return true;
+    }
+
+    void OffscreenRenderer::compile(Scene *scene) {
+        // Rendering single images, there is nothing to gain from compiling
+        // in the background. Compiling right here also keeps the shared mesh
+        // compiler out of the way of other offscreen renderers.
+        QSet<Entity*> entities = scene->entities();
+        foreach(Entity *entity, entities) {
+            if(!entity->isCompiled()) {
+                entity->compile();
+            }
+        }
+    }
+
+    QImage OffscreenRenderer::image() {
+        if(!_frameBuffer || !makeCurrent()) {
+            return QImage();
+        }
+        return _frameBuffer->image();
+    }
+
+    bool OffscreenRenderer::readPixels(GLubyte *pixels) {
+        if(!_frameBuffer || !makeCurrent()) {
+            return false;
+        }
+        _frameBuffer->readPixels(pixels);
+        return true;
+    }
+
+    int OffscreenRenderer::width() {
+        return _width;
+    }
+
+    int OffscreenRenderer::height() {
+        return _height;
+    }
+
+    FrameBuffer *OffscreenRenderer::frameBuffer() {
+        return _frameBuffer;
+    }
+
+    Renderer& OffscreenRenderer::renderer() {
+        return _renderer;
+    }
+} // namespace Glee3D
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_OFFSCREENRENDERER_H
+#define G3D_OFFSCREENRENDERER_H
+
+// Own includes
+#include "g3d_renderer.h"
+#include "g3d_framebuffer.h"
+#include "g3d_logging.h"
+
+// Qt includes
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QImage>
+#include <QThread>
+
+namespace Glee3D {
+    class Scene;
+    class Camera;
+
+    /**
+      * @class OffscreenRenderer
+      * Renders a scene into a frame buffer without a window, for example to
+      * create thumbnails or to run performance tests on machines without a
+      * display. It creates its own OpenGL context on an offscreen surface,
+      * which Qt backs with a pbuffer or a surfaceless EGL context, so it
+      * also works with software drivers like Mesa's llvmpipe. On headless
+      * machines, run with QT_QPA_PLATFORM=offscreen.
+      *
+      * A QGuiApplication has to exist, and initialize() has to be called on
+      * the GUI thread, because some platforms can only create surfaces
+      * there. To render on another thread, call moveToThread() afterwards.
+      * Several offscreen renderers may run on different threads at the same
+      * time, as long as each renders its own scene. Compiled meshes are
+      * stored in the entities, and the active program is tracked per
+      * context, see Program::current().
+      */
+    class OffscreenRenderer :
+        public Logging {
+    public:
+        /**
+         * Creates a new offscreen renderer, that has to be initialized.
+         * @param width Width of the rendered images.
+         * @param height Height of the rendered images.
+         */
+        OffscreenRenderer(int width, int height);
+
+        /** Destructor. */
+        ~OffscreenRenderer();
+
+        /**
+         * Creates the OpenGL context and the frame buffer.
+         * @returns false, if no OpenGL context could be created.
+         */
+        bool initialize();
+
+        /** Makes the OpenGL context of this renderer current. */
+        bool makeCurrent();
+
+        /** Releases the OpenGL context of this renderer. */
+        void doneCurrent();
+
+        /**
+         * Hands the OpenGL context over to the given thread. The context must
+         * not be current, and the renderer must be used on that thread only
+         * from now on.
+         */
+        void moveToThread(QThread *thread);
+
+        /**
+         * Renders the given scene as seen by the given camera. Entities that
+         * have not been compiled yet are compiled first, so that the image
+         * is complete. The scene is locked while its state is captured.
+         * @returns false, if the renderer has not been initialized.
+         */
+        bool render(Scene *scene, Camera *camera);
+
+        /** @returns a copy of the last rendered image. */
+        QImage image();
+
+        /**
+         * Reads back the last rendered image.
+         * @param pixels Receives width() * height() pixels as 8 bit RGBA,
+         * starting with the bottom row.
+         */
+        bool readPixels(GLubyte *pixels);
+
+        /** @returns the width of the rendered images. */
+        int width();
+
+        /** @returns the height of the rendered images. */
+        int height();
+
+        /** @returns the frame buffer images are rendered to. */
+        FrameBuffer *frameBuffer();
+
+        /** @returns the renderer drawing the scene. */
+        Renderer& renderer();
+
+    private:
+        /** Compiles all entities of the scene that are not compiled yet. */
+        void compile(Scene *scene);
+
+        int _width;
+        int _height;
+        QOffscreenSurface *_surface;
+        QOpenGLContext *_context;
+        FrameBuffer *_frameBuffer;
+        Renderer _renderer;
+    };
+} // namespace Glee3D
+
+#endif // G3D_OFFSCREENRENDERER_H
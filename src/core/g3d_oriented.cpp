@@ -36,6 +36,7 @@ namespace Glee3D {
 
     void Oriented::setRotation(Vector3D value) {
         _rotationAnglesAroundAxis = value;
+        rotationChanged();
     }
 
     void Oriented::rotate(Vector3D delta) {
@@ -43,30 +44,37 @@ namespace Glee3D {
         _rotationAnglesAroundAxis.setX(Utilities::limitDegrees(_rotationAnglesAroundAxis.x()));
         _rotationAnglesAroundAxis.setY(Utilities::limitDegrees(_rotationAnglesAroundAxis.y()));
         _rotationAnglesAroundAxis.setZ(Utilities::limitDegrees(_rotationAnglesAroundAxis.z()));
+        rotationChanged();
     }
 
     void Oriented::rotateAroundXAxis(double delta) {
         _rotationAnglesAroundAxis.setX(Utilities::limitDegrees(_rotationAnglesAroundAxis.x() + delta));
+        rotationChanged();
     }
 
     void Oriented::rotateAroundYAxis(double delta) {
         _rotationAnglesAroundAxis.setY(Utilities::limitDegrees(_rotationAnglesAroundAxis.y() + delta));
+        rotationChanged();
     }
 
     void Oriented::rotateAroundZAxis(double delta) {
         _rotationAnglesAroundAxis.setZ(Utilities::limitDegrees(_rotationAnglesAroundAxis.z() + delta));
+        rotationChanged();
     }
 
     void Oriented::setRotationAroundXAxis(double rotationAroundXAxis) {
         _rotationAnglesAroundAxis.setX(Utilities::limitDegrees(rotationAroundXAxis));
+        rotationChanged();
     }
 
     void Oriented::setRotationAroundYAxis(double rotationAroundYAxis) {
         _rotationAnglesAroundAxis.setY(Utilities::limitDegrees(rotationAroundYAxis));
+        rotationChanged();
     }
 
     void Oriented::setRotationAroundZAxis(double rotationAroundZAxis) {
         _rotationAnglesAroundAxis.setZ(Utilities::limitDegrees(rotationAroundZAxis));
+        rotationChanged();
     }
 
     Vector3D Oriented::rotation() {
@@ -102,4 +110,7 @@ namespace Glee3D {
             .withRotation(_rotationAnglesAroundAxis);
     }
 
+    void Oriented::rotationChanged() {
+    }
+
 } // namespace Glee3D
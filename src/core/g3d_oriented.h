@@ -77,6 +77,9 @@ namespace Glee3D {
         Matrix4x4 rotationMatrix();
 
     protected:
+        /** Called whenever the rotation has been changed. */
+        virtual void rotationChanged();
+
         /** This property holds the rotation for the x, y and z axis in degrees. */
         Vector3D _rotationAnglesAroundAxis;
     };
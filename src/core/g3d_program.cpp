@@ -20,21 +20,86 @@
 
 // Own includes
 #include "g3d_program.h"
+#include "g3d_vertex.h"
+#include "g3d_rendercounters.h"
 
 // Qt includes
 #include <QFile>
 #include <QResource>
+#include <QOpenGLContext>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
 
 // Standard includes
 #include <iostream>
 
 namespace Glee3D {
 
+namespace {
+    /** Programs inserted last, by the OpenGL context they were inserted into. */
+    QHash<QOpenGLContext*, Program*> currentPrograms;
+    QMutex currentProgramsMutex;
+
+    /** Computes the matrix transforming normals with the upper 3x3 part of
+      * the given column-major matrix, ie. its inverse transpose up to scale.
+      * The columns are the cross products of the other two columns. */
+    void normalMatrix(const GLfloat *m, GLfloat *n) {
+        const GLfloat *c0 = m;
+        const GLfloat *c1 = m + 4;
+        const GLfloat *c2 = m + 8;
+        const GLfloat *columns[3][2] = { { c1, c2 }, { c2, c0 }, { c0, c1 } };
+        for(int i = 0; i < 3; i++) {
+            const GLfloat *a = columns[i][0];
+            const GLfloat *b = columns[i][1];
+            n[i * 3 + 0] = a[1] * b[2] - a[2] * b[1];
+            n[i * 3 + 1] = a[2] * b[0] - a[0] * b[2];
+            n[i * 3 + 2] = a[0] * b[1] - a[1] * b[0];
+        }
+
+        // Mirroring transforms must not turn normals inside out.
+        GLfloat determinant = c0[0] * n[0] + c0[1] * n[1] + c0[2] * n[2];
+        if(determinant < 0.0f) {
+            for(int i = 0; i < 9; i++) {
+                n[i] = -n[i];
+            }
+        }
+    }
+}
+
 Program::Program()
     : Logging("Program") {
     _glProgram = 0;
     _glVertexShader = 0;
     _glFragmentShader = 0;
+    _normalMatrixUniformLocation = -1;
+}
+
+Program::~Program() {
+    // A program that is gone must not be reported as current anymore.
+    QMutexLocker locker(&currentProgramsMutex);
+    QList<QOpenGLContext*> contexts = currentPrograms.keys(this);
+    foreach(QOpenGLContext *context, contexts) {
+        currentPrograms.remove(context);
+    }
+}
+
+void Program::release() {
+    if(current() == this) {
+        eject();
+    }
+    if(_glProgram) {
+        glDeleteProgram(_glProgram);
+        _glProgram = 0;
+    }
+    if(_glVertexShader) {
+        glDeleteShader(_glVertexShader);
+        _glVertexShader = 0;
+    }
+    if(_glFragmentShader) {
+        glDeleteShader(_glFragmentShader);
+        _glFragmentShader = 0;
+    }
 }
 
 bool Program::build(QString vertexShaderFileName, QString fragmentShaderFileName) {
@@ -138,6 +203,17 @@ bool Program::link() {
     if(_glFragmentShader) {
         glAttachShader(_glProgram, _glFragmentShader);
     }
+
+    // Compressed vertex attributes must be at the locations the compiled
+    // meshes upload them to.
+    glBindAttribLocation(_glProgram, CompressedVertex::PositionAttribute, "g3d_CompressedPosition");
+    glBindAttribLocation(_glProgram, CompressedVertex::NormalAttribute, "g3d_CompressedNormal");
+    glBindAttribLocation(_glProgram, CompressedVertex::TexCoordAttribute, "g3d_CompressedTexCoord");
+
+    // Same for the instance attributes of instanced drawing.
+    glBindAttribLocation(_glProgram, InstanceAttributes::ModelViewMatrixAttribute, "g3d_InstanceModelViewMatrix");
+    glBindAttribLocation(_glProgram, InstanceAttributes::EmissionAttribute, "g3d_InstanceEmission");
+
     glLinkProgram(_glProgram);
     glGetProgramiv(_glProgram, GL_LINK_STATUS, &success);
     if(!success) {
@@ -151,12 +227,33 @@ bool Program::link() {
 
 void Program::insert() {
     glUseProgram(_glProgram);
+    G3D_COUNT_PROGRAM_SWITCH();
     _projectionMatrixUniformLocation = glUniformLocation("g3d_ProjectionMatrix");
     _modelViewMatrixUniformLocation = glUniformLocation("g3d_ModelViewMatrix");
+    _normalMatrixUniformLocation = glUniformLocation("g3d_NormalMatrix");
+    _compressedVerticesUniformLocation = glUniformLocation("g3d_CompressedVertices");
+    _positionOffsetUniformLocation = glUniformLocation("g3d_PositionOffset");
+    _positionScaleUniformLocation = glUniformLocation("g3d_PositionScale");
+    _texCoordOffsetUniformLocation = glUniformLocation("g3d_TexCoordOffset");
+    _texCoordScaleUniformLocation = glUniformLocation("g3d_TexCoordScale");
+    currentProgramsMutex.lock();
+    currentPrograms.insert(QOpenGLContext::currentContext(), this);
+    currentProgramsMutex.unlock();
+    resetVertexDecoding();
 }
 
 void Program::eject() {
     glUseProgram(0);
+    QMutexLocker locker(&currentProgramsMutex);
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    if(currentPrograms.value(context) == this) {
+        currentPrograms.remove(context);
+    }
+}
+
+Program *Program::current() {
+    QMutexLocker locker(&currentProgramsMutex);
+    return currentPrograms.value(QOpenGLContext::currentContext());
 }
 
 QString Program::vertexShaderSource() {
@@ -185,10 +282,39 @@ int Program::glUniformLocation(QString name) {
 
 void Program::setModelViewMatrix(Matrix4x4 modelViewMatrix) {
     glUniformMatrix4fv(_modelViewMatrixUniformLocation, 1, GL_FALSE, modelViewMatrix.asGlFloatPointer());
+    G3D_COUNT_UNIFORM_UPLOADS(1);
+    if(_normalMatrixUniformLocation >= 0) {
+        GLfloat normals[9];
+        normalMatrix(modelViewMatrix.asGlFloatPointer(), normals);
+        glUniformMatrix3fv(_normalMatrixUniformLocation, 1, GL_FALSE, normals);
+        G3D_COUNT_UNIFORM_UPLOADS(1);
+    }
 }
 
 void Program::setProjectionMatrix(Matrix4x4 projectionMatrix) {
     glUniformMatrix4fv(_projectionMatrixUniformLocation, 1, GL_FALSE, projectionMatrix.asGlFloatPointer());
+    G3D_COUNT_UNIFORM_UPLOADS(1);
+}
+
+void Program::setCompressedVertexDecoding(Vector3D positionOffset,
+                                          Vector3D positionScale,
+                                          Vector2D texCoordOffset,
+                                          Vector2D texCoordScale) {
+    glUniform1i(_compressedVerticesUniformLocation, 1);
+    glUniform3f(_positionOffsetUniformLocation,
+                (GLfloat)positionOffset.x(), (GLfloat)positionOffset.y(), (GLfloat)positionOffset.z());
+    glUniform3f(_positionScaleUniformLocation,
+                (GLfloat)positionScale.x(), (GLfloat)positionScale.y(), (GLfloat)positionScale.z());
+    glUniform2f(_texCoordOffsetUniformLocation,
+                (GLfloat)texCoordOffset.x(), (GLfloat)texCoordOffset.y());
+    glUniform2f(_texCoordScaleUniformLocation,
+                (GLfloat)texCoordScale.x(), (GLfloat)texCoordScale.y());
+    G3D_COUNT_UNIFORM_UPLOADS(5);
+}
+
+void Program::resetVertexDecoding() {
+    glUniform1i(_compressedVerticesUniformLocation, 0);
+    G3D_COUNT_UNIFORM_UPLOADS(1);
 }
 
 } // namespace Glee3D
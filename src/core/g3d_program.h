@@ -24,6 +24,8 @@
 // Own includes
 #include "g3d_logging.h"
 #include "math/g3d_matrix4x4.h"
+#include "math/g3d_vector2d.h"
+#include "math/g3d_vector3d.h"
 
 // Qt includes
 #include <QString>
@@ -51,8 +53,17 @@ public:
     /** Creates a new shading program. */
     Program();
 
+    /** Destructor. */
+    ~Program();
+
     bool build(QString vertexShaderFileName, QString fragmentShaderFileName);
 
+    /**
+      * Deletes the OpenGL program and its shaders. The context the program
+      * has been built in has to be current.
+      */
+    void release();
+
     /**
       * Compiles the given source code written in GLSL for the
       * given shader type.
@@ -78,6 +89,11 @@ public:
       */
     void eject();
 
+    /** @returns the program that has been inserted last into the current
+      * OpenGL context, or null. Each context keeps track of its own, so
+      * several contexts may render on different threads. */
+    static Program *current();
+
     /** @returns the current vertex shader source. */
     QString vertexShaderSource();
 
@@ -98,7 +114,9 @@ public:
 
     /**
      * Sets the modelview matrix as a uniform. It will be available
-     * in the shader as the uniform mat4 g3d_ModelViewMatrix.
+     * in the shader as the uniform mat4 g3d_ModelViewMatrix. The matrix
+     * for transforming normals into eye space is available as the uniform
+     * mat3 g3d_NormalMatrix, its columns are not normalized.
      */
     void setModelViewMatrix(Matrix4x4 modelViewMatrix);
 
@@ -108,13 +126,34 @@ public:
      */
     void setProjectionMatrix(Matrix4x4 projectionMatrix);
 
+    /**
+     * Tells the shader to read compressed vertices from the generic
+     * attributes given by CompressedVertex and decode them with the given
+     * bounds. Available in the shader as g3d_CompressedVertices,
+     * g3d_PositionOffset, g3d_PositionScale, g3d_TexCoordOffset and
+     * g3d_TexCoordScale.
+     */
+    void setCompressedVertexDecoding(Vector3D positionOffset,
+                                     Vector3D positionScale,
+                                     Vector2D texCoordOffset,
+                                     Vector2D texCoordScale);
+
+    /** Tells the shader to read uncompressed vertices again. */
+    void resetVertexDecoding();
+
 private:
     int _glProgram;
     int _glVertexShader;
     int _glFragmentShader;
 
     int _modelViewMatrixUniformLocation;
+    int _normalMatrixUniformLocation;
     int _projectionMatrixUniformLocation;
+    int _compressedVerticesUniformLocation;
+    int _positionOffsetUniformLocation;
+    int _positionScaleUniformLocation;
+    int _texCoordOffsetUniformLocation;
+    int _texCoordScaleUniformLocation;
 
     QString _vertexShaderSource;
     QString _fragmentShaderSource;
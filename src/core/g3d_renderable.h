@@ -21,6 +21,9 @@
 #ifndef G3D_RENDERABLE_H
 #define G3D_RENDERABLE_H
 
+// Qt includes
+#include <QAtomicInt>
+
 /**
  *
  */
@@ -57,8 +60,26 @@ namespace Glee3D {
 
         virtual void render(RenderMode renderMode = Renderable::Textured) = 0;
 
+        /** Counts a SceneSnapshot referencing this object. */
+        void retainForSnapshot() {
+            _snapshotReferences.ref();
+        }
+
+        /** Uncounts a SceneSnapshot referencing this object. */
+        void releaseFromSnapshot() {
+            _snapshotReferences.deref();
+        }
+
+        /** @returns true, if a SceneSnapshot still references this object. */
+        bool referencedBySnapshot() {
+            return _snapshotReferences.load() != 0;
+        }
+
     protected:
         bool _visible;
+
+    private:
+        QAtomicInt _snapshotReferences;
     };
 
 } // namespace Glee3D
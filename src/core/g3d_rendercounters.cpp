@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_rendercounters.h"
+
+// Qt includes
+#include <QThreadStorage>
+
+namespace Glee3D {
+    namespace {
+        QThreadStorage<RenderCounters::Counters> threadCounters;
+    }
+
+    RenderCounters::Counters::Counters() {
+        _drawCalls = 0;
+        _triangles = 0;
+        _bufferBinds = 0;
+        _textureBinds = 0;
+        _programSwitches = 0;
+        _uniformUploads = 0;
+        _materialCalls = 0;
+        _lightCalls = 0;
+    }
+
+    void RenderCounters::reset() {
+#ifdef DEBUG
+        counters() = Counters();
+#endif
+    }
+
+    RenderCounters::Counters RenderCounters::current() {
+#ifdef DEBUG
+        return counters();
+#else
+        return Counters();
+#endif
+    }
+
+    void RenderCounters::countDrawCall(qint64 triangles) {
+        Counters& c = counters();
+        c._drawCalls++;
+        c._triangles += triangles;
+    }
+
+    void RenderCounters::countBufferBinds(int count) {
+        counters()._bufferBinds += count;
+    }
+
+    void RenderCounters::countTextureBinds(int count) {
+        counters()._textureBinds += count;
+    }
+
+    void RenderCounters::countProgramSwitch() {
+        counters()._programSwitches++;
+    }
+
+    void RenderCounters::countUniformUploads(int count) {
+        counters()._uniformUploads += count;
+    }
+
+    void RenderCounters::countMaterialCalls(int count) {
+        counters()._materialCalls += count;
+    }
+
+    void RenderCounters::countLightCalls(int count) {
+        counters()._lightCalls += count;
+    }
+
+    RenderCounters::Counters& RenderCounters::counters() {
+        return threadCounters.localData();
+    }
+} // namespace Glee3D
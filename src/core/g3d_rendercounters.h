@@ -0,0 +1,104 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_RENDERCOUNTERS_H
+#define G3D_RENDERCOUNTERS_H
+
+// Qt includes
+#include <QtGlobal>
+
+namespace Glee3D {
+    /**
+      * @class RenderCounters
+      * Counts the OpenGL calls issued while rendering, so that the effect of
+      * batching and sorting can be verified. Counters are kept per thread,
+      * since each render thread has its own context.
+      *
+      * Counting is only compiled into debug builds. Use the G3D_COUNT_*
+      * macros below, which expand to nothing in release builds, where
+      * current() always returns zero counts.
+      */
+    class RenderCounters {
+    public:
+        /** Counts of OpenGL calls since the last reset(). */
+        struct Counters {
+            Counters();
+
+            int _drawCalls;
+            qint64 _triangles;
+            int _bufferBinds;
+            int _textureBinds;
+            int _programSwitches;
+            int _uniformUploads;
+            int _materialCalls;
+            int _lightCalls;
+        };
+
+        /** Sets the counters of the calling thread to zero. */
+        static void reset();
+
+        /** @returns the counters of the calling thread. */
+        static Counters current();
+
+        /** Counts a draw call submitting the given number of triangles. */
+        static void countDrawCall(qint64 triangles);
+
+        /** Counts buffer or vertex array binds. */
+        static void countBufferBinds(int count);
+
+        /** Counts texture binds. */
+        static void countTextureBinds(int count);
+
+        /** Counts a program switch. */
+        static void countProgramSwitch();
+
+        /** Counts uniform uploads. */
+        static void countUniformUploads(int count);
+
+        /** Counts glMaterial calls. */
+        static void countMaterialCalls(int count);
+
+        /** Counts glLight calls. */
+        static void countLightCalls(int count);
+
+    private:
+        static Counters& counters();
+    };
+} // namespace Glee3D
+
+#ifdef DEBUG
+#define G3D_COUNT_DRAW_CALL(triangles) Glee3D::RenderCounters::countDrawCall(triangles)
+#define G3D_COUNT_BUFFER_BINDS(count) Glee3D::RenderCounters::countBufferBinds(count)
+#define G3D_COUNT_TEXTURE_BINDS(count) Glee3D::RenderCounters::countTextureBinds(count)
+#define G3D_COUNT_PROGRAM_SWITCH() Glee3D::RenderCounters::countProgramSwitch()
+#define G3D_COUNT_UNIFORM_UPLOADS(count) Glee3D::RenderCounters::countUniformUploads(count)
+#define G3D_COUNT_MATERIAL_CALLS(count) Glee3D::RenderCounters::countMaterialCalls(count)
+#define G3D_COUNT_LIGHT_CALLS(count) Glee3D::RenderCounters::countLightCalls(count)
+#else
+#define G3D_COUNT_DRAW_CALL(triangles) do {} while(0)
+#define G3D_COUNT_BUFFER_BINDS(count) do {} while(0)
+#define G3D_COUNT_TEXTURE_BINDS(count) do {} while(0)
+#define G3D_COUNT_PROGRAM_SWITCH() do {} while(0)
+#define G3D_COUNT_UNIFORM_UPLOADS(count) do {} while(0)
+#define G3D_COUNT_MATERIAL_CALLS(count) do {} while(0)
+#define G3D_COUNT_LIGHT_CALLS(count) do {} while(0)
+#endif
+
+#endif // G3D_RENDERCOUNTERS_H
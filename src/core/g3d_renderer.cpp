@@ -0,0 +1,277 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_renderer.h"
+#include "g3d_skybox.h"
+#include "g3d_terrain.h"
+#include "g3d_entity.h"
+#include "g3d_meshcompiler.h"
+
+namespace Glee3D {
+    Renderer::Renderer()
+        : Logging("Renderer") {
+        _frameProfiler = 0;
+        _skyBoxProgramBuilt = false;
+        _drawnEntityCount = 0;
+        _culledEntityCount = 0;
+    }
+
+    void Renderer::configureOpenGL() {
+        // Disable normalization since we will precalculate our normals.
+        glDisable(GL_NORMALIZE);
+        // Disable the default OpenGL lightning because we will provide our own
+        glDisable(GL_LIGHTING);
+
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+        glEnable(GL_SMOOTH);
+        glEnable(GL_POINT_SMOOTH);
+        glEnable(GL_LINE_SMOOTH);
+        glEnable(GL_POLYGON_SMOOTH);
+        glEnable(GL_TEXTURE_2D);
+        glEnable(GL_BLEND);
+
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        glPointSize(1.0);
+        glLineWidth(1.0);
+    }
+
+    bool Renderer::initialize() {
+        information("Building per pixel renderer.");
+        if(!_renderProgram.build(":/shaders/glsl/perpixellighting.vert.glsl",
+                                 ":/shaders/glsl/perpixellighting.frag.glsl")) {
+           error("Failed building GL render program.");
+           return false;
+        }
+
+        information("Building instanced per pixel renderer.");
+        if(_instancedRenderProgram.build(":/shaders/glsl/perpixellighting.instanced.vert.glsl",
+                                         ":/shaders/glsl/perpixellighting.frag.glsl")) {
+            _renderQueue.setInstancingProgram(&_instancedRenderProgram);
+        } else {
+            warning("Failed building instanced GL render program, drawing entities one by one.");
+        }
+
+        information("Building skybox renderer.");
+        _skyBoxProgramBuilt = _skyBoxProgram.build(":/shaders/glsl/skybox.vert.glsl",
+                                                   ":/shaders/glsl/skybox.frag.glsl");
+        if(!_skyBoxProgramBuilt) {
+            warning("Failed building skybox program, skyboxes will not be drawn.");
+        }
+        return true;
+    }
+
+    void Renderer::releaseResources() {
+        _renderQueue.setInstancingProgram(0);
+        _renderQueue.releaseResources();
+        _renderProgram.release();
+        _instancedRenderProgram.release();
+        _skyBoxProgram.release();
+        _skyBoxProgramBuilt = false;
+    }
+
+    void Renderer::render(SceneSnapshot *snapshot, int width, int height) {
+        MeshCompiler::instance().uploadFinished();
+        _renderProgram.insert();
+        _drawnEntityCount = 0;
+        _culledEntityCount = 0;
+        if(!snapshot || !snapshot->hasCamera()) {
+            return;
+        }
+
+        Camera camera = snapshot->camera();
+        camera.setAspectRatio(width, height);
+        Matrix4x4 cameraProjectionMatrix = camera.projectionMatrix();
+        Matrix4x4 cameraModelViewMatrix = camera.modelviewMatrix();
+
+        if(_renderQueue.instancingProgram()) {
+            _instancedRenderProgram.insert();
+            _instancedRenderProgram.setProjectionMatrix(cameraProjectionMatrix);
+            _renderProgram.insert();
+        }
+        _renderProgram.setProjectionMatrix(cameraProjectionMatrix);
+
+        {
+            FrameProfiler::ScopedPass pass(_frameProfiler, FrameProfiler::LightsPass);
+            QVector<LightSource>& lightSources = snapshot->lightSources();
+            int i = 0;
+            for(int l = 0; l < lightSources.size(); l++) {
+                lightSources[l].activate(GL_LIGHT0 + i);
+                i++;
+                if(i > 7) {
+                    i = 7;
+                    // TODO: Decide which light sources to use in order
+                    // to exceed OpenGLs limit of only eight light sources.
+
+                    // TODO: This should be handled by own shaders.
+                }
+            }
+        }
+
+        // Render terrains.
+        {
+            FrameProfiler::ScopedPass pass(_frameProfiler, FrameProfiler::TerrainPass);
+            // Pixels covered by one unit at a distance of one unit.
+            double projectionScale = cameraProjectionMatrix.value(1, 1) * height / 2.0;
+            foreach(SceneSnapshot::TerrainState terrain, snapshot->terrains()) {
+                Matrix4x4 terrainModelViewMatrix = terrain._translationMatrix.multiplicate(cameraModelViewMatrix);
+                Vector3D translation = terrain._translationMatrix.multiplicate(Vector4D(0.0, 0.0, 0.0, 1.0)).toVector3D();
+
+                // Chunks are selected in terrain space.
+                Frustum terrainFrustum(terrainModelViewMatrix, cameraProjectionMatrix);
+                terrain._terrain->selectChunks(terrainFrustum, camera.position() - translation, projectionScale);
+
+                _renderProgram.setModelViewMatrix(terrainModelViewMatrix);
+                terrain._terrain->render();
+            }
+        }
+
+        // Render objects.
+        {
+            FrameProfiler::ScopedPass pass(_frameProfiler, FrameProfiler::EntitiesPass);
+            Frustum frustum(cameraModelViewMatrix, cameraProjectionMatrix);
+            renderEntities(snapshot, camera, frustum, cameraModelViewMatrix);
+            _renderQueue.renderOpaque();
+        }
+
+        // The skybox is only visible where no opaque geometry has been drawn,
+        // the depth test rejects everything else early.
+        SkyBox *s = snapshot->skyBox();
+        if(s && _skyBoxProgramBuilt) {
+            FrameProfiler::ScopedPass pass(_frameProfiler, FrameProfiler::SkyBoxPass);
+            Matrix4x4 skyBoxModelViewMatrix = cameraModelViewMatrix;
+            skyBoxModelViewMatrix.setTranslation(Vector3D(0.0, 0.0, 0.0));
+            _skyBoxProgram.insert();
+            _skyBoxProgram.setProjectionMatrix(cameraProjectionMatrix);
+            _skyBoxProgram.setModelViewMatrix(skyBoxModelViewMatrix);
+            s->render();
+            _renderProgram.insert();
+        }
+
+        {
+            FrameProfiler::ScopedPass pass(_frameProfiler, FrameProfiler::TranslucentPass);
+            _renderQueue.renderTranslucent();
+        }
+        if(Program::current() != &_renderProgram) {
+            _renderProgram.insert();
+        }
+    }
+
+    Program& Renderer::renderProgram() {
+        return _renderProgram;
+    }
+
+    int Renderer::drawnEntityCount() {
+        return _drawnEntityCount;
+    }
+
+    int Renderer::culledEntityCount() {
+        return _culledEntityCount;
+    }
+
+    RenderQueue& Renderer::renderQueue() {
+        return _renderQueue;
+    }
+
+    void Renderer::setFrameProfiler(FrameProfiler *frameProfiler) {
+        _frameProfiler = frameProfiler;
+    }
+
+    FrameProfiler *Renderer::frameProfiler() {
+        return _frameProfiler;
+    }
+
+    void Renderer::renderEntities(SceneSnapshot *snapshot,
+                                  Camera& camera,
+                                  const Frustum& frustum,
+                                  Matrix4x4 cameraModelViewMatrix) {
+        const QVector<SceneSnapshot::EntityState>& entities = snapshot->entities();
+        int count = entities.size();
+
+        // Bounding spheres depend on the compiled meshes, which are compiled
+        // while rendering, so they are not part of the snapshot.
+        QVector<BoundingSphere> spheres(count);
+        QVector<BoundingSphere> hierarchySpheres(count);
+        QVector<bool> hierarchyKnown(count);
+        for(int i = 0; i < count; i++) {
+            const SceneSnapshot::EntityState& state = entities[i];
+            spheres[i] = state._entity->boundingSphere().transformed(state._worldMatrix);
+            hierarchySpheres[i] = spheres[i];
+            hierarchyKnown[i] = !(state._entity->mesh() && spheres[i].isEmpty());
+        }
+
+        // Children are stored after their parents, so walking backwards
+        // completes each hierarchy before it is merged into its parent.
+        for(int i = count - 1; i >= 0; i--) {
+            int parent = entities[i]._parent;
+            if(parent >= 0) {
+                hierarchySpheres[parent].extend(hierarchySpheres[i]);
+                hierarchyKnown[parent] = hierarchyKnown[parent] && hierarchyKnown[i];
+            }
+        }
+
+        // Once a hierarchy is known to be completely inside, none of its
+        // entities has to be tested again.
+        int insideEnd = 0;
+        int i = 0;
+        while(i < count) {
+            const SceneSnapshot::EntityState& state = entities[i];
+            bool insideFrustum = i < insideEnd;
+            if(!insideFrustum && hierarchyKnown[i]) {
+                Frustum::Classification classification = frustum.classify(hierarchySpheres[i]);
+                if(classification == Frustum::Outside) {
+                    _culledEntityCount += state._subtreeEnd - i;
+                    i = state._subtreeEnd;
+                    continue;
+                }
+                if(classification == Frustum::Inside) {
+                    insideEnd = state._subtreeEnd;
+                    insideFrustum = true;
+                }
+            }
+
+            // Entities that have not been compiled yet have an empty sphere
+            // and are always rendered, so that compiling gets started.
+            if(insideFrustum || frustum.classify(spheres[i]) != Frustum::Outside) {
+                if(state._visible) {
+                    Entity *entity = state._entity;
+                    entity->updateLevelOfDetail(&camera, spheres[i]);
+
+                    Matrix4x4 worldMatrix = state._worldMatrix;
+                    Vector3D center = worldMatrix.multiplicate(Vector4D(0.0, 0.0, 0.0, 1.0)).toVector3D();
+                    if(!spheres[i].isEmpty()) {
+                        center = spheres[i]._center;
+                    }
+
+                    _renderQueue.append(entity,
+                                        snapshot->material(state._material),
+                                        &_renderProgram,
+                                        worldMatrix.multiplicate(cameraModelViewMatrix),
+                                        (center - camera.position()).length());
+                    _drawnEntityCount++;
+                }
+            } else {
+                _culledEntityCount++;
+            }
+            i++;
+        }
+    }
+} // namespace Glee3D
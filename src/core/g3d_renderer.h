@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_RENDERER_H
+#define G3D_RENDERER_H
+
+// Own includes
+#include "g3d_program.h"
+#include "g3d_camera.h"
+#include "g3d_logging.h"
+#include "g3d_frameprofiler.h"
+#include "g3d_renderqueue.h"
+#include "g3d_scenesnapshot.h"
+#include "math/g3d_frustum.h"
+
+namespace Glee3D {
+    /**
+      * @class Renderer
+      * Draws a SceneSnapshot into the current render target. The renderer
+      * does not know about windows, so it is shared by the Display and the
+      * OffscreenRenderer. All methods have to be called with the OpenGL
+      * context current that the renderer has been initialized with.
+      */
+    class Renderer :
+        public Logging {
+    public:
+        /** Creates a new renderer, that has to be initialized. */
+        Renderer();
+
+        /** Sets the OpenGL default parameters the renderer works with. */
+        void configureOpenGL();
+
+        /**
+         * Builds the shader programs.
+         * @returns false, if the render program could not be built.
+         */
+        bool initialize();
+
+        /**
+         * Deletes the shader programs and the buffers of the render queue.
+         * The context the renderer has been initialized in has to be
+         * current, so this has to be called before it is destroyed.
+         */
+        void releaseResources();
+
+        /**
+         * Renders the given snapshot as seen by its camera. The caller has to
+         * target and clear the frame buffer. The skybox is drawn after
+         * opaque and before translucent geometry.
+         * @param snapshot The snapshot to render, may be 0.
+         * @param width Width of the render target.
+         * @param height Height of the render target.
+         */
+        void render(SceneSnapshot *snapshot, int width, int height);
+
+        /** @returns the program everything is rendered with by default. */
+        Program& renderProgram();
+
+        /** @returns the number of entities drawn in the last frame. */
+        int drawnEntityCount();
+
+        /** @returns the number of entities skipped in the last frame, because
+          * they were outside of the viewing frustum. */
+        int culledEntityCount();
+
+        /** @returns the render queue entities are drawn with. */
+        RenderQueue& renderQueue();
+
+        /**
+         * Sets the profiler the render passes are timed with.
+         * @param frameProfiler The profiler, 0 disables profiling.
+         */
+        void setFrameProfiler(FrameProfiler *frameProfiler);
+
+        /** @returns the profiler the render passes are timed with, if any. */
+        FrameProfiler *frameProfiler();
+
+    private:
+        /** Queues the entities of the given snapshot for rendering,
+          * skipping whole hierarchies outside of the viewing frustum. */
+        void renderEntities(SceneSnapshot *snapshot,
+                            Camera& camera,
+                            const Frustum& frustum,
+                            Matrix4x4 cameraModelViewMatrix);
+
+        Program _renderProgram;
+        Program _instancedRenderProgram;
+        Program _skyBoxProgram;
+        bool _skyBoxProgramBuilt;
+        RenderQueue _renderQueue;
+        FrameProfiler *_frameProfiler;
+
+        int _drawnEntityCount;
+        int _culledEntityCount;
+    };
+} // namespace Glee3D
+
+#endif // G3D_RENDERER_H
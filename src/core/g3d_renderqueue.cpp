@@ -0,0 +1,469 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_renderqueue.h"
+#include "g3d_entity.h"
+#include "g3d_compiledmesh.h"
+#include "g3d_material.h"
+#include "g3d_program.h"
+#include "g3d_texturestore.h"
+#include "g3d_rendercounters.h"
+
+// Standard includes
+#include <string.h>
+
+namespace Glee3D {
+    namespace {
+        /** Bit layout of the sort keys, from the most significant bit. */
+        const int translucentShift  = 63;
+
+        // Opaque items: program, texture, material, mesh, depth
+        const int programBits       = 7;
+        const int textureBits       = 12;
+        const int materialBits      = 12;
+        const int meshBits          = 12;
+        const int opaqueDepthBits   = 20;
+
+        // Translucent items: depth, program, texture, material
+        const int translucentDepthBits = 31;
+
+        /** Runs of fewer items are not worth an instanced draw call. */
+        const int minimumInstanceCount = 4;
+
+        /** @returns the bits of a non-negative float, which sort like the value. */
+        quint32 depthBits(double depth) {
+            float value = depth > 0.0 ? (float)depth : 0.0f;
+            quint32 bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return bits & 0x7fffffff;
+        }
+
+        quint64 field(int value, int bits) {
+            return (quint64)value & ((Q_UINT64_C(1) << bits) - 1);
+        }
+    }
+
+    RenderQueue::RenderQueue()
+        : Logging("RenderQueue") {
+        _sortingEnabled = true;
+        _instancingProgram = 0;
+        _instanceBufferHandle = 0;
+        memset(&_statistics, 0, sizeof(_statistics));
+    }
+
+    RenderQueue::~RenderQueue() {
+        releaseResources();
+    }
+
+    void RenderQueue::releaseResources() {
+        if(_instanceBufferHandle) {
+            glDeleteBuffers(1, &_instanceBufferHandle);
+            _instanceBufferHandle = 0;
+        }
+    }
+
+    void RenderQueue::setSortingEnabled(bool on) {
+        _sortingEnabled = on;
+    }
+
+    bool RenderQueue::sortingEnabled() {
+        return _sortingEnabled;
+    }
+
+    void RenderQueue::setInstancingProgram(Program *program) {
+        _instancingProgram = program;
+    }
+
+    Program *RenderQueue::instancingProgram() {
+        return _instancingProgram;
+    }
+
+    void RenderQueue::append(Entity *entity, Material *material, Program *program, Matrix4x4 modelViewMatrix, double depth) {
+        if(!entity) {
+            return;
+        }
+
+        if(!entity->isCompiled()) {
+            entity->compileAsynchronously();
+        }
+
+        CompiledMesh *compiledMesh = entity->currentCompiledMesh();
+        if(!compiledMesh) {
+            return;
+        }
+
+        Item item;
+        item._compiledMesh = compiledMesh;
+        item._material = material;
+        item._program = program;
+        item._modelViewMatrix = modelViewMatrix;
+        item._materialIdentifier = materialIdentifier(item._material);
+        item._translucent = item._material && item._material->isTranslucent();
+
+        SortEntry entry;
+        entry._key = sortKey(item, depth);
+        entry._item = _items.size();
+        _items.append(item);
+        _sortEntries.append(entry);
+    }
+
+    void RenderQueue::clear() {
+        _items.clear();
+        _sortEntries.clear();
+        _programIdentifiers.clear();
+        _materialIdentifiers.clear();
+        _meshIdentifiers.clear();
+        _textureIdentifiers.clear();
+        _appearanceIdentifiers.clear();
+        _batches.clear();
+        _batched.clear();
+        _instances.clear();
+    }
+
+    void RenderQueue::render() {
+        renderOpaque();
+        renderTranslucent();
+    }
+
+    void RenderQueue::renderOpaque() {
+        memset(&_statistics, 0, sizeof(_statistics));
+        _statistics._itemCount = _items.size();
+
+        if(_sortingEnabled) {
+            radixSort(_sortEntries, _sortBuffer);
+        }
+
+        collectBatches();
+        uploadInstances();
+
+        State state;
+        state._program = Program::current();
+        state._material = 0;
+        state._textureActivated = false;
+        state._compiledMesh = 0;
+
+        // Instanced batches are all opaque and go first, so the program only
+        // changes once for them.
+        foreach(const Batch& batch, _batches) {
+            Item& item = _items[_sortEntries[batch._firstEntry]._item];
+            activateProgram(state, _instancingProgram);
+            activateMaterial(state, item._material);
+            if(!bindCompiledMesh(state, item._compiledMesh)) {
+                continue;
+            }
+
+            glBindBuffer(GL_ARRAY_BUFFER, _instanceBufferHandle);
+            G3D_COUNT_BUFFER_BINDS(1);
+            InstanceAttributes::describeLayout(batch._firstInstance * sizeof(InstanceAttributes));
+            item._compiledMesh->drawInstanced(batch._count);
+            InstanceAttributes::disableLayout();
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            _statistics._drawCalls++;
+            _statistics._instancedDrawCalls++;
+            _statistics._instanceCount += batch._count;
+        }
+
+        drawItems(state, false);
+    }
+
+    void RenderQueue::renderTranslucent() {
+        // Whatever has been drawn in between may have changed any state.
+        State state;
+        state._program = Program::current();
+        state._material = 0;
+        state._textureActivated = false;
+        state._compiledMesh = 0;
+
+        glDepthMask(GL_FALSE);
+        drawItems(state, true);
+        glDepthMask(GL_TRUE);
+
+        clear();
+    }
+
+    RenderQueue::Statistics RenderQueue::statistics() {
+        return _statistics;
+    }
+
+    void RenderQueue::drawItems(State& state, bool translucent) {
+        for(int i = 0; i < _sortEntries.size(); i++) {
+            if(_batched[i]) {
+                continue;
+            }
+
+            Item& item = _items[_sortEntries[i]._item];
+            if(item._translucent != translucent) {
+                continue;
+            }
+
+            activateProgram(state, item._program);
+            if(state._program) {
+                state._program->setModelViewMatrix(item._modelViewMatrix);
+            }
+
+            activateMaterial(state, item._material);
+            if(!bindCompiledMesh(state, item._compiledMesh)) {
+                continue;
+            }
+
+            item._compiledMesh->draw();
+            _statistics._drawCalls++;
+        }
+
+        if(state._compiledMesh) {
+            state._compiledMesh->release();
+            state._compiledMesh = 0;
+        }
+    }
+
+    void RenderQueue::collectBatches() {
+        _batched.fill(false, _sortEntries.size());
+        if(!_instancingProgram) {
+            return;
+        }
+
+        int count = _sortEntries.size();
+        int first = 0;
+        while(first < count) {
+            Item& firstItem = _items[_sortEntries[first]._item];
+            int end = first + 1;
+            if(!firstItem._translucent) {
+                while(end < count) {
+                    Item& item = _items[_sortEntries[end]._item];
+                    if(item._translucent
+                    || item._compiledMesh != firstItem._compiledMesh
+                    || item._program != firstItem._program
+                    || item._materialIdentifier != firstItem._materialIdentifier) {
+                        break;
+                    }
+                    end++;
+                }
+            }
+
+            if(end - first >= minimumInstanceCount) {
+                Batch batch;
+                batch._firstEntry = first;
+                batch._count = end - first;
+                batch._firstInstance = _instances.size();
+                _batches.append(batch);
+
+                for(int i = first; i < end; i++) {
+                    Item& item = _items[_sortEntries[i]._item];
+                    InstanceAttributes instance;
+                    memcpy(instance._modelViewMatrix,
+                           item._modelViewMatrix.asGlFloatPointer(),
+                           sizeof(instance._modelViewMatrix));
+                    RgbaColor emission = item._material ? item._material->emission() : RgbaColor(0.0, 0.0, 0.0, 0.0);
+                    instance._emission[0] = emission._red;
+                    instance._emission[1] = emission._green;
+                    instance._emission[2] = emission._blue;
+                    instance._emission[3] = emission._alpha;
+                    _instances.append(instance);
+                    _batched[i] = true;
+                }
+            }
+            first = end;
+        }
+    }
+
+    void RenderQueue::uploadInstances() {
+        if(_instances.isEmpty()) {
+            return;
+        }
+
+        if(!_instanceBufferHandle) {
+            glGenBuffers(1, &_instanceBufferHandle);
+        }
+
+        // Respecifying the whole buffer lets the driver hand out fresh memory
+        // instead of waiting for the previous frame to finish reading it.
+        glBindBuffer(GL_ARRAY_BUFFER, _instanceBufferHandle);
+        glBufferData(GL_ARRAY_BUFFER,
+                     _instances.size() * sizeof(InstanceAttributes),
+                     _instances.constData(),
+                     GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+
+    void RenderQueue::activateProgram(State& state, Program *program) {
+        if(!program || program == state._program) {
+            return;
+        }
+
+        // Inserting a program resets its vertex decoding, so the mesh has to
+        // be bound again.
+        if(state._compiledMesh) {
+            state._compiledMesh->release();
+            state._compiledMesh = 0;
+        }
+
+        program->insert();
+        state._program = program;
+        _statistics._programChanges++;
+    }
+
+    void RenderQueue::activateMaterial(State& state, Material *material) {
+        if(!material || material == state._material) {
+            return;
+        }
+
+        material->activateColors();
+        state._material = material;
+        _statistics._materialChanges++;
+
+        QString textureId = material->textureId();
+        if(!state._textureActivated || textureId != state._textureId) {
+            TextureStore::instance().activateTexture(textureId);
+            state._textureId = textureId;
+            state._textureActivated = true;
+            _statistics._textureChanges++;
+        }
+    }
+
+    bool RenderQueue::bindCompiledMesh(State& state, CompiledMesh *compiledMesh) {
+        if(compiledMesh == state._compiledMesh) {
+            return true;
+        }
+
+        if(state._compiledMesh) {
+            state._compiledMesh->release();
+        }
+
+        state._compiledMesh = compiledMesh;
+        _statistics._meshChanges++;
+        if(!compiledMesh->bind()) {
+            state._compiledMesh = 0;
+            return false;
+        }
+        return true;
+    }
+
+    quint64 RenderQueue::sortKey(Item& item, double depth) {
+        quint64 program = field(identifier(_programIdentifiers, item._program), programBits);
+        quint64 material = field(item._materialIdentifier, materialBits);
+        quint64 mesh = field(identifier(_meshIdentifiers, item._compiledMesh), meshBits);
+
+        int textureIdentifier = 0;
+        if(item._material) {
+            QString textureId = item._material->textureId();
+            if(!_textureIdentifiers.contains(textureId)) {
+                _textureIdentifiers.insert(textureId, _textureIdentifiers.size() + 1);
+            }
+            textureIdentifier = _textureIdentifiers.value(textureId);
+        }
+        quint64 texture = field(textureIdentifier, textureBits);
+
+        quint32 bits = depthBits(depth);
+        if(item._translucent) {
+            // Farthest first
+            quint64 inverseDepth = field(~bits, translucentDepthBits);
+            return (Q_UINT64_C(1) << translucentShift)
+                 | (inverseDepth << (programBits + textureBits + materialBits))
+                 | (program << (textureBits + materialBits))
+                 | (texture << materialBits)
+                 | material;
+        }
+
+        // Nearest first within equal state
+        quint64 opaqueDepth = bits >> (translucentDepthBits - opaqueDepthBits);
+        return (program << (textureBits + materialBits + meshBits + opaqueDepthBits))
+             | (texture << (materialBits + meshBits + opaqueDepthBits))
+             | (material << (meshBits + opaqueDepthBits))
+             | (mesh << opaqueDepthBits)
+             | opaqueDepth;
+    }
+
+    int RenderQueue::materialIdentifier(Material *material) {
+        if(!material) {
+            return 0;
+        }
+
+        // Materials that only differ in their emission share an identifier,
+        // so that they end up next to each other and can be instanced.
+        if(!_materialIdentifiers.contains(material)) {
+            QByteArray appearanceKey = material->appearanceKey();
+            if(!_appearanceIdentifiers.contains(appearanceKey)) {
+                _appearanceIdentifiers.insert(appearanceKey, _appearanceIdentifiers.size() + 1);
+            }
+            _materialIdentifiers.insert(material, _appearanceIdentifiers.value(appearanceKey));
+        }
+        return _materialIdentifiers.value(material);
+    }
+
+    int RenderQueue::identifier(QHash<const void*, int>& identifiers, const void *pointer) {
+        if(!pointer) {
+            return 0;
+        }
+
+        if(!identifiers.contains(pointer)) {
+            identifiers.insert(pointer, identifiers.size() + 1);
+        }
+        return identifiers.value(pointer);
+    }
+
+    void RenderQueue::radixSort(QVector<SortEntry>& entries, QVector<SortEntry>& buffer) {
+        int count = entries.size();
+        if(count < 2) {
+            return;
+        }
+
+        buffer.resize(count);
+        SortEntry *source = entries.data();
+        SortEntry *target = buffer.data();
+        bool swapped = false;
+
+        // Least significant byte first, eight passes of 256 buckets. Passes in
+        // which all keys share the same byte do not change the order and are
+        // skipped, which is common for the upper bits.
+        for(int shift = 0; shift < 64; shift += 8) {
+            int histogram[256];
+            memset(histogram, 0, sizeof(histogram));
+            for(int i = 0; i < count; i++) {
+                histogram[(source[i]._key >> shift) & 0xff]++;
+            }
+
+            if(histogram[(source[0]._key >> shift) & 0xff] == count) {
+                continue;
+            }
+
+            int offset = 0;
+            for(int bucket = 0; bucket < 256; bucket++) {
+                int bucketSize = histogram[bucket];
+                histogram[bucket] = offset;
+                offset += bucketSize;
+            }
+
+            for(int i = 0; i < count; i++) {
+                target[histogram[(source[i]._key >> shift) & 0xff]++] = source[i];
+            }
+
+            SortEntry *swap = source;
+            source = target;
+            target = swap;
+            swapped = !swapped;
+        }
+
+        if(swapped) {
+            memcpy(entries.data(), buffer.constData(), count * sizeof(SortEntry));
+        }
+    }
+} // namespace Glee3D
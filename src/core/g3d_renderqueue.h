@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_RENDERQUEUE_H
+#define G3D_RENDERQUEUE_H
+
+// Own includes
+#include "g3d_logging.h"
+#include "g3d_vertex.h"
+#include "math/g3d_matrix4x4.h"
+
+// Qt includes
+#include <QVector>
+#include <QHash>
+#include <QString>
+#include <QByteArray>
+#include <QGLWidget>
+
+namespace Glee3D {
+    class Entity;
+    class CompiledMesh;
+    class Material;
+    class Program;
+
+    /**
+      * @class RenderQueue
+      * Collects the entities to draw in a frame and renders them sorted by
+      * the state they need, so that neighbours sharing a program, texture,
+      * material or mesh do not set it again.
+      *
+      * Each item gets a 64 bit sort key. Opaque items are ordered by program,
+      * texture, material and mesh first and front-to-back within equal
+      * state. Translucent items are drawn after all opaque items, strictly
+      * back-to-front, with depth writes disabled. Keys are sorted with a
+      * radix sort, which is linear in the number of items.
+      *
+      * Opaque entities sharing a compiled mesh and a material that looks the
+      * same apart from its emission are drawn with a single instanced draw
+      * call, if an instancing program has been set. Their model view
+      * matrices and emission colors are uploaded once per frame into an
+      * instance buffer. Instanced batches are drawn before all other items.
+      *
+      * The queue draws the compiled mesh of the current level of detail of
+      * each entity directly, overrides of Entity::render() are not called.
+      */
+    class RenderQueue :
+        public Logging {
+    public:
+        /** Counts of the work done by the last call to render(). */
+        struct Statistics {
+            int _itemCount;
+            int _drawCalls;
+            int _programChanges;
+            int _textureChanges;
+            int _materialChanges;
+            int _meshChanges;
+            int _instancedDrawCalls;
+            int _instanceCount;
+        };
+
+        RenderQueue();
+
+        /** Destructor. */
+        ~RenderQueue();
+
+        /** Deletes the instance buffer. The context it has been created in
+          * has to be current. */
+        void releaseResources();
+
+        /**
+         * Sets the program used for instanced drawing, which has to read the
+         * per-instance data described by InstanceAttributes. Without an
+         * instancing program, all items are drawn one by one.
+         */
+        void setInstancingProgram(Program *program);
+
+        /** @returns the program used for instanced drawing. */
+        Program *instancingProgram();
+
+        /**
+         * Sets whether items are sorted. Without sorting, items are drawn in
+         * the order they have been appended, which is useful to measure how
+         * many state changes sorting saves.
+         */
+        void setSortingEnabled(bool on);
+
+        /** @returns true, if items are sorted before rendering. */
+        bool sortingEnabled();
+
+        /**
+         * Appends an entity to be drawn. Entities without a compiled mesh
+         * start compiling and are skipped.
+         * @param entity The entity to draw.
+         * @param material Material to draw the entity with, may be 0.
+         * @param program Program to draw the entity with.
+         * @param modelViewMatrix Model view matrix for the entity.
+         * @param depth Distance of the entity from the camera.
+         */
+        void append(Entity *entity, Material *material, Program *program, Matrix4x4 modelViewMatrix, double depth);
+
+        /** Removes all items. */
+        void clear();
+
+        /** Sorts and renders all items and removes them from the queue. */
+        void render();
+
+        /**
+         * Sorts the items and renders the opaque ones. This allows drawing
+         * something in between opaque and translucent items, like the
+         * skybox. renderTranslucent() has to follow.
+         */
+        void renderOpaque();
+
+        /** Renders the translucent items after renderOpaque() and removes
+          * all items from the queue. */
+        void renderTranslucent();
+
+        /** @returns the statistics of the last call to render(). */
+        Statistics statistics();
+
+    private:
+        struct Item {
+            CompiledMesh *_compiledMesh;
+            Material *_material;
+            Program *_program;
+            Matrix4x4 _modelViewMatrix;
+            int _materialIdentifier;
+            bool _translucent;
+        };
+
+        struct SortEntry {
+            quint64 _key;
+            int _item;
+        };
+
+        /** A run of sorted items drawn with one instanced draw call. */
+        struct Batch {
+            int _firstEntry;
+            int _count;
+            int _firstInstance;
+        };
+
+        /** The state set by the last drawn item. */
+        struct State {
+            Program *_program;
+            Material *_material;
+            QString _textureId;
+            bool _textureActivated;
+            CompiledMesh *_compiledMesh;
+        };
+
+        quint64 sortKey(Item& item, double depth);
+        int materialIdentifier(Material *material);
+        static int identifier(QHash<const void*, int>& identifiers, const void *pointer);
+        static void radixSort(QVector<SortEntry>& entries, QVector<SortEntry>& buffer);
+
+        void collectBatches();
+        void uploadInstances();
+        void activateProgram(State& state, Program *program);
+        void activateMaterial(State& state, Material *material);
+        bool bindCompiledMesh(State& state, CompiledMesh *compiledMesh);
+        void drawItems(State& state, bool translucent);
+
+        bool _sortingEnabled;
+        Program *_instancingProgram;
+        QVector<Item> _items;
+        QVector<SortEntry> _sortEntries;
+        QVector<SortEntry> _sortBuffer;
+        QHash<const void*, int> _programIdentifiers;
+        QHash<const void*, int> _materialIdentifiers;
+        QHash<const void*, int> _meshIdentifiers;
+        QHash<QString, int> _textureIdentifiers;
+        QHash<QByteArray, int> _appearanceIdentifiers;
+        QVector<Batch> _batches;
+        QVector<bool> _batched;
+        QVector<InstanceAttributes> _instances;
+        GLuint _instanceBufferHandle;
+        Statistics _statistics;
+    };
+} // namespace Glee3D
+
+#endif // G3D_RENDERQUEUE_H
@@ -20,11 +20,26 @@
 
 // Qt includes
 #include <QApplication>
+#include <QMutexLocker>
 
 // Own includes
 #include "g3d_scene.h"
 
 namespace Glee3D {
+    namespace {
+        /** Appends the given entity and its subordinated entities, parents
+          * before their children, which refer to them by index. */
+        void serializeHierarchy(Entity *entity, int parent, QJsonArray& entities) {
+            QJsonObject jsonObject = entity->serialize();
+            jsonObject["parent"] = parent;
+            int index = entities.size();
+            entities.append(jsonObject);
+            foreach(Entity *child, entity->children()) {
+                serializeHierarchy(child, index, entities);
+            }
+        }
+    }
+
     Scene::Scene(QObject *parent)
         : QObject(parent) {
         _sceneLock = new QSemaphore(1);
@@ -32,6 +47,7 @@ namespace Glee3D {
     }
 
     Scene::~Scene() {
+        qDeleteAll(_destroyed);
     }
 
     void Scene::setSkyBox(SkyBox *skyBox) {
@@ -66,6 +82,62 @@ namespace Glee3D {
         }
     }
 
+    void Scene::destroy(Entity *object) {
+        if(!object) {
+            return;
+        }
+
+        // Destroyed entities are unlinked right away, so neither the
+        // hierarchy left in the scene nor the render thread deleting them
+        // later ever follows a link to a deleted entity.
+        foreach(Entity *child, object->children()) {
+            destroy(child);
+        }
+        object->detach();
+
+        QMutexLocker locker(&_destroyedMutex);
+        if(!_destroyed.contains(object)) {
+            _entities.remove(object);
+            _destroyed.append(object);
+        }
+    }
+
+    void Scene::destroy(Terrain *terrain) {
+        QMutexLocker locker(&_destroyedMutex);
+        if(terrain && !_destroyed.contains(terrain)) {
+            _terrains.remove(terrain);
+            _destroyed.append(terrain);
+        }
+    }
+
+    void Scene::destroy(SkyBox *skyBox) {
+        QMutexLocker locker(&_destroyedMutex);
+        if(skyBox && !_destroyed.contains(skyBox)) {
+            if(_skyBox == skyBox) {
+                _skyBox = 0;
+            }
+            _destroyed.append(skyBox);
+        }
+    }
+
+    void Scene::deleteDestroyed() {
+        // Once unreferenced, objects cannot be referenced again, because
+        // new snapshots only capture what is in the scene.
+        QList<Renderable*> unreferenced;
+        _destroyedMutex.lock();
+        int i = 0;
+        while(i < _destroyed.size()) {
+            if(_destroyed[i]->referencedBySnapshot()) {
+                i++;
+            } else {
+                unreferenced.append(_destroyed.takeAt(i));
+            }
+        }
+        _destroyedMutex.unlock();
+
+        qDeleteAll(unreferenced);
+    }
+
     void Scene::insert(LightSource *lightSource) {
         if(lightSource) {
             _lightSources.insert(lightSource);
@@ -84,6 +156,14 @@ namespace Glee3D {
         return _entities;
     }
 
+    void Scene::updateTransforms() {
+        foreach(Entity *entity, _entities) {
+            if(!entity->parent()) {
+                entity->updateWorldTransform();
+            }
+        }
+    }
+
     QSet<LightSource*> Scene::lightSources() {
         return _lightSources;
     }
@@ -92,4 +172,96 @@ namespace Glee3D {
         return _terrains;
     }
 
+    QString Scene::className() {
+        return "Scene";
+    }
+
+    QJsonObject Scene::serialize() {
+        QJsonObject jsonObject;
+        jsonObject["class"] = className();
+
+        QJsonArray entities;
+        foreach(Entity *entity, _entities) {
+            if(!entity->parent()) {
+                serializeHierarchy(entity, -1, entities);
+            }
+        }
+        jsonObject["entities"] = entities;
+
+        QJsonArray lightSources;
+        foreach(LightSource *lightSource, _lightSources) {
+            lightSources.append(lightSource->serialize());
+        }
+        jsonObject["lightSources"] = lightSources;
+
+        return jsonObject;
+    }
+
+    bool Scene::deserialize(QJsonObject jsonObject) {
+        if(!jsonObject.contains("class")) {
+            _deserializationError = Serializable::NoClassSpecified;
+            return false;
+        }
+
+        if(jsonObject.contains("entities")
+        && jsonObject.contains("lightSources")) {
+            if(jsonObject["class"] == className()) {
+                // Nothing is inserted unless everything could be read.
+                QList<Entity*> entities;
+                QList<LightSource*> lightSources;
+                _deserializationError = Serializable::NoError;
+
+                QJsonArray entityArray = jsonObject["entities"].toArray();
+                for(int i = 0; i < entityArray.size(); i++) {
+                    QJsonObject entityObject = entityArray[i].toObject();
+                    Entity *entity = new Entity();
+                    entities.append(entity);
+                    if(!entity->deserialize(entityObject)) {
+                        _deserializationError = entity->deserializationError();
+                        break;
+                    }
+
+                    int parent = entityObject.contains("parent") ? entityObject["parent"].toInt() : -1;
+                    if(parent >= i) {
+                        _deserializationError = Serializable::MissingElements;
+                        break;
+                    }
+                    if(parent >= 0) {
+                        entities[parent]->subordinate(entity);
+                    }
+                }
+
+                QJsonArray lightSourceArray = jsonObject["lightSources"].toArray();
+                for(int i = 0; i < lightSourceArray.size()
+                    && _deserializationError == Serializable::NoError; i++) {
+                    LightSource *lightSource = new LightSource();
+                    lightSources.append(lightSource);
+                    if(!lightSource->deserialize(lightSourceArray[i].toObject())) {
+                        _deserializationError = lightSource->deserializationError();
+                    }
+                }
+
+                if(_deserializationError != Serializable::NoError) {
+                    qDeleteAll(entities);
+                    qDeleteAll(lightSources);
+                    return false;
+                }
+
+                foreach(Entity *entity, entities) {
+                    insert(entity);
+                }
+                foreach(LightSource *lightSource, lightSources) {
+                    insert(lightSource);
+                }
+                return true;
+            } else {
+                _deserializationError = Serializable::WrongClass;
+                return false;
+            }
+        } else {
+            _deserializationError = Serializable::MissingElements;
+            return false;
+        }
+    }
+
 } // namespace Glee3D
@@ -30,12 +30,15 @@
 #include "math/g3d_vector2d.h"
 #include "math/g3d_vector3d.h"
 #include "math/g3d_line3d.h"
+#include "io/g3d_serializable.h"
 
 // Qt includes
 #include <QObject>
 #include <QSet>
 #include <QMap>
 #include <QSemaphore>
+#include <QList>
+#include <QMutex>
 
 namespace Glee3D {
     /**
@@ -43,8 +46,21 @@ namespace Glee3D {
       * @author Jacob Dawid (jacob.dawid@omg-it.works)
       * @date 02.12.2012
       * The model representation of the current virtual scene.
+      *
+      * Serializing a scene stores its entities, including their hierarchy,
+      * and its light sources. Terrains and the skybox are not stored.
+      * Deserializing inserts new entities and light sources, which are owned
+      * by the caller like everything else inserted into a scene.
+      *
+      * While a LogicThread runs the scene, the display renders snapshots that
+      * reference entities, terrains and the skybox. Objects that are removed
+      * for good have to be handed to destroy(). The render thread deletes
+      * them once no snapshot references them any more, with its OpenGL
+      * context current, as they may own OpenGL resources.
       */
-    class Scene : public QObject {
+    class Scene :
+        public QObject,
+        public Serializable {
         Q_OBJECT
     public:
         /**
@@ -78,6 +94,29 @@ namespace Glee3D {
 
         void remove(Terrain *terrain);
 
+        /**
+          * Removes an object from the scene and deletes it once no snapshot
+          * references it any more. The object is detached from the entity
+          * it has been subordinated to, and its subordinated entities are
+          * destroyed along with it.
+          * @param object Object that shall be deleted.
+          */
+        void destroy(Entity *object);
+
+        /** @overload */
+        void destroy(Terrain *terrain);
+
+        /** Deletes the skybox like destroy(Entity*), and removes it from the
+          * scene if it is the current skybox. */
+        void destroy(SkyBox *skyBox);
+
+        /**
+          * Deletes the destroyed objects no snapshot references any more.
+          * This is done by the render thread after each frame, with the
+          * OpenGL context current. The scene does not need to be locked.
+          */
+        void deleteDestroyed();
+
         /**
           * Inserts a light source into the scene.
           * @param lightSource Light source that shall be inserted.
@@ -98,11 +137,22 @@ namespace Glee3D {
         /** @returns All objects in this scene. */
         QSet<Entity*> entities();
 
+        /**
+          * Recomputes the world matrices of all entities that have been
+          * moved or rotated since the last update, walking each hierarchy
+          * from its root once.
+          */
+        void updateTransforms();
+
         /** @returns All light sources in this scene. */
         QSet<LightSource*> lightSources();
 
         QSet<Terrain*> terrains();
 
+        QString className();
+        QJsonObject serialize();
+        bool deserialize(QJsonObject jsonObject);
+
         virtual void processLogic(QMap<int, bool> keyStatusMap, Camera *activeCamera) {
             Q_UNUSED(keyStatusMap);
             Q_UNUSED(activeCamera);
@@ -139,6 +189,8 @@ namespace Glee3D {
 
     private:
         QSemaphore *_sceneLock;
+        QMutex _destroyedMutex;
+        QList<Renderable*> _destroyed;
     };
 
 } // namespace Glee3D
@@ -0,0 +1,203 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_scenesnapshot.h"
+#include "g3d_scene.h"
+
+namespace Glee3D {
+    SceneSnapshot::SceneSnapshot() {
+        _skyBox = 0;
+        _hasCamera = false;
+        _tick = 0;
+    }
+
+    SceneSnapshot::SceneSnapshot(const SceneSnapshot& other)
+        : _entities(other._entities),
+          _materials(other._materials),
+          _terrains(other._terrains),
+          _lightSources(other._lightSources),
+          _skyBox(other._skyBox),
+          _camera(other._camera),
+          _hasCamera(other._hasCamera),
+          _tick(other._tick) {
+        retain();
+    }
+
+    SceneSnapshot::~SceneSnapshot() {
+        release();
+    }
+
+    SceneSnapshot *SceneSnapshot::capture(Scene *scene, Camera *camera, quint64 tick) {
+        SceneSnapshot *snapshot = new SceneSnapshot();
+        snapshot->_tick = tick;
+        if(camera) {
+            snapshot->_camera = *camera;
+            snapshot->_hasCamera = true;
+        }
+
+        if(!scene) {
+            return snapshot;
+        }
+
+        scene->updateTransforms();
+
+        QHash<Material*, int> materialIndices;
+        QSet<Entity*> entities = scene->entities();
+        snapshot->_entities.reserve(entities.size());
+        foreach(Entity *entity, entities) {
+            if(!entity->parent()) {
+                snapshot->captureEntity(entity, -1, materialIndices);
+            }
+        }
+
+        QSet<Terrain*> terrains = scene->terrains();
+        foreach(Terrain *terrain, terrains) {
+            TerrainState state;
+            state._terrain = terrain;
+            state._translationMatrix = terrain->translationMatrix();
+            snapshot->_terrains.append(state);
+        }
+
+        QSet<LightSource*> lightSources = scene->lightSources();
+        foreach(LightSource *lightSource, lightSources) {
+            snapshot->_lightSources.append(*lightSource);
+        }
+
+        snapshot->_skyBox = scene->skyBox();
+        snapshot->retain();
+        return snapshot;
+    }
+
+    SceneSnapshot *SceneSnapshot::interpolate(SceneSnapshot& previous, SceneSnapshot& latest, double factor) {
+        SceneSnapshot *snapshot = new SceneSnapshot(latest);
+
+        int entityCount = qMin(previous._entities.size(), snapshot->_entities.size());
+        for(int i = 0; i < entityCount; i++) {
+            EntityState& state = snapshot->_entities[i];
+            EntityState& previousState = previous._entities[i];
+            if(state._entity == previousState._entity && state._parent == previousState._parent) {
+                state._worldMatrix = previousState._worldMatrix.interpolate(state._worldMatrix, factor);
+            }
+        }
+
+        int terrainCount = qMin(previous._terrains.size(), snapshot->_terrains.size());
+        for(int i = 0; i < terrainCount; i++) {
+            TerrainState& state = snapshot->_terrains[i];
+            TerrainState& previousState = previous._terrains[i];
+            if(state._terrain == previousState._terrain) {
+                state._translationMatrix = previousState._translationMatrix.interpolate(state._translationMatrix, factor);
+            }
+        }
+
+        if(previous._hasCamera && snapshot->_hasCamera) {
+            Vector3D position = previous._camera.position();
+            Vector3D lookAt = previous._camera.lookAt();
+            snapshot->_camera.setPosition(position + (snapshot->_camera.position() - position) * factor);
+            snapshot->_camera.setLookAt(lookAt + (snapshot->_camera.lookAt() - lookAt) * factor);
+        }
+        return snapshot;
+    }
+
+    void SceneSnapshot::retain() {
+        for(int i = 0; i < _entities.size(); i++) {
+            _entities[i]._entity->retainForSnapshot();
+        }
+        for(int i = 0; i < _terrains.size(); i++) {
+            _terrains[i]._terrain->retainForSnapshot();
+        }
+        if(_skyBox) {
+            _skyBox->retainForSnapshot();
+        }
+    }
+
+    void SceneSnapshot::release() {
+        for(int i = 0; i < _entities.size(); i++) {
+            _entities[i]._entity->releaseFromSnapshot();
+        }
+        for(int i = 0; i < _terrains.size(); i++) {
+            _terrains[i]._terrain->releaseFromSnapshot();
+        }
+        if(_skyBox) {
+            _skyBox->releaseFromSnapshot();
+        }
+    }
+
+    void SceneSnapshot::captureEntity(Entity *entity, int parent, QHash<Material*, int>& materialIndices) {
+        EntityState state;
+        state._entity = entity;
+        state._worldMatrix = entity->worldMatrix();
+        state._parent = parent;
+        state._visible = entity->visible();
+        state._material = -1;
+
+        // Entities sharing a material share its copy as well.
+        Material *material = entity->material();
+        if(material) {
+            if(!materialIndices.contains(material)) {
+                materialIndices.insert(material, _materials.size());
+                _materials.append(*material);
+            }
+            state._material = materialIndices.value(material);
+        }
+
+        int index = _entities.size();
+        _entities.append(state);
+        foreach(Entity *child, entity->children()) {
+            captureEntity(child, index, materialIndices);
+        }
+        _entities[index]._subtreeEnd = _entities.size();
+    }
+
+    const QVector<SceneSnapshot::EntityState>& SceneSnapshot::entities() const {
+        return _entities;
+    }
+
+    Material *SceneSnapshot::material(int index) {
+        if(index < 0 || index >= _materials.size()) {
+            return 0;
+        }
+        return &_materials[index];
+    }
+
+    const QVector<SceneSnapshot::TerrainState>& SceneSnapshot::terrains() const {
+        return _terrains;
+    }
+
+    QVector<LightSource>& SceneSnapshot::lightSources() {
+        return _lightSources;
+    }
+
+    SkyBox *SceneSnapshot::skyBox() const {
+        return _skyBox;
+    }
+
+    bool SceneSnapshot::hasCamera() const {
+        return _hasCamera;
+    }
+
+    Camera SceneSnapshot::camera() const {
+        return _camera;
+    }
+
+    quint64 SceneSnapshot::tick() const {
+        return _tick;
+    }
+} // namespace Glee3D
@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_SCENESNAPSHOT_H
+#define G3D_SCENESNAPSHOT_H
+
+// Own includes
+#include "g3d_camera.h"
+#include "g3d_material.h"
+#include "g3d_lightsource.h"
+#include "math/g3d_matrix4x4.h"
+
+// Qt includes
+#include <QVector>
+#include <QHash>
+
+namespace Glee3D {
+    class Scene;
+    class Entity;
+    class Terrain;
+    class SkyBox;
+
+    /**
+      * @class SceneSnapshot
+      * Immutable copy of the scene state needed for rendering a frame. It is
+      * captured by the logic thread after each logic step, so the display can
+      * render it without holding the scene lock.
+      *
+      * Transforms, visibility, materials, light sources and the camera are
+      * copied. Entities, terrains and the skybox are referenced, the display
+      * only touches their render state, like compiled meshes and levels of
+      * detail, which entities guard against the logic thread. Every
+      * snapshot counts its references, and objects removed with
+      * Scene::destroy() are only deleted once no snapshot references them
+      * any more. Deleting them directly is unsafe while snapshots are
+      * rendered, as the display keeps up to two snapshots for blending.
+      *
+      * A snapshot is never changed once it has been published. Materials and
+      * light sources are handed out non-const only because activating them
+      * for rendering requires it.
+      */
+    class SceneSnapshot {
+    public:
+        /** State of a single entity. Entities are stored parents first. */
+        struct EntityState {
+            Entity *_entity;
+            Matrix4x4 _worldMatrix;
+            /** Index into materials(), or -1. */
+            int _material;
+            /** Index of the parent entity, or -1. */
+            int _parent;
+            /** Index after the last subordinated entity. */
+            int _subtreeEnd;
+            bool _visible;
+        };
+
+        /** State of a single terrain. */
+        struct TerrainState {
+            Terrain *_terrain;
+            Matrix4x4 _translationMatrix;
+        };
+
+        /** Creates an empty snapshot. */
+        SceneSnapshot();
+
+        /** Creates a copy of the given snapshot. */
+        SceneSnapshot(const SceneSnapshot& other);
+
+        /** Destructor. Releases the references to entities, terrains and the
+          * skybox. */
+        ~SceneSnapshot();
+
+        /**
+         * Captures the state of the given scene as seen by the given camera.
+         * The scene has to be locked by the caller.
+         * @param scene The scene to capture.
+         * @param camera The active camera, may be null.
+         * @param tick Number of the logic step this snapshot belongs to.
+         */
+        static SceneSnapshot *capture(Scene *scene, Camera *camera, quint64 tick);
+
+        /**
+         * Creates a snapshot in between two consecutive snapshots. Entity and
+         * terrain transforms as well as the camera position are blended,
+         * everything else is taken from the later snapshot. Entities that do
+         * not appear in both snapshots at the same place are not blended.
+         * @param previous The earlier snapshot.
+         * @param latest The later snapshot.
+         * @param factor Blend factor, 0 is previous and 1 is latest.
+         */
+        static SceneSnapshot *interpolate(SceneSnapshot& previous, SceneSnapshot& latest, double factor);
+
+        /** @returns the entities, parents before their children. */
+        const QVector<EntityState>& entities() const;
+
+        /** @returns the material with the given index, or 0. */
+        Material *material(int index);
+
+        /** @returns the terrains. */
+        const QVector<TerrainState>& terrains() const;
+
+        /** @returns the light sources. */
+        QVector<LightSource>& lightSources();
+
+        /** @returns the skybox, or 0. */
+        SkyBox *skyBox() const;
+
+        /** @returns true, if a camera has been captured. */
+        bool hasCamera() const;
+
+        /** @returns the captured camera. */
+        Camera camera() const;
+
+        /** @returns the number of the logic step this snapshot belongs to. */
+        quint64 tick() const;
+
+    private:
+        SceneSnapshot& operator=(const SceneSnapshot& other);
+
+        void retain();
+        void release();
+        void captureEntity(Entity *entity, int parent, QHash<Material*, int>& materialIndices);
+
+        QVector<EntityState> _entities;
+        QVector<Material> _materials;
+        QVector<TerrainState> _terrains;
+        QVector<LightSource> _lightSources;
+        SkyBox *_skyBox;
+        Camera _camera;
+        bool _hasCamera;
+        quint64 _tick;
+    };
+} // namespace Glee3D
+
+#endif // G3D_SCENESNAPSHOT_H
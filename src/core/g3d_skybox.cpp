@@ -20,163 +20,162 @@
 
 // Own includes
 #include "g3d_skybox.h"
-#include "g3d_scene.h"
+#include "g3d_texturestore.h"
+#include "g3d_rendercounters.h"
 
 namespace Glee3D {
+    namespace {
+        /** Corners of the unit cube. */
+        const GLfloat cubeVertices[] = {
+            -1.0f, -1.0f, -1.0f,
+             1.0f, -1.0f, -1.0f,
+             1.0f,  1.0f, -1.0f,
+            -1.0f,  1.0f, -1.0f,
+            -1.0f, -1.0f,  1.0f,
+             1.0f, -1.0f,  1.0f,
+             1.0f,  1.0f,  1.0f,
+            -1.0f,  1.0f,  1.0f
+        };
+
+        /** Triangles of the unit cube. Faces are not culled, so the winding does
+          * not matter. */
+        const GLubyte cubeIndices[] = {
+            0, 2, 1,  0, 3, 2,  // -z
+            4, 5, 6,  4, 6, 7,  // +z
+            0, 4, 7,  0, 7, 3,  // -x
+            1, 2, 6,  1, 6, 5,  // +x
+            0, 1, 5,  0, 5, 4,  // -y
+            3, 7, 6,  3, 6, 2   // +y
+        };
+
+        const int cubeIndexCount = sizeof(cubeIndices) / sizeof(GLubyte);
+
+        GLenum cubeMapTarget(SkyBox::Plane plane) {
+            switch(plane) {
+            case SkyBox::BackX: return GL_TEXTURE_CUBE_MAP_NEGATIVE_X;
+            case SkyBox::FrontX: return GL_TEXTURE_CUBE_MAP_POSITIVE_X;
+            case SkyBox::BackY: return GL_TEXTURE_CUBE_MAP_NEGATIVE_Y;
+            case SkyBox::FrontY: return GL_TEXTURE_CUBE_MAP_POSITIVE_Y;
+            case SkyBox::BackZ: return GL_TEXTURE_CUBE_MAP_NEGATIVE_Z;
+            default:
+            case SkyBox::FrontZ: return GL_TEXTURE_CUBE_MAP_POSITIVE_Z;
+            }
+        }
+    }
+
     SkyBox::SkyBox()
         : Renderable() {
+        _cubeMapDirty = true;
+        _cubeMapHandle = 0;
+        _vertexArrayHandle = 0;
+        _vertexBufferHandle = 0;
+        _indexBufferHandle = 0;
+    }
+
+    SkyBox::~SkyBox() {
+        if(_cubeMapHandle) {
+            glDeleteTextures(1, &_cubeMapHandle);
+        }
+        if(_vertexArrayHandle) {
+            glDeleteVertexArrays(1, &_vertexArrayHandle);
+            glDeleteBuffers(1, &_vertexBufferHandle);
+            glDeleteBuffers(1, &_indexBufferHandle);
+        }
     }
 
     void SkyBox::setTexture(Plane plane, QString textureId) {
-        Material *material = new Material();
-        material->setAmbientReflection(RgbaColor(1.0, 1.0, 1.0, 1.0));
-        material->setDiffuseReflection(RgbaColor(0.0, 0.0, 0.0, 1.0));
-        material->setSpecularReflection(RgbaColor(0.0, 0.0, 0.0, 1.0));
-        material->setTextureId(textureId);
-        Material *existingSurface = _materials.value(plane, 0);
-        if(existingSurface)
-            delete existingSurface;
-        _materials[plane] = material;
+        _textureIds[plane] = textureId;
+        _cubeMapDirty = true;
     }
 
     void SkyBox::render(RenderMode renderMode) {
         Q_UNUSED(renderMode);
-        glPushAttrib(GL_ENABLE_BIT);
-        glDisable(GL_CULL_FACE);
-        glDisable(GL_BLEND);
-
-        double k = 1000000.0f;
-
-        _materials[BackX]->activate();
-        const double vertexDataBackX[] = {
-            (float)-k, (float) k, (float)-k,
-            (float)-k, (float) k, (float) k,
-            (float)-k, (float)-k, (float) k,
-            (float)-k, (float)-k, (float)-k,
-        };
-
-        const double textureCoordinatesBackX[] = {
-            0.0f, 1.0f,
-            1.0f, 1.0f,
-            1.0f, 0.0f,
-            0.0f, 0.0f
-        };
-
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glVertexPointer(3, GL_DOUBLE, 0, vertexDataBackX);
-        glTexCoordPointer(2, GL_DOUBLE, 0, textureCoordinatesBackX);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        _materials[FrontX]->activate();
-        const double vertexDataFrontX[] = {
-            (float) k, (float)-k, (float)-k,
-            (float) k, (float)-k, (float) k,
-            (float) k, (float) k, (float) k,
-            (float) k, (float) k, (float)-k
-        };
-
-        const double textureCoordinatesFrontX[] = {
-            1.0f, 0.0f,
-            0.0f, 0.0f,
-            0.0f, 1.0f,
-            1.0f, 1.0f
-        };
-
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glVertexPointer(3, GL_DOUBLE, 0, vertexDataFrontX);
-        glTexCoordPointer(2, GL_DOUBLE, 0, textureCoordinatesFrontX);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        _materials[BackY]->activate();
-        const double vertexDataBackY[] = {
-            (float) k, (float)-k, (float)-k,
-            (float) k, (float)-k, (float) k,
-            (float)-k, (float)-k, (float) k,
-            (float)-k, (float)-k, (float)-k
-        };
-
-        const double textureCoordinatesBackY[] = {
-            0.0f, 1.0f,
-            1.0f, 1.0f,
-            1.0f, 0.0f,
-            0.0f, 0.0f
-        };
+        if(_cubeMapDirty) {
+            buildCubeMap();
+        }
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glVertexPointer(3, GL_DOUBLE, 0, vertexDataBackY);
-        glTexCoordPointer(2, GL_DOUBLE, 0, textureCoordinatesBackY);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        _materials[FrontY]->activate();
-        const double vertexDataFrontY[] = {
-            (float) k, (float) k, (float)-k,
-            (float) k, (float) k, (float) k,
-            (float)-k, (float) k, (float) k,
-            (float)-k, (float) k, (float)-k
-        };
+        if(!_vertexArrayHandle) {
+            uploadCube();
+        }
 
-        const double textureCoordinatesFrontY[] = {
-            1.0f, 1.0f,
-            1.0f, 0.0f,
-            0.0f, 0.0f,
-            0.0f, 1.0f
-        };
-
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glVertexPointer(3, GL_DOUBLE, 0, vertexDataFrontY);
-        glTexCoordPointer(2, GL_DOUBLE, 0, textureCoordinatesFrontY);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        _materials[BackZ]->activate();
-        const double vertexDataBackZ[] = {
-            (float) k, (float)-k, (float)-k,
-            (float) k, (float) k, (float)-k,
-            (float)-k, (float) k, (float)-k,
-            (float)-k, (float)-k, (float)-k
-        };
+        glPushAttrib(GL_ENABLE_BIT | GL_DEPTH_BUFFER_BIT);
+        glDisable(GL_CULL_FACE);
+        glDisable(GL_BLEND);
+        glDisable(GL_TEXTURE_2D);
+        glEnable(GL_DEPTH_TEST);
+
+        // The cube is at the far plane, where it must pass the depth test
+        // against cleared pixels only. It never writes depth.
+        glDepthFunc(GL_LEQUAL);
+        glDepthMask(GL_FALSE);
+
+        glBindTexture(GL_TEXTURE_CUBE_MAP, _cubeMapHandle);
+        glBindVertexArray(_vertexArrayHandle);
+        glDrawElements(GL_TRIANGLES, cubeIndexCount, GL_UNSIGNED_BYTE, 0);
+        glBindVertexArray(0);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        G3D_COUNT_TEXTURE_BINDS(1);
+        G3D_COUNT_BUFFER_BINDS(1);
+        G3D_COUNT_DRAW_CALL(cubeIndexCount / 3);
 
-        const double textureCoordinatesBackZ[] = {
-            0.0f, 0.0f,
-            0.0f, 1.0f,
-            1.0f, 1.0f,
-            1.0f, 0.0f
-        };
+        glPopAttrib();
+    }
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glVertexPointer(3, GL_DOUBLE, 0, vertexDataBackZ);
-        glTexCoordPointer(2, GL_DOUBLE, 0, textureCoordinatesBackZ);
-        glDrawArrays(GL_QUADS, 0, 4);
-
-        _materials[FrontZ]->activate();
-        const double vertexDataFrontZ[] = {
-            (float)-k, (float)-k, (float) k,
-            (float)-k, (float) k, (float) k,
-            (float) k, (float) k, (float) k,
-            (float) k, (float)-k, (float) k
-        };
+    void SkyBox::buildCubeMap() {
+        if(!_cubeMapHandle) {
+            glGenTextures(1, &_cubeMapHandle);
+        }
+
+        // All faces of a cube map must be square and of the same size.
+        int size = 1;
+        foreach(QString textureId, _textureIds) {
+            QImage image = TextureStore::instance().image(textureId);
+            if(!image.isNull()) {
+                size = qMax(image.width(), image.height());
+                break;
+            }
+        }
+
+        glBindTexture(GL_TEXTURE_CUBE_MAP, _cubeMapHandle);
+        for(int plane = BackX; plane <= FrontZ; plane++) {
+            QImage image = TextureStore::instance().image(_textureIds.value((Plane)plane));
+            if(image.isNull()) {
+                image = QImage(size, size, QImage::Format_RGBA8888);
+                image.fill(Qt::black);
+            } else {
+                image = image.scaled(size, size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                             .convertToFormat(QImage::Format_RGBA8888);
+            }
+
+            glTexImage2D(cubeMapTarget((Plane)plane), 0, GL_RGBA,
+                         size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+        }
+
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+        _cubeMapDirty = false;
+    }
 
-        const double textureCoordinatesFrontZ[] = {
-            0.0f, 0.0f,
-            0.0f, 1.0f,
-            1.0f, 1.0f,
-            1.0f, 0.0f
-        };
+    void SkyBox::uploadCube() {
+        glGenVertexArrays(1, &_vertexArrayHandle);
+        glGenBuffers(1, &_vertexBufferHandle);
+        glGenBuffers(1, &_indexBufferHandle);
 
+        glBindVertexArray(_vertexArrayHandle);
+        glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferHandle);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
         glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glVertexPointer(3, GL_DOUBLE, 0, vertexDataFrontZ);
-        glTexCoordPointer(2, GL_DOUBLE, 0, textureCoordinatesFrontZ);
-        glDrawArrays(GL_QUADS, 0, 4);
+        glVertexPointer(3, GL_FLOAT, 0, 0);
 
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBufferHandle);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(cubeIndices), cubeIndices, GL_STATIC_DRAW);
 
-        glPopAttrib();
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
-
 } // namespace Glee3D
@@ -23,10 +23,11 @@
 
 // Own includes
 #include "g3d_renderable.h"
-#include "g3d_material.h"
 
 // Qt includes
+#include <QGLWidget>
 #include <QMap>
+#include <QString>
 
 namespace Glee3D {
 
@@ -35,6 +36,13 @@ namespace Glee3D {
   * @author Jacob Dawid (jacob.dawid@omg-it.works)
   * @date 02.12.2012
   * Defines a skybox.
+  *
+  * The six plane textures are combined into a cube map, which is drawn in
+  * a single call as a unit cube around the camera. The skybox shader
+  * forces the cube to the far plane, so the renderer draws the skybox after
+  * opaque geometry and the depth test rejects all pixels already covered.
+  * Plane images follow the OpenGL cube map convention, ie. they are seen
+  * from inside of the cube.
   */
 class SkyBox :
     public Renderable {
@@ -57,24 +65,37 @@ public:
       */
     SkyBox();
 
+    /** Destructor. Has to be called with the context current the skybox
+      * has been rendered with. */
+    virtual ~SkyBox();
+
     /**
-      * Loads a texture for a specific plane.
-      * NOTE: Usually the Surface class should be used, but in this case
-      * we can optimize performance by just ignoring using a texture and
-      * not defining material properties.
-      * @param plane Plane for which the texture shall be loaded.
-      * @param fileName File name of the texture image.
-      * @param display The current display.
+      * Sets the texture for a specific plane. The image is taken from the
+      * TextureStore when the cube map is built on the next render.
+      * @param plane Plane for which the texture shall be set.
+      * @param textureId Id of the texture in the TextureStore.
       */
     void setTexture(Plane plane, QString textureId);
 
     /**
-      * Renders the skybox.
+      * Renders the skybox. Expects the skybox program to be inserted with
+      * a model view matrix that only rotates.
       */
     void render(RenderMode renderMode = Textured);
 
 private:
-    QMap<Plane, Material*> _materials;
+    /** Builds the cube map from the plane textures. */
+    void buildCubeMap();
+
+    /** Uploads the unit cube. */
+    void uploadCube();
+
+    QMap<Plane, QString> _textureIds;
+    bool _cubeMapDirty;
+    GLuint _cubeMapHandle;
+    GLuint _vertexArrayHandle;
+    GLuint _vertexBufferHandle;
+    GLuint _indexBufferHandle;
 };
 
 } // namespace Glee3D
@@ -25,18 +25,179 @@
 // Qt includes
 #include <QImage>
 #include <QRgb>
-#include <QMap>
+#include <QList>
+#include <QThread>
 #include <QPair>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <QElapsedTimer>
 
 // Standard includes
+#include <algorithm>
 #include <iostream>
+#include <math.h>
 
 namespace Glee3D {
+    namespace {
+        /** Heightmaps below this row count are not worth spreading over threads. */
+        const int minimumRowsPerThread = 64;
+
+        /** A range of rows processed by a single thread. */
+        struct RowJob {
+            int _begin;
+            int _end;
+            int _width;
+            const QImage *_image;
+            int _heightShift;
+            int _tileShift;
+            float *_heights;
+            uchar *_tileIds;
+        };
+
+        /** Provides the heights of chunks, either from the heights in
+          * memory or from a mapped heightmap. */
+        struct HeightSource {
+            const float *_heights;
+            int _width;
+            int _height;
+            const Heightmap *_heightmap;
+
+            /** @returns the heights the given chunk is built from. Streamed
+              * heights are read into the given buffer. */
+            TerrainChunk::Heights heightsOf(TerrainChunk *chunk, QVector<float>& buffer) const {
+                TerrainChunk::Heights heights;
+                heights._heightfieldWidth = _width;
+                heights._heightfieldHeight = _height;
+                if(!_heightmap) {
+                    heights._data = _heights;
+                    heights._x = 0;
+                    heights._y = 0;
+                    heights._width = _width;
+                    return heights;
+                }
+
+                // Normals need the vertices next to the chunk.
+                int x0 = qMax(0, chunk->x() - 1);
+                int y0 = qMax(0, chunk->y() - 1);
+                int x1 = qMin(_width - 1, chunk->x() + chunk->width() + 1);
+                int y1 = qMin(_height - 1, chunk->y() + chunk->height() + 1);
+                buffer.resize((x1 - x0 + 1) * (y1 - y0 + 1));
+                _heightmap->read(x0, y0, x1 - x0 + 1, y1 - y0 + 1, buffer.data());
+
+                heights._data = buffer.constData();
+                heights._x = x0;
+                heights._y = y0;
+                heights._width = x1 - x0 + 1;
+                return heights;
+            }
+        };
+
+        /** Analyzes chunks on any thread. */
+        struct ChunkAnalyzer {
+            typedef void result_type;
+
+            HeightSource _source;
+            double _scale;
+            double _heightScale;
+
+            void operator()(TerrainChunk *chunk) const {
+                QVector<float> buffer;
+                chunk->analyze(_source.heightsOf(chunk, buffer), _scale, _heightScale);
+            }
+        };
+
+        /** Builds chunk vertices on any thread. */
+        struct VertexBuilder {
+            typedef void result_type;
+
+            HeightSource _source;
+            double _scale;
+            double _heightScale;
+            double _tilingOffset;
+
+            void operator()(TerrainChunk *chunk) const {
+                QVector<float> buffer;
+                chunk->buildVertices(_source.heightsOf(chunk, buffer), _scale, _heightScale, _tilingOffset);
+            }
+        };
+
+        /** @returns the bit offset of the given component in a QRgb. */
+        int componentShift(Terrain::Encoding encoding) {
+            switch(encoding) {
+            case Terrain::RedComponent: return 16;
+            case Terrain::GreenComponent: return 8;
+            default:
+            case Terrain::BlueComponent: return 0;
+            }
+        }
+
+        void decodeRows(RowJob& job) {
+            for(int y = job._begin; y < job._end; y++) {
+                const QRgb *pixels = (const QRgb*)job._image->constScanLine(y);
+                float *heights = job._heights + y * job._width;
+                uchar *tileIds = job._tileIds + y * job._width;
+                for(int x = 0; x < job._width; x++) {
+                    heights[x] = (float)((pixels[x] >> job._heightShift) & 0xff) - 128.0f;
+                    tileIds[x] = (uchar)((pixels[x] >> job._tileShift) & 0xff);
+                }
+            }
+        }
+
+        /** Runs the given function over the given number of rows, spread
+          * over all cores if there are enough rows. */
+        void processRows(RowJob prototype, int rowCount, void (*function)(RowJob&)) {
+            int threadCount = qMax(1, qMin(QThread::idealThreadCount(), rowCount / minimumRowsPerThread));
+            if(threadCount == 1) {
+                prototype._begin = 0;
+                prototype._end = rowCount;
+                function(prototype);
+                return;
+            }
+
+            QList<RowJob> jobs;
+            for(int i = 0; i < threadCount; i++) {
+                RowJob job = prototype;
+                job._begin = rowCount * i / threadCount;
+                job._end = rowCount * (i + 1) / threadCount;
+                jobs.append(job);
+            }
+            QtConcurrent::blockingMap(jobs, function);
+        }
+
+        /** @returns the distance of the given point to the given box. */
+        double distance(AxisAlignedBox box, Vector3D point) {
+            double dx = qMax(0.0, qMax(box._minimum.x() - point.x(), point.x() - box._maximum.x()));
+            double dy = qMax(0.0, qMax(box._minimum.y() - point.y(), point.y() - box._maximum.y()));
+            double dz = qMax(0.0, qMax(box._minimum.z() - point.z(), point.z() - box._maximum.z()));
+            return sqrt(dx * dx + dy * dy + dz * dz);
+        }
+
+        /** @returns true, if an edge of the given cell count can be
+          * stitched to the next coarser level. */
+        bool stitchable(int cells) {
+            return cells % 2 == 0;
+        }
+    }
+
     Terrain::Terrain()
         : Anchored(),
           Renderable(),
           Serializable(){
         _scale = 1.0;
+        _tilingOffset = 1.0;
+        _width = 0;
+        _height = 0;
+        _pixelError = 2.0;
+        _chunkColumns = 0;
+        _chunkRows = 0;
+        _drawnChunkCount = 0;
+        _indexBufferHandle = 0;
+        _frame = 0;
+        _memoryBudget = 256 * 1024 * 1024;
+        _memoryUsage = 0;
+        _streamingJobLimit = QThread::idealThreadCount();
+        _uploadBudgetBytes = 4 * 1024 * 1024;
+        _uploadBudgetMilliseconds = 2;
     }
 
     Terrain::~Terrain() {
@@ -60,165 +221,57 @@ namespace Glee3D {
         _width = image.width();
         _height = image.height();
 
-        if(_width == 0 || _height == 0) {
+        if(_width < 2 || _height < 2) {
             return InvalidImageSize;
         }
 
-        allocateMemory();
-        for(int y = 0; y < _height; y++) {
-            for(int x = 0; x < _width; x++) {
-                int pixelValue = image.pixel(x, y);
-                switch(heightEncoding) {
-                    case RedComponent:
-                        _terrain[QPair<int, int>(x,y)] = (double)qRed(pixelValue) - 128.0;
-                        break;
-                    case GreenComponent:
-                        _terrain[QPair<int, int>(x,y)] = (double)qGreen(pixelValue) - 128.0;
-                        break;
-                    case BlueComponent:
-                        _terrain[QPair<int, int>(x,y)] = (double)qBlue(pixelValue) - 128.0;
-                        break;
-                }
-
-                switch(textureEncoding) {
-                    case RedComponent:
-                        _tileIDs[QPair<int, int>(x,y)] = qRed(pixelValue);
-                        break;
-                    case GreenComponent:
-                        _tileIDs[QPair<int, int>(x,y)] = qGreen(pixelValue);
-                        break;
-                    case BlueComponent:
-                        _tileIDs[QPair<int, int>(x,y)] = qBlue(pixelValue);
-                        break;
-                }
-            }
+        // Scan lines can only be read as QRgb in these formats.
+        if(image.format() != QImage::Format_RGB32
+        && image.format() != QImage::Format_ARGB32) {
+            image = image.convertToFormat(QImage::Format_ARGB32);
         }
 
-        QMap<QPair<int, int>, Vector3D> surfaceNormals;
-        for(int y = 0; y < _height - 1; y++) {
-            for(int x = 0; x < _width - 1; x++) {
-                Vector3D v1 = Vector3D(
-                                            0,
-                                            _terrain[QPair<int, int>(x, y + 1)] -
-                                            _terrain[QPair<int, int>(x, y)],
-                                            (double)(y + 1) * 10.0 - (double)y * 10.0);
-
-                Vector3D v2 = Vector3D(
-                                            (double)(x + 1) * 10.0 - (double)x * 10.0,
-                                            _terrain[QPair<int, int>(x + 1, y)] -
-                                            _terrain[QPair<int, int>(x, y)],
-                                            0);
-
-                Vector3D normal = v1.crossProduct(v2);
-                normal.normalize();
-                surfaceNormals[QPair<int, int>(x, y)] = normal;
-            }
-        }
+        allocateMemory();
+        _heights.resize(_width * _height);
+        _tileIds.resize(_width * _height);
+
+        RowJob prototype;
+        prototype._begin = 0;
+        prototype._end = 0;
+        prototype._width = _width;
+        prototype._image = &image;
+        prototype._heightShift = componentShift(heightEncoding);
+        prototype._tileShift = componentShift(textureEncoding);
+        prototype._heights = _heights.data();
+        prototype._tileIds = _tileIds.data();
+        processRows(prototype, _height, decodeRows);
+
+        createChunks();
+        selectAllChunks();
+        return Ok;
+    }
 
-        // Now compute vertex normals for smooth shading
-        for(int y = 0; y < _height; y++) {
-            for(int x = 0; x < _width; x++) {
-                Vector3D vertexNormal;
-                if(x == 0 && y == 0) {
-                    vertexNormal = surfaceNormals[QPair<int, int>(0, 0)];
-                } else if(x > 0 && x < (_width - 1) && y == 0) {
-                    vertexNormal = (surfaceNormals[QPair<int, int>(x - 1, 0)] + surfaceNormals[QPair<int, int>(x, 0)]) * 0.5;
-                } else if(x == (_width - 1) && y == 0) {
-                    vertexNormal = surfaceNormals[QPair<int, int>(_width - 2, 0)];
-                } else if(x == (_width - 1) && y > 0 && y < (_height - 1)) {
-                    vertexNormal = (surfaceNormals[QPair<int, int>(_width - 2, y - 1)] + surfaceNormals[QPair<int, int>(_width - 2, y)]) * 0.5;
-                } else if(x == (_width - 1) && y == (_height - 1)) {
-                    vertexNormal = surfaceNormals[QPair<int, int>(_width - 2, _height - 2)];
-                } else if(x > 0 && x < (_width - 1) && y == (_height - 1)) {
-                    vertexNormal = (surfaceNormals[QPair<int, int>(x - 1, _height - 2)] + surfaceNormals[QPair<int, int>(x, _height - 2)]) * 0.5;
-                } else if(x == 0 && y == (_height - 1)) {
-                    vertexNormal = surfaceNormals[QPair<int, int>(0, _height - 2)];
-                } else if(x == 0 && y > 0 && y < (_height - 1)) {
-                    vertexNormal = (surfaceNormals[QPair<int, int>(0, y - 1)] + surfaceNormals[QPair<int, int>(0, y)]) * 0.5;
-                } else {
-                    vertexNormal = (surfaceNormals[QPair<int, int>(x - 1, y - 1)]
-                            + surfaceNormals[QPair<int, int>(x    , y - 1)]
-                            + surfaceNormals[QPair<int, int>(x    , y    )]
-                            + surfaceNormals[QPair<int, int>(x - 1, y    )]) * 0.25;
-                }
-                vertexNormal.normalize();
-                _normals[QPair<int, int>(x, y)] = vertexNormal;
-            }
+    Terrain::Result Terrain::stream(QString fileName, int width, int height) {
+        _width = width;
+        _height = height;
+
+        if(_width < 2 || _height < 2) {
+            return InvalidImageSize;
         }
 
-        // Translate calculated data into vertex buffer arrays
-        _vertexBuffer = new double[(_width - 1) * (_height - 1) * 4 * 3];
-        _textureCoordinatesBuffer = new double[(_width - 1) * (_height - 1) * 4 * 2];
-        _normalsBuffer = new double[(_width - 1) * (_height - 1) * 4 * 3];
-
-        #define vtx(i, c) ((i) * 3 + (c))
-        #define tex(i, c) ((i) * 2 + (c))
-        #define nml(i, c) ((i) * 3 + (c))
-
-        int i = 0;
-        for(int y = 0; y < _height - 1; y++) {
-            for(int x = 0; x < _width - 1; x++) {
-                QPair<int, int> p1(x, y);
-                QPair<int, int> p2(x, y + 1);
-                QPair<int, int> p3(x + 1, y + 1);
-                QPair<int, int> p4(x + 1, y);
-
-                Vector3D n1 = _normals[p1];
-                Vector3D n2 = _normals[p2];
-                Vector3D n3 = _normals[p3];
-                Vector3D n4 = _normals[p4];
-
-                double tileID = 0; //_tileIDs[p1];
-
-                //
-                _vertexBuffer[vtx(i, 0)] = (double)(x * _scale);
-                _vertexBuffer[vtx(i, 1)] = (double)(_terrain[p1] * _scale / 10.0);
-                _vertexBuffer[vtx(i, 2)] = (double)(y * _scale);
-                _textureCoordinatesBuffer[tex(i, 0)] = _tilingOffset * (double)tileID;
-                _textureCoordinatesBuffer[tex(i, 1)] = 0.0f;
-                _normalsBuffer[nml(i, 0)] = (double)n1.x();
-                _normalsBuffer[nml(i, 1)] = (double)n1.y();
-                _normalsBuffer[nml(i, 2)] = (double)n1.z();
-                i++;
-
-                //
-                _vertexBuffer[vtx(i, 0)] = (double)(x * _scale);
-                _vertexBuffer[vtx(i, 1)] = (double)(_terrain[p2] * _scale / 10.0);
-                _vertexBuffer[vtx(i, 2)] = (double)((y + 1) * _scale);
-                _textureCoordinatesBuffer[tex(i, 0)] = _tilingOffset * (double)tileID;
-                _textureCoordinatesBuffer[tex(i, 1)] = 1.0f;
-                _normalsBuffer[nml(i, 0)] = (double)n2.x();
-                _normalsBuffer[nml(i, 1)] = (double)n2.y();
-                _normalsBuffer[nml(i, 2)] = (double)n2.z();
-                i++;
-
-                //
-                _vertexBuffer[vtx(i, 0)] = (double)((x + 1) * _scale);
-                _vertexBuffer[vtx(i, 1)] = (double)(_terrain[p3] * _scale / 10.0);
-                _vertexBuffer[vtx(i, 2)] = (double)((y + 1) * _scale);
-                _textureCoordinatesBuffer[tex(i, 0)] = _tilingOffset * (double)tileID + _tilingOffset;
-                _textureCoordinatesBuffer[tex(i, 1)] = 1.0f;
-                _normalsBuffer[nml(i, 0)] = (double)n3.x();
-                _normalsBuffer[nml(i, 1)] = (double)n3.y();
-                _normalsBuffer[nml(i, 2)] = (double)n3.z();
-                i++;
-
-                //
-                _vertexBuffer[vtx(i, 0)] = (double)((x + 1) * _scale);
-                _vertexBuffer[vtx(i, 1)] = (double)(_terrain[p4] * _scale / 10.0);
-                _vertexBuffer[vtx(i, 2)] = (double)(y * _scale);
-                _textureCoordinatesBuffer[tex(i, 0)] = _tilingOffset * (double)tileID + _tilingOffset;
-                _textureCoordinatesBuffer[tex(i, 1)] = 0.0f;
-                _normalsBuffer[nml(i, 0)] = (double)n4.x();
-                _normalsBuffer[nml(i, 1)] = (double)n4.y();
-                _normalsBuffer[nml(i, 2)] = (double)n4.z();
-                i++;
-            }
+        allocateMemory();
+        if(!_heightmap.map(fileName, _width, _height)) {
+            return FileLoadError;
         }
 
+        createChunks();
         return Ok;
     }
 
+    bool Terrain::isStreamed() {
+        return _heightmap.isMapped();
+    }
+
     void Terrain::setTilingOffset(double tilingOffset) {
         _tilingOffset = tilingOffset;
     }
@@ -239,23 +292,98 @@ namespace Glee3D {
         return _height;
     }
 
+    void Terrain::setPixelError(double pixelError) {
+        _pixelError = qMax(0.0, pixelError);
+    }
+
+    double Terrain::pixelError() {
+        return _pixelError;
+    }
+
+    void Terrain::selectChunks(const Frustum& frustum, Vector3D cameraPosition, double projectionScale) {
+        _selectedChunks.clear();
+        _levelsOfDetail.fill(-1);
+        if(!_quadTree.isEmpty()) {
+            selectNode(0, frustum, false, cameraPosition, projectionScale);
+        }
+        balanceLevelsOfDetail();
+    }
+
+    void Terrain::setMemoryBudget(qint64 memoryBudget) {
+        _memoryBudget = qMax((qint64)0, memoryBudget);
+    }
+
+    qint64 Terrain::memoryBudget() {
+        return _memoryBudget;
+    }
+
+    qint64 Terrain::memoryUsage() {
+        return _memoryUsage;
+    }
+
+    void Terrain::setStreamingJobLimit(int jobCount) {
+        _streamingJobLimit = qMax(1, jobCount);
+    }
+
+    int Terrain::streamingJobLimit() {
+        return _streamingJobLimit;
+    }
+
+    void Terrain::setUploadBudget(int bytes, int milliseconds) {
+        _uploadBudgetBytes = bytes;
+        _uploadBudgetMilliseconds = milliseconds;
+    }
+
+    int Terrain::uploadBudgetBytes() {
+        return _uploadBudgetBytes;
+    }
+
+    int Terrain::uploadBudgetMilliseconds() {
+        return _uploadBudgetMilliseconds;
+    }
+
+    int Terrain::drawnChunkCount() {
+        return _drawnChunkCount;
+    }
+
+    int Terrain::chunkCount() {
+        return _chunks.size();
+    }
+
+    TerrainChunk *Terrain::chunk(int index) {
+        return _chunks.value(index);
+    }
+
     void Terrain::render(RenderMode renderMode) {
         Q_UNUSED(renderMode);
-        material()->activate();
+        _drawnChunkCount = 0;
+        if(_chunks.isEmpty()) {
+            return;
+        }
 
-        glVertexPointer(3, GL_DOUBLE, 0, _vertexBuffer);
-        glTexCoordPointer(2, GL_DOUBLE, 0, _textureCoordinatesBuffer);
-        glNormalPointer(GL_DOUBLE, 0, _normalsBuffer);
+        if(!_indexBufferHandle) {
+            uploadIndices();
+        }
+        uploadSelectedChunks();
 
-        glEnableClientState(GL_VERTEX_ARRAY);
-        glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-        glEnableClientState(GL_NORMAL_ARRAY);
+        material()->activate();
 
-        glDrawArrays(GL_QUADS, 0, (_width - 1) * (_height - 1) * 4);
+        // Texture coordinates run across the whole terrain.
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+        foreach(int i, _selectedChunks) {
+            TerrainChunk *chunk = _chunks[i];
+            quint32 key = TerrainChunk::patternKey(chunk->width(), chunk->height(),
+                                                   _levelsOfDetail[i], _stitchings[i]);
+            if(!_indexRanges.contains(key)) {
+                continue;
+            }
 
-        glDisableClientState(GL_VERTEX_ARRAY);
-        glDisableClientState(GL_TEXTURE_COORD_ARRAY);
-        glDisableClientState(GL_NORMAL_ARRAY);
+            IndexRange range = _indexRanges.value(key);
+            chunk->render(range._offset, range._count);
+            _drawnChunkCount++;
+        }
     }
 
     QString Terrain::className() {
@@ -278,8 +406,353 @@ namespace Glee3D {
     }
 
     void Terrain::freeMemory() {
-        _terrain.clear();
-        _tileIDs.clear();
-        _normals.clear();
+        // Chunks must not be deleted while they are being built.
+        foreach(QFuture<void> future, _streamedChunks) {
+            future.waitForFinished();
+        }
+        _streamedChunks.clear();
+
+        _heights.clear();
+        _tileIds.clear();
+        _heightmap.unmap();
+
+        foreach(TerrainChunk *chunk, _chunks) {
+            chunk->release();
+            delete chunk;
+        }
+        _chunks.clear();
+        _chunkColumns = 0;
+        _chunkRows = 0;
+        _quadTree.clear();
+        _selectedChunks.clear();
+        _levelsOfDetail.clear();
+        _stitchings.clear();
+        _distances.clear();
+        _lastSelectedFrames.clear();
+        _memoryUsage = 0;
+
+        _indexRanges.clear();
+        if(_indexBufferHandle) {
+            glDeleteBuffers(1, &_indexBufferHandle);
+            _indexBufferHandle = 0;
+        }
+    }
+
+    void Terrain::createChunks() {
+        // Chunks share their border vertices.
+        int quadColumns = _width - 1;
+        int quadRows = _height - 1;
+        _chunkColumns = (quadColumns + TerrainChunk::Size - 1) / TerrainChunk::Size;
+        _chunkRows = (quadRows + TerrainChunk::Size - 1) / TerrainChunk::Size;
+        for(int row = 0; row < _chunkRows; row++) {
+            for(int column = 0; column < _chunkColumns; column++) {
+                int x = column * TerrainChunk::Size;
+                int y = row * TerrainChunk::Size;
+                _chunks.append(new TerrainChunk(x, y,
+                                                qMin((int)TerrainChunk::Size, quadColumns - x),
+                                                qMin((int)TerrainChunk::Size, quadRows - y)));
+            }
+        }
+
+        // Streamed heightmaps are read once here, chunk by chunk, so only
+        // the chunk summaries stay in memory.
+        ChunkAnalyzer analyzer;
+        analyzer._source._heights = _heights.constData();
+        analyzer._source._width = _width;
+        analyzer._source._height = _height;
+        analyzer._source._heightmap = _heightmap.isMapped() ? &_heightmap : 0;
+        analyzer._scale = _scale;
+        analyzer._heightScale = _scale / 10.0;
+        QtConcurrent::blockingMap(_chunks, analyzer);
+
+        buildQuadTree(0, 0, _chunkColumns, _chunkRows);
+
+        _levelsOfDetail.fill(-1, _chunks.size());
+        _stitchings.fill(0, _chunks.size());
+        _distances.fill(0.0, _chunks.size());
+        _lastSelectedFrames.fill(0, _chunks.size());
+    }
+
+    int Terrain::buildQuadTree(int column, int row, int columns, int rows) {
+        int index = _quadTree.size();
+        QuadTreeNode node;
+        node._chunk = -1;
+        for(int i = 0; i < 4; i++) {
+            node._children[i] = -1;
+        }
+        _quadTree.append(node);
+
+        if(columns == 1 && rows == 1) {
+            int chunk = row * _chunkColumns + column;
+            _quadTree[index]._chunk = chunk;
+            _quadTree[index]._boundingBox = _chunks[chunk]->boundingBox();
+            return index;
+        }
+
+        int leftColumns = (columns + 1) / 2;
+        int topRows = (rows + 1) / 2;
+        int childColumns[4] = { column, column + leftColumns, column, column + leftColumns };
+        int childRows[4] = { row, row, row + topRows, row + topRows };
+        int childWidths[4] = { leftColumns, columns - leftColumns, leftColumns, columns - leftColumns };
+        int childHeights[4] = { topRows, topRows, rows - topRows, rows - topRows };
+
+        AxisAlignedBox boundingBox;
+        for(int i = 0; i < 4; i++) {
+            if(childWidths[i] <= 0 || childHeights[i] <= 0) {
+                continue;
+            }
+
+            // Appending children may move the nodes, so no references here.
+            int child = buildQuadTree(childColumns[i], childRows[i], childWidths[i], childHeights[i]);
+            _quadTree[index]._children[i] = child;
+            boundingBox.extend(_quadTree[child]._boundingBox._minimum);
+            boundingBox.extend(_quadTree[child]._boundingBox._maximum);
+        }
+        _quadTree[index]._boundingBox = boundingBox;
+        return index;
+    }
+
+    void Terrain::selectNode(int node,
+                             const Frustum& frustum,
+                             bool insideFrustum,
+                             Vector3D cameraPosition,
+                             double projectionScale) {
+        const QuadTreeNode& quadTreeNode = _quadTree[node];
+        if(!insideFrustum) {
+            Frustum::Classification classification = frustum.classify(quadTreeNode._boundingBox);
+            if(classification == Frustum::Outside) {
+                return;
+            }
+            insideFrustum = (classification == Frustum::Inside);
+        }
+
+        if(quadTreeNode._chunk < 0) {
+            for(int i = 0; i < 4; i++) {
+                if(quadTreeNode._children[i] >= 0) {
+                    selectNode(quadTreeNode._children[i], frustum, insideFrustum, cameraPosition, projectionScale);
+                }
+            }
+            return;
+        }
+
+        // Choose the coarsest level whose error stays below the tolerated
+        // error on screen.
+        TerrainChunk *chunk = _chunks[quadTreeNode._chunk];
+        double chunkDistance = distance(quadTreeNode._boundingBox, cameraPosition);
+        int levelOfDetail = 0;
+        for(int level = chunk->maximumLevelOfDetail(); level > 0; level--) {
+            if(chunk->error(level) * projectionScale <= _pixelError * chunkDistance) {
+                levelOfDetail = level;
+                break;
+            }
+        }
+
+        _levelsOfDetail[quadTreeNode._chunk] = levelOfDetail;
+        _distances[quadTreeNode._chunk] = chunkDistance;
+        _selectedChunks.append(quadTreeNode._chunk);
+    }
+
+    void Terrain::selectAllChunks() {
+        _selectedChunks.clear();
+        _levelsOfDetail.fill(0, _chunks.size());
+        _stitchings.fill(0, _chunks.size());
+        for(int i = 0; i < _chunks.size(); i++) {
+            _selectedChunks.append(i);
+        }
+    }
+
+    void Terrain::balanceLevelsOfDetail() {
+        // Refining a chunk may require refining its neighbours, so repeat
+        // until nothing changes. Levels only ever decrease, so this ends.
+        bool changed = true;
+        while(changed) {
+            changed = false;
+            foreach(int i, _selectedChunks) {
+                int column = i % _chunkColumns;
+                int row = i / _chunkColumns;
+                int neighbours[4] = {
+                    column > 0 ? i - 1 : -1,
+                    column < _chunkColumns - 1 ? i + 1 : -1,
+                    row > 0 ? i - _chunkColumns : -1,
+                    row < _chunkRows - 1 ? i + _chunkColumns : -1
+                };
+                for(int n = 0; n < 4; n++) {
+                    if(neighbours[n] >= 0 && _levelsOfDetail[neighbours[n]] >= 0
+                    && _levelsOfDetail[i] > _levelsOfDetail[neighbours[n]] + 1) {
+                        _levelsOfDetail[i] = _levelsOfDetail[neighbours[n]] + 1;
+                        changed = true;
+                    }
+                }
+            }
+        }
+
+        // Chunks that are not drawn cannot show cracks.
+        static const int stitchings[4] = {
+            TerrainChunk::StitchMinimumX,
+            TerrainChunk::StitchMaximumX,
+            TerrainChunk::StitchMinimumY,
+            TerrainChunk::StitchMaximumY
+        };
+        foreach(int i, _selectedChunks) {
+            int column = i % _chunkColumns;
+            int row = i / _chunkColumns;
+            int neighbours[4] = {
+                column > 0 ? i - 1 : -1,
+                column < _chunkColumns - 1 ? i + 1 : -1,
+                row > 0 ? i - _chunkColumns : -1,
+                row < _chunkRows - 1 ? i + _chunkColumns : -1
+            };
+            _stitchings[i] = 0;
+            for(int n = 0; n < 4; n++) {
+                if(neighbours[n] >= 0 && _levelsOfDetail[neighbours[n]] == _levelsOfDetail[i] + 1) {
+                    _stitchings[i] |= stitchings[n];
+                }
+            }
+        }
+    }
+
+    void Terrain::uploadIndices() {
+        // There are at most four different chunk sizes, at the far borders.
+        QVector<GLushort> indices;
+        foreach(TerrainChunk *chunk, _chunks) {
+            int width = chunk->width();
+            int height = chunk->height();
+            for(int level = 0; level <= chunk->maximumLevelOfDetail(); level++) {
+                if(_indexRanges.contains(TerrainChunk::patternKey(width, height, level, 0))) {
+                    break;
+                }
+
+                for(int stitching = 0; stitching < TerrainChunk::StitchingCount; stitching++) {
+                    // A coarser neighbour shares the edge, so patterns for
+                    // edges it could not have are never needed.
+                    if(((stitching & (TerrainChunk::StitchMinimumX | TerrainChunk::StitchMaximumX))
+                        && !stitchable(height >> level))
+                    || ((stitching & (TerrainChunk::StitchMinimumY | TerrainChunk::StitchMaximumY))
+                        && !stitchable(width >> level))) {
+                        continue;
+                    }
+
+                    IndexRange range;
+                    range._offset = indices.size();
+                    TerrainChunk::appendPattern(indices, width, height, level, stitching);
+                    range._count = indices.size() - range._offset;
+                    _indexRanges.insert(TerrainChunk::patternKey(width, height, level, stitching), range);
+                }
+            }
+        }
+
+        glGenBuffers(1, &_indexBufferHandle);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _indexBufferHandle);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * indices.size(), indices.constData(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    }
+
+    void Terrain::uploadSelectedChunks() {
+        _frame++;
+        foreach(int i, _selectedChunks) {
+            _lastSelectedFrames[i] = _frame;
+        }
+
+        if(_heightmap.isMapped()) {
+            // Uploading first frees up jobs for the chunks still missing.
+            uploadStreamedChunks();
+        }
+
+        QList<QPair<double, int> > missingChunks;
+        foreach(int i, _selectedChunks) {
+            if(!_chunks[i]->isUploaded() && !_streamedChunks.contains(i)) {
+                missingChunks.append(qMakePair(_distances[i], i));
+            }
+        }
+
+        VertexBuilder builder;
+        builder._source._heights = _heights.constData();
+        builder._source._width = _width;
+        builder._source._height = _height;
+        builder._source._heightmap = _heightmap.isMapped() ? &_heightmap : 0;
+        builder._scale = _scale;
+        builder._heightScale = _scale / 10.0;
+        builder._tilingOffset = _tilingOffset;
+
+        if(_heightmap.isMapped()) {
+            // Chunks are started nearest first, rendering does not wait.
+            // The rest is reconsidered next frame, with the camera moved.
+            std::sort(missingChunks.begin(), missingChunks.end());
+            for(int i = 0; i < missingChunks.size() && _streamedChunks.size() < _streamingJobLimit; i++) {
+                int index = missingChunks[i].second;
+                _streamedChunks.insert(index, QtConcurrent::run(builder, _chunks[index]));
+            }
+        } else if(!missingChunks.isEmpty()) {
+            QList<TerrainChunk*> chunks;
+            for(int i = 0; i < missingChunks.size(); i++) {
+                chunks.append(_chunks[missingChunks[i].second]);
+            }
+            QtConcurrent::blockingMap(chunks, builder);
+
+            foreach(TerrainChunk *chunk, chunks) {
+                chunk->upload(_indexBufferHandle);
+                _memoryUsage += chunk->uploadedSize();
+            }
+        }
+
+        evictChunks();
+    }
+
+    void Terrain::uploadStreamedChunks() {
+        QList<QPair<double, int> > builtChunks;
+        QHash<int, QFuture<void> >::iterator i = _streamedChunks.begin();
+        while(i != _streamedChunks.end()) {
+            if(!i.value().isFinished()) {
+                ++i;
+            } else if(_lastSelectedFrames[i.key()] != _frame) {
+                // Out of sight again, it is built anew when it comes back.
+                _chunks[i.key()]->freeVertices();
+                i = _streamedChunks.erase(i);
+            } else {
+                builtChunks.append(qMakePair(_distances[i.key()], i.key()));
+                ++i;
+            }
+        }
+        std::sort(builtChunks.begin(), builtChunks.end());
+
+        QElapsedTimer timer;
+        timer.start();
+        qint64 bytes = 0;
+        for(int j = 0; j < builtChunks.size(); j++) {
+            TerrainChunk *chunk = _chunks[builtChunks[j].second];
+            qint64 size = chunk->vertexSize();
+            if(j > 0
+            && (bytes + size > _uploadBudgetBytes
+             || timer.elapsed() >= _uploadBudgetMilliseconds)) {
+                // Continue next frame.
+                break;
+            }
+
+            chunk->upload(_indexBufferHandle);
+            _memoryUsage += chunk->uploadedSize();
+            bytes += size;
+            _streamedChunks.remove(builtChunks[j].second);
+        }
+    }
+
+    void Terrain::evictChunks() {
+        if(_memoryBudget <= 0 || _memoryUsage <= _memoryBudget) {
+            return;
+        }
+
+        // Release the chunks that have not been selected for the longest time.
+        QList<QPair<int, int> > candidates;
+        for(int i = 0; i < _chunks.size(); i++) {
+            if(_chunks[i]->isUploaded() && _lastSelectedFrames[i] != _frame) {
+                candidates.append(qMakePair(_lastSelectedFrames[i], i));
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+
+        for(int i = 0; i < candidates.size() && _memoryUsage > _memoryBudget; i++) {
+            TerrainChunk *chunk = _chunks[candidates[i].second];
+            _memoryUsage -= chunk->uploadedSize();
+            chunk->release();
+        }
     }
 } // namespace Glee3D
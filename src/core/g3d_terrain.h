@@ -23,17 +23,47 @@
 
 // Own includes
 #include "g3d_entity.h"
+#include "g3d_vertex.h"
+#include "g3d_terrainchunk.h"
+#include "g3d_heightmap.h"
+#include "math/g3d_frustum.h"
 
 // Qt includes
 #include <QString>
+#include <QVector>
+#include <QList>
 #include <QHash>
-#include <QPair>
+#include <QImage>
+#include <QFuture>
 
 namespace Glee3D {
     /**
       * @class Terrain
       * @author Jacob Dawid (jacob.dawid@omg-it.works)
       * @date 18.08.2013
+      *
+      * Heights and tile ids are stored in contiguous row-major arrays with
+      * one entry per heightmap pixel. Generating decodes the image row by
+      * row and spreads the rows over all cores.
+      *
+      * The terrain is split into TerrainChunks, which are organized in a
+      * quadtree. Before rendering, selectChunks() culls the quadtree against
+      * the viewing frustum and chooses a level of detail for each visible
+      * chunk, so that its height error projected on screen stays below
+      * pixelError(). Neighbouring chunks differ by one level at most, the
+      * finer one is stitched to the coarser one.
+      *
+      * Chunk vertices are built and uploaded the first time a chunk is
+      * visible, after which the CPU copies are freed. When they exceed
+      * memoryBudget(), the chunks that have not been visible for the
+      * longest time are released again.
+      *
+      * Terrains too large for memory can be streamed from a raw Heightmap
+      * instead. Streamed chunks are built on background threads and are
+      * drawn once they are ready. Each frame, the nearest visible chunks are
+      * started, up to streamingJobLimit() at a time, so chunks that went out
+      * of sight are not built anymore. Built chunks are uploaded within a
+      * per-frame budget, and dropped if they are not visible anymore.
       */
     class Terrain :
         public Anchored,
@@ -56,6 +86,11 @@ namespace Glee3D {
         explicit Terrain();
         virtual ~Terrain();
 
+        /**
+         * Generates the terrain from a heightmap.
+         * @returns InvalidImageSize, if the image is not at least two pixels
+         * wide and high.
+         */
         Result generate(QString fileName,
                         Encoding heightEncoding = RedComponent,
                         Encoding textureEncoding = GreenComponent);
@@ -63,6 +98,18 @@ namespace Glee3D {
                         Encoding heightEncoding = RedComponent,
                         Encoding textureEncoding = GreenComponent);
 
+        /**
+         * Streams the terrain from a raw 16 bit heightmap, see Heightmap.
+         * Only the bounding boxes and errors of the chunks are determined
+         * here. Nothing is drawn before selectChunks() has been called.
+         * @returns FileLoadError, if the file could not be mapped or does
+         * not match the given size.
+         */
+        Result stream(QString fileName, int width, int height);
+
+        /** @returns true, if the terrain is streamed from a heightmap. */
+        bool isStreamed();
+
         void setTilingOffset(double tilingOffset);
         void setScale(double scale);
 
@@ -70,6 +117,76 @@ namespace Glee3D {
         int width();
         int height();
 
+        /**
+         * Sets how far, in pixels, a reduced level of detail may deviate
+         * from the full terrain on screen.
+         * @param pixelError Tolerated error in pixels, defaults to 2.
+         */
+        void setPixelError(double pixelError);
+
+        /** @returns how far a reduced level of detail may deviate from the
+          * full terrain on screen. */
+        double pixelError();
+
+        /**
+         * Chooses the chunks to render and their levels of detail. Until
+         * this is called, all chunks are rendered at full detail.
+         * @param frustum Viewing frustum in terrain space.
+         * @param cameraPosition Camera position in terrain space.
+         * @param projectionScale Pixels covered by one unit at a distance of
+         * one unit, ie. half the viewport height times the vertical focal
+         * length of the projection.
+         */
+        void selectChunks(const Frustum& frustum, Vector3D cameraPosition, double projectionScale);
+
+        /**
+         * Sets how much memory chunk vertices may take on the graphics card.
+         * Chunks visible in the current frame are never released, so the
+         * budget may be exceeded temporarily.
+         * @param memoryBudget Budget in bytes, or 0 for no limit. Defaults
+         * to 256 MiB.
+         */
+        void setMemoryBudget(qint64 memoryBudget);
+
+        /** @returns how much memory chunk vertices may take. */
+        qint64 memoryBudget();
+
+        /** @returns how much memory chunk vertices take at the moment. */
+        qint64 memoryUsage();
+
+        /**
+         * Sets how many streamed chunks may be built at the same time.
+         * @param jobCount Maximum number of chunks, defaults to the number
+         * of cores.
+         */
+        void setStreamingJobLimit(int jobCount);
+
+        /** @returns how many streamed chunks may be built at the same time. */
+        int streamingJobLimit();
+
+        /**
+         * Sets the budget for uploading streamed chunks per frame. At least
+         * one chunk is uploaded per frame if there is one waiting.
+         * @param bytes Maximum number of bytes uploaded per frame.
+         * @param milliseconds Maximum time spent on uploads per frame.
+         */
+        void setUploadBudget(int bytes, int milliseconds);
+
+        /** @returns the maximum number of bytes uploaded per frame. */
+        int uploadBudgetBytes();
+
+        /** @returns the maximum time in milliseconds spent on uploads per frame. */
+        int uploadBudgetMilliseconds();
+
+        /** @returns the number of chunks drawn by the last render. */
+        int drawnChunkCount();
+
+        /** @returns the number of chunks the heightfield is split into. */
+        int chunkCount();
+
+        /** @returns the chunk at the given index, row by row. */
+        TerrainChunk *chunk(int index);
+
         void render(RenderMode renderMode = Textured);
 
         QString className();
@@ -79,20 +196,90 @@ namespace Glee3D {
     protected:
 
     private:
+        /** A node of the chunk quadtree. Leaves refer to a single chunk. */
+        struct QuadTreeNode {
+            AxisAlignedBox _boundingBox;
+            int _children[4];
+            int _chunk;
+        };
+
+        /** A range of the shared index buffer. */
+        struct IndexRange {
+            int _offset;
+            int _count;
+        };
+
         void allocateMemory();
         void freeMemory();
 
+        /** Splits the heightfield into analyzed chunks and builds the
+          * quadtree above them. */
+        void createChunks();
+
+        /** Builds the quadtree node for the given range of chunks.
+          * @returns the index of the node. */
+        int buildQuadTree(int column, int row, int columns, int rows);
+
+        /** Selects the visible chunks below the given quadtree node. */
+        void selectNode(int node,
+                        const Frustum& frustum,
+                        bool insideFrustum,
+                        Vector3D cameraPosition,
+                        double projectionScale);
+
+        /** Selects all chunks at full detail. */
+        void selectAllChunks();
+
+        /** Limits the level of detail differences between neighbouring
+          * chunks to one and determines which edges to stitch. */
+        void balanceLevelsOfDetail();
+
+        /** Uploads the index patterns for all chunk sizes. */
+        void uploadIndices();
+
+        /** Builds and uploads the vertices of the selected chunks. */
+        void uploadSelectedChunks();
+
+        /** Uploads streamed chunks whose vertices have been built, within the
+          * upload budget, and drops those that are not selected anymore. */
+        void uploadStreamedChunks();
+
+        /** Releases chunks until the memory budget is met. */
+        void evictChunks();
+
         double _scale;
-        QHash<QPair<int, int>, double> _terrain;
-        QHash<QPair<int, int>, int> _tileIDs;
-        QHash<QPair<int, int>, Vector3D> _normals;
+        QVector<float> _heights;
+        QVector<uchar> _tileIds;
         double _tilingOffset;
         int _width;
         int _height;
+        double _pixelError;
+
+        QList<TerrainChunk*> _chunks;
+        int _chunkColumns;
+        int _chunkRows;
+        QVector<QuadTreeNode> _quadTree;
+
+        QVector<int> _selectedChunks;
+        QVector<int> _levelsOfDetail;
+        QVector<int> _stitchings;
+        QVector<double> _distances;
+        int _drawnChunkCount;
+
+        Heightmap _heightmap;
+        /** Chunks being built or waiting for upload, by index. */
+        QHash<int, QFuture<void> > _streamedChunks;
+        int _streamingJobLimit;
+        int _uploadBudgetBytes;
+        int _uploadBudgetMilliseconds;
+
+        QVector<int> _lastSelectedFrames;
+        int _frame;
+        qint64 _memoryBudget;
+        qint64 _memoryUsage;
 
-        double *_vertexBuffer;
-        double *_textureCoordinatesBuffer;
-        double *_normalsBuffer;
+        QHash<quint32, IndexRange> _indexRanges;
+        GLuint _indexBufferHandle;
     };
 } // namespace Glee3D
 
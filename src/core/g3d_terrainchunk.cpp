@@ -0,0 +1,297 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_terrainchunk.h"
+#include "g3d_rendercounters.h"
+
+// Standard includes
+#include <math.h>
+
+namespace Glee3D {
+    namespace {
+        /** Horizontal distance of neighbouring heightmap pixels for normals. */
+        const float gridSpacing = 10.0f;
+
+        /** @returns the height at the given column and row, which has to
+          * lie within the region. */
+        float heightAt(const TerrainChunk::Heights& heights, int x, int y) {
+            return heights._data[(y - heights._y) * heights._width + (x - heights._x)];
+        }
+
+        /** Adds the normal of the quad at the given column and row, clamped
+          * to the heightfield, to the given normal. */
+        void addFaceNormal(const TerrainChunk::Heights& heights, int x, int y, float *normal) {
+            x = qBound(0, x, heights._heightfieldWidth - 2);
+            y = qBound(0, y, heights._heightfieldHeight - 2);
+            float height = heightAt(heights, x, y);
+            float dx = heightAt(heights, x + 1, y) - height;
+            float dy = heightAt(heights, x, y + 1) - height;
+
+            // Equals (0, dy, s) x (s, dx, 0) divided by s.
+            float inverseLength = 1.0f / sqrtf(dx * dx + dy * dy + gridSpacing * gridSpacing);
+            normal[0] -= dx * inverseLength;
+            normal[1] += gridSpacing * inverseLength;
+            normal[2] -= dy * inverseLength;
+        }
+
+        /** @returns the index of the given pattern vertex after collapsing
+          * the vertices a coarser neighbour does not have. */
+        GLushort patternIndex(int x, int y, int width, int height, int step, int stitching) {
+            if(y == 0 && (stitching & TerrainChunk::StitchMinimumY) && (x / step) % 2) {
+                x -= step;
+            } else if(y == height && (stitching & TerrainChunk::StitchMaximumY) && (x / step) % 2) {
+                x -= step;
+            } else if(x == 0 && (stitching & TerrainChunk::StitchMinimumX) && (y / step) % 2) {
+                y -= step;
+            } else if(x == width && (stitching & TerrainChunk::StitchMaximumX) && (y / step) % 2) {
+                y -= step;
+            }
+            return (GLushort)(y * (width + 1) + x);
+        }
+
+        /** Appends a triangle, unless collapsing made it degenerate. */
+        void appendTriangle(QVector<GLushort>& indices, GLushort a, GLushort b, GLushort c) {
+            if(a == b || b == c || a == c) {
+                return;
+            }
+            indices.append(a);
+            indices.append(b);
+            indices.append(c);
+        }
+    }
+
+    TerrainChunk::TerrainChunk(int x, int y, int width, int height) {
+        _x = x;
+        _y = y;
+        _width = width;
+        _height = height;
+        _vertexArrayHandle = 0;
+        _vertexBufferHandle = 0;
+
+        // Every level has to cover the chunk with whole quads.
+        _maximumLevelOfDetail = 0;
+        while(_maximumLevelOfDetail + 1 < LevelOfDetailCount
+              && _width % (2 << _maximumLevelOfDetail) == 0
+              && _height % (2 << _maximumLevelOfDetail) == 0) {
+            _maximumLevelOfDetail++;
+        }
+
+        for(int i = 0; i < LevelOfDetailCount; i++) {
+            _errors[i] = 0.0;
+        }
+    }
+
+    TerrainChunk::~TerrainChunk() {
+    }
+
+    int TerrainChunk::x() {
+        return _x;
+    }
+
+    int TerrainChunk::y() {
+        return _y;
+    }
+
+    int TerrainChunk::width() {
+        return _width;
+    }
+
+    int TerrainChunk::height() {
+        return _height;
+    }
+
+    int TerrainChunk::maximumLevelOfDetail() {
+        return _maximumLevelOfDetail;
+    }
+
+    AxisAlignedBox TerrainChunk::boundingBox() {
+        return _boundingBox;
+    }
+
+    double TerrainChunk::error(int levelOfDetail) {
+        return _errors[qBound(0, levelOfDetail, (int)LevelOfDetailCount - 1)];
+    }
+
+    void TerrainChunk::analyze(const Heights& heights, double scale, double heightScale) {
+        float minimumHeight = heightAt(heights, _x, _y);
+        float maximumHeight = minimumHeight;
+        for(int y = _y; y <= _y + _height; y++) {
+            for(int x = _x; x <= _x + _width; x++) {
+                float height = heightAt(heights, x, y);
+                minimumHeight = qMin(minimumHeight, height);
+                maximumHeight = qMax(maximumHeight, height);
+            }
+        }
+
+        _boundingBox = AxisAlignedBox(Vector3D(_x * scale, minimumHeight * heightScale, _y * scale),
+                                      Vector3D((_x + _width) * scale, maximumHeight * heightScale, (_y + _height) * scale));
+
+        // The error of a level is how far the skipped vertices are off the
+        // surface interpolated between the remaining ones.
+        _errors[0] = 0.0;
+        for(int level = 1; level <= _maximumLevelOfDetail; level++) {
+            int step = 1 << level;
+            float error = 0.0f;
+            for(int y = 0; y <= _height; y++) {
+                int y0 = y - y % step;
+                int y1 = qMin(y0 + step, _height);
+                float fy = y1 > y0 ? (float)(y - y0) / step : 0.0f;
+                for(int x = 0; x <= _width; x++) {
+                    int x0 = x - x % step;
+                    int x1 = qMin(x0 + step, _width);
+                    float fx = x1 > x0 ? (float)(x - x0) / step : 0.0f;
+                    float h00 = heightAt(heights, _x + x0, _y + y0);
+                    float h10 = heightAt(heights, _x + x1, _y + y0);
+                    float h01 = heightAt(heights, _x + x0, _y + y1);
+                    float h11 = heightAt(heights, _x + x1, _y + y1);
+                    float top = h00 + (h10 - h00) * fx;
+                    float bottom = h01 + (h11 - h01) * fx;
+                    float interpolated = top + (bottom - top) * fy;
+                    error = qMax(error, fabsf(heightAt(heights, _x + x, _y + y) - interpolated));
+                }
+            }
+            // Coarser levels must never look better than finer ones.
+            _errors[level] = qMax(_errors[level - 1], (double)error * heightScale);
+        }
+    }
+
+    void TerrainChunk::buildVertices(const Heights& heights,
+                                     double scale,
+                                     double heightScale,
+                                     double tilingOffset) {
+        _vertices.resize((_width + 1) * (_height + 1));
+        Vertex *vertex = _vertices.data();
+        for(int y = _y; y <= _y + _height; y++) {
+            for(int x = _x; x <= _x + _width; x++) {
+                float normal[3] = { 0.0f, 0.0f, 0.0f };
+                addFaceNormal(heights, x - 1, y - 1, normal);
+                addFaceNormal(heights, x    , y - 1, normal);
+                addFaceNormal(heights, x    , y    , normal);
+                addFaceNormal(heights, x - 1, y    , normal);
+                float inverseLength = 1.0f / sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+
+                vertex->_position[0] = (GLfloat)(x * scale);
+                vertex->_position[1] = (GLfloat)(heightAt(heights, x, y) * heightScale);
+                vertex->_position[2] = (GLfloat)(y * scale);
+                vertex->_normal[0] = normal[0] * inverseLength;
+                vertex->_normal[1] = normal[1] * inverseLength;
+                vertex->_normal[2] = normal[2] * inverseLength;
+                vertex->_texCoord[0] = (GLfloat)(x * tilingOffset);
+                vertex->_texCoord[1] = (GLfloat)y;
+                vertex++;
+            }
+        }
+    }
+
+    bool TerrainChunk::hasVertices() {
+        return !_vertices.isEmpty();
+    }
+
+    QVector<Vertex> TerrainChunk::vertices() {
+        return _vertices;
+    }
+
+    bool TerrainChunk::isUploaded() {
+        return _vertexArrayHandle != 0;
+    }
+
+    void TerrainChunk::upload(GLuint indexBufferHandle) {
+        if(_vertices.isEmpty()) {
+            return;
+        }
+
+        if(!_vertexArrayHandle) {
+            glGenVertexArrays(1, &_vertexArrayHandle);
+            glGenBuffers(1, &_vertexBufferHandle);
+        }
+
+        glBindVertexArray(_vertexArrayHandle);
+        glBindBuffer(GL_ARRAY_BUFFER, _vertexBufferHandle);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * _vertices.size(), _vertices.constData(), GL_STATIC_DRAW);
+        Vertex::describeLayout();
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferHandle);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+        // The vertices live on the graphics card now
+        _vertices = QVector<Vertex>();
+    }
+
+    void TerrainChunk::freeVertices() {
+        _vertices = QVector<Vertex>();
+    }
+
+    qint64 TerrainChunk::vertexSize() {
+        return (qint64)sizeof(Vertex) * (_width + 1) * (_height + 1);
+    }
+
+    qint64 TerrainChunk::uploadedSize() {
+        if(!_vertexArrayHandle) {
+            return 0;
+        }
+        return vertexSize();
+    }
+
+    void TerrainChunk::release() {
+        if(_vertexArrayHandle) {
+            glDeleteVertexArrays(1, &_vertexArrayHandle);
+            glDeleteBuffers(1, &_vertexBufferHandle);
+            _vertexArrayHandle = 0;
+            _vertexBufferHandle = 0;
+        }
+    }
+
+    void TerrainChunk::render(int offset, int count) {
+        if(!_vertexArrayHandle || count <= 0) {
+            return;
+        }
+
+        glBindVertexArray(_vertexArrayHandle);
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, (const GLvoid*)(offset * sizeof(GLushort)));
+        glBindVertexArray(0);
+        G3D_COUNT_BUFFER_BINDS(1);
+        G3D_COUNT_DRAW_CALL(count / 3);
+    }
+
+    quint32 TerrainChunk::patternKey(int width, int height, int levelOfDetail, int stitching) {
+        return ((quint32)width << 16) | ((quint32)height << 8) | ((quint32)levelOfDetail << 4) | (quint32)stitching;
+    }
+
+    void TerrainChunk::appendPattern(QVector<GLushort>& indices,
+                                     int width,
+                                     int height,
+                                     int levelOfDetail,
+                                     int stitching) {
+        int step = 1 << levelOfDetail;
+        for(int y = 0; y < height; y += step) {
+            for(int x = 0; x < width; x += step) {
+                // Same winding as the quads of the full terrain.
+                GLushort p1 = patternIndex(x, y, width, height, step, stitching);
+                GLushort p2 = patternIndex(x, y + step, width, height, step, stitching);
+                GLushort p3 = patternIndex(x + step, y + step, width, height, step, stitching);
+                GLushort p4 = patternIndex(x + step, y, width, height, step, stitching);
+                appendTriangle(indices, p1, p2, p3);
+                appendTriangle(indices, p1, p3, p4);
+            }
+        }
+    }
+} // namespace Glee3D
@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_TERRAINCHUNK_H
+#define G3D_TERRAINCHUNK_H
+
+// Own includes
+#include "g3d_vertex.h"
+#include "math/g3d_axisalignedbox.h"
+
+// Qt includes
+#include <QGLWidget>
+#include <QVector>
+
+namespace Glee3D {
+    /**
+      * @class TerrainChunk
+      * A rectangular part of a Terrain, at most Size quads wide and high.
+      * Each chunk has a vertex buffer of its own, while the triangles are
+      * taken from index patterns shared by all chunks of the same size.
+      *
+      * At level of detail l, only every 2^l-th vertex is used. If a
+      * neighbouring chunk is one level coarser, the vertices on the shared
+      * edge that the neighbour skips are collapsed into their predecessor,
+      * so that no cracks open between the chunks.
+      */
+    class TerrainChunk {
+    public:
+        enum {
+            /** Maximum number of quads along each side of a chunk. */
+            Size = 64,
+            /** Number of levels of detail, the coarsest has 2x2 quads. */
+            LevelOfDetailCount = 6
+        };
+
+        /**
+          * @enum Stitching
+          * Edges that have to be stitched to a coarser neighbour.
+          */
+        enum Stitching {
+            StitchMinimumX = 1,
+            StitchMaximumX = 2,
+            StitchMinimumY = 4,
+            StitchMaximumY = 8,
+            StitchingCount = 16
+        };
+
+        /**
+          * @struct Heights
+          * Row-major heights of a rectangular region of the heightfield.
+          * The region has to cover a chunk and, where the heightfield has
+          * them, the vertices next to it.
+          */
+        struct Heights {
+            const float *_data;
+            /** Column of the first height in the region. */
+            int _x;
+            /** Row of the first height in the region. */
+            int _y;
+            /** Number of heights per row of the region. */
+            int _width;
+            /** Number of vertices per row of the whole heightfield. */
+            int _heightfieldWidth;
+            /** Number of rows of the whole heightfield. */
+            int _heightfieldHeight;
+        };
+
+        /**
+         * Creates a chunk of the heightfield.
+         * @param x Column of the first vertex.
+         * @param y Row of the first vertex.
+         * @param width Number of quads along x.
+         * @param height Number of quads along y.
+         */
+        TerrainChunk(int x, int y, int width, int height);
+
+        /** Destructor. Graphics card buffers have to be released before. */
+        ~TerrainChunk();
+
+        /** @returns the column of the first vertex. */
+        int x();
+
+        /** @returns the row of the first vertex. */
+        int y();
+
+        /** @returns the number of quads along x. */
+        int width();
+
+        /** @returns the number of quads along y. */
+        int height();
+
+        /** @returns the coarsest level of detail the size of this chunk allows. */
+        int maximumLevelOfDetail();
+
+        /** @returns the bounding box in terrain space, once analyzed. */
+        AxisAlignedBox boundingBox();
+
+        /** @returns the largest height error of the given level of detail
+          * in terrain space, once analyzed. */
+        double error(int levelOfDetail);
+
+        /**
+         * Determines the bounding box and the error of each level of detail.
+         * This may be called from any thread.
+         * @param heights Heights covering this chunk.
+         * @param scale Horizontal distance of neighbouring vertices.
+         * @param heightScale Factor heights are scaled with.
+         */
+        void analyze(const Heights& heights, double scale, double heightScale);
+
+        /**
+         * Builds the vertices of this chunk. Normals take the vertices next
+         * to the chunk into account, so they match across chunk borders.
+         * This may be called from any thread.
+         */
+        void buildVertices(const Heights& heights,
+                           double scale,
+                           double heightScale,
+                           double tilingOffset);
+
+        /** @returns true, if vertices have been built but not uploaded. */
+        bool hasVertices();
+
+        /** @returns the built vertices row by row, until they are uploaded. */
+        QVector<Vertex> vertices();
+
+        /** @returns true, if the vertices are on the graphics card. */
+        bool isUploaded();
+
+        /**
+         * Uploads the built vertices and frees them.
+         * @param indexBufferHandle Buffer holding the index patterns.
+         */
+        void upload(GLuint indexBufferHandle);
+
+        /** Frees the built vertices without uploading them. */
+        void freeVertices();
+
+        /** @returns the size of the vertices in bytes. */
+        qint64 vertexSize();
+
+        /** @returns the size of the vertices on the graphics card in bytes. */
+        qint64 uploadedSize();
+
+        /** Frees the buffers on the graphics card. */
+        void release();
+
+        /**
+         * Draws a range of the index buffer.
+         * @param offset First index of the pattern.
+         * @param count Number of indices in the pattern.
+         */
+        void render(int offset, int count);
+
+        /** @returns the key of the index pattern for the given chunk size,
+          * level of detail and stitching. */
+        static quint32 patternKey(int width, int height, int levelOfDetail, int stitching);
+
+        /** Appends the triangles of an index pattern to the given indices. */
+        static void appendPattern(QVector<GLushort>& indices,
+                                  int width,
+                                  int height,
+                                  int levelOfDetail,
+                                  int stitching);
+
+    private:
+        int _x;
+        int _y;
+        int _width;
+        int _height;
+        int _maximumLevelOfDetail;
+
+        AxisAlignedBox _boundingBox;
+        double _errors[LevelOfDetailCount];
+
+        QVector<Vertex> _vertices;
+        GLuint _vertexArrayHandle;
+        GLuint _vertexBufferHandle;
+    };
+} // namespace Glee3D
+
+#endif // G3D_TERRAINCHUNK_H
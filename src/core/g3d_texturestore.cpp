@@ -20,6 +20,7 @@
 
 // Own includes
 #include "g3d_texturestore.h"
+#include "g3d_rendercounters.h"
 
 // Standard includes
 #include <iostream>
@@ -44,6 +45,32 @@ namespace Glee3D {
         }
     }
 
+    bool TextureStore::loadTexture(QString fileName, QString textureId) {
+        LoadedTexture loadedTexture;
+        if(!loadedTexture._image.load(fileName)) {
+            error(QString("Failed loading texture: %1").arg(fileName));
+            return false;
+        }
+
+        information(QString("Loaded texture: %1").arg(fileName));
+        QImage glImage = QGLWidget::convertToGLFormat(loadedTexture._image);
+        GLuint handle = 0;
+        glGenTextures(1, &handle);
+        glBindTexture(GL_TEXTURE_2D, handle);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                     glImage.width(), glImage.height(),
+                     0, GL_RGBA, GL_UNSIGNED_BYTE, glImage.bits());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        loadedTexture._glHandle = handle;
+        _loadedTextures[textureId] = loadedTexture;
+        return true;
+    }
+
+    QImage TextureStore::image(QString textureId) {
+        return _loadedTextures.value(textureId)._image;
+    }
+
     void TextureStore::activateTexture(QString textureId) {
         if(!textureId.isEmpty()
         && _loadedTextures.contains(textureId)) {
@@ -53,6 +80,7 @@ namespace Glee3D {
             glBindTexture(GL_TEXTURE_2D, GL_NONE);
             glDisable(GL_TEXTURE_2D);
         }
+        G3D_COUNT_TEXTURE_BINDS(1);
 
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -51,6 +51,14 @@ public:
       */
     bool loadTexture(Display& display, QString fileName, QString textureId);
 
+    /**
+      * Loads a texture into the OpenGL context that is current, for example
+      * the one of an OffscreenRenderer.
+      * @param fileName File name of the texture.
+      * @param textureId Id the texture is activated with.
+      */
+    bool loadTexture(QString fileName, QString textureId);
+
     /**
      * Activates the specified texture for rendering. If the texture id is
      * empty, this will clear the current texture.
@@ -59,6 +67,13 @@ public:
      */
     void activateTexture(QString textureId);
 
+    /**
+      * @returns the image of the specified texture, or a null image if no
+      * such texture has been loaded.
+      * @param textureId Id of the texture.
+      */
+    QImage image(QString textureId);
+
 private:
     TextureStore();
 
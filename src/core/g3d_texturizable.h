@@ -27,7 +27,9 @@
 namespace Glee3D {
     class Texturizable {
     public:
-        Texturizable() { }
+        Texturizable() {
+            _material = 0;
+        }
         virtual ~Texturizable() { }
 
         /** Sets the material.
@@ -0,0 +1,230 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_VERTEX_H
+#define G3D_VERTEX_H
+
+// Own includes
+#include "math/g3d_vector2d.h"
+#include "math/g3d_vector3d.h"
+
+// Qt includes
+#include <QGLWidget>
+
+// Standard includes
+#include <cstddef>
+#include <cmath>
+
+namespace Glee3D {
+    /**
+      * @struct Vertex
+      * Interleaved single precision vertex as it is stored in vertex buffer
+      * objects. Position, normal and texture coordinates are packed into
+      * 32 bytes.
+      */
+    struct Vertex {
+        GLfloat _position[3];
+        GLfloat _normal[3];
+        GLfloat _texCoord[2];
+
+        /**
+         * Describes the vertex layout for the currently bound array buffer.
+         * Call this once while the vertex array object is bound, it will
+         * then record the layout.
+         */
+        static void describeLayout() {
+            glVertexPointer(3, GL_FLOAT, sizeof(Vertex),
+                            (const GLvoid*)offsetof(Vertex, _position));
+            glNormalPointer(GL_FLOAT, sizeof(Vertex),
+                            (const GLvoid*)offsetof(Vertex, _normal));
+            glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex),
+                              (const GLvoid*)offsetof(Vertex, _texCoord));
+
+            glEnableClientState(GL_VERTEX_ARRAY);
+            glEnableClientState(GL_NORMAL_ARRAY);
+            glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+        }
+    };
+
+    /**
+      * @struct CompressedVertex
+      * Quantized vertex of 16 bytes. Positions are stored as 16 bit
+      * fractions of the mesh bounding box, normals are octahedral encoded
+      * into two signed 16 bit values and texture coordinates are stored
+      * as 16 bit fractions of the mesh texture coordinate bounds. The
+      * fourth position component only pads the vertex to four byte
+      * alignment.
+      *
+      * Compressed vertices are decoded in the vertex shader, which reads
+      * them from the generic attributes at the locations given below.
+      */
+    struct CompressedVertex {
+        GLushort _position[4];
+        GLshort  _normal[2];
+        GLushort _texCoord[2];
+
+        /** @enum AttributeLocation */
+        enum AttributeLocation {
+            PositionAttribute   = 5,
+            NormalAttribute     = 6,
+            TexCoordAttribute   = 7
+        };
+
+        /**
+         * Describes the vertex layout for the currently bound array buffer.
+         * Call this once while the vertex array object is bound, it will
+         * then record the layout.
+         */
+        static void describeLayout() {
+            glVertexAttribPointer(PositionAttribute, 4, GL_UNSIGNED_SHORT, GL_TRUE,
+                                  sizeof(CompressedVertex),
+                                  (const GLvoid*)offsetof(CompressedVertex, _position));
+            glVertexAttribPointer(NormalAttribute, 2, GL_SHORT, GL_FALSE,
+                                  sizeof(CompressedVertex),
+                                  (const GLvoid*)offsetof(CompressedVertex, _normal));
+            glVertexAttribPointer(TexCoordAttribute, 2, GL_UNSIGNED_SHORT, GL_TRUE,
+                                  sizeof(CompressedVertex),
+                                  (const GLvoid*)offsetof(CompressedVertex, _texCoord));
+
+            glEnableVertexAttribArray(PositionAttribute);
+            glEnableVertexAttribArray(NormalAttribute);
+            glEnableVertexAttribArray(TexCoordAttribute);
+
+            // Compatibility contexts only emit vertices while the
+            // conventional vertex array is enabled. The shader never reads
+            // it for compressed vertices.
+            glVertexPointer(4, GL_SHORT, sizeof(CompressedVertex),
+                            (const GLvoid*)offsetof(CompressedVertex, _position));
+            glEnableClientState(GL_VERTEX_ARRAY);
+        }
+
+        /**
+         * Quantizes value in the range [offset, offset + scale] to an
+         * unsigned 16 bit fraction.
+         */
+        static GLushort quantize(double value, double offset, double scale) {
+            if(scale <= 0.0) {
+                return 0;
+            }
+            double fraction = (value - offset) / scale;
+            fraction = fraction < 0.0 ? 0.0 : (fraction > 1.0 ? 1.0 : fraction);
+            return (GLushort)floor(fraction * 65535.0 + 0.5);
+        }
+
+        /** Inverse of quantize(). */
+        static double dequantize(GLushort value, double offset, double scale) {
+            return offset + scale * ((double)value / 65535.0);
+        }
+
+        /**
+         * Encodes a unit normal by projecting it onto an octahedron and
+         * unfolding the lower half onto the upper half.
+         */
+        static void encodeNormal(Vector3D normal, GLshort encoded[2]) {
+            double x = normal.x(), y = normal.y(), z = normal.z();
+            double l1Norm = fabs(x) + fabs(y) + fabs(z);
+            if(l1Norm <= 0.0) {
+                encoded[0] = encoded[1] = 0;
+                return;
+            }
+
+            x /= l1Norm;
+            y /= l1Norm;
+            if(z < 0.0) {
+                double foldedX = (1.0 - fabs(y)) * (x >= 0.0 ? 1.0 : -1.0);
+                double foldedY = (1.0 - fabs(x)) * (y >= 0.0 ? 1.0 : -1.0);
+                x = foldedX;
+                y = foldedY;
+            }
+
+            encoded[0] = (GLshort)floor(x * 32767.0 + 0.5);
+            encoded[1] = (GLshort)floor(y * 32767.0 + 0.5);
+        }
+
+        /** Inverse of encodeNormal(), matches the decoding in the shader. */
+        static Vector3D decodeNormal(const GLshort encoded[2]) {
+            double x = (double)encoded[0] / 32767.0;
+            double y = (double)encoded[1] / 32767.0;
+            double z = 1.0 - fabs(x) - fabs(y);
+            if(z < 0.0) {
+                double unfoldedX = (1.0 - fabs(y)) * (x >= 0.0 ? 1.0 : -1.0);
+                double unfoldedY = (1.0 - fabs(x)) * (y >= 0.0 ? 1.0 : -1.0);
+                x = unfoldedX;
+                y = unfoldedY;
+            }
+            return Vector3D(x, y, z).normalize();
+        }
+    };
+
+    /**
+      * @struct InstanceAttributes
+      * Per-instance data for instanced drawing. The vertex shader reads the
+      * model view matrix and the emission color of each instance from the
+      * generic attributes given below, the matrix occupying four locations.
+      */
+    struct InstanceAttributes {
+        GLfloat _modelViewMatrix[16];
+        GLfloat _emission[4];
+
+        /** @enum AttributeLocation */
+        enum AttributeLocation {
+            ModelViewMatrixAttribute    = 9,
+            EmissionAttribute           = 13
+        };
+
+        /**
+         * Describes the instance layout for the currently bound array
+         * buffer, starting at the given byte offset. The attributes advance
+         * once per instance.
+         */
+        static void describeLayout(size_t offset) {
+            for(int column = 0; column < 4; column++) {
+                glVertexAttribPointer(ModelViewMatrixAttribute + column, 4, GL_FLOAT, GL_FALSE,
+                                      sizeof(InstanceAttributes),
+                                      (const GLvoid*)(offset + offsetof(InstanceAttributes, _modelViewMatrix)
+                                                      + column * 4 * sizeof(GLfloat)));
+                glVertexAttribDivisor(ModelViewMatrixAttribute + column, 1);
+                glEnableVertexAttribArray(ModelViewMatrixAttribute + column);
+            }
+
+            glVertexAttribPointer(EmissionAttribute, 4, GL_FLOAT, GL_FALSE,
+                                  sizeof(InstanceAttributes),
+                                  (const GLvoid*)(offset + offsetof(InstanceAttributes, _emission)));
+            glVertexAttribDivisor(EmissionAttribute, 1);
+            glEnableVertexAttribArray(EmissionAttribute);
+        }
+
+        /**
+         * Disables the instance attributes again, so that the bound vertex
+         * array object can be used for regular drawing.
+         */
+        static void disableLayout() {
+            for(int column = 0; column < 4; column++) {
+                glVertexAttribDivisor(ModelViewMatrixAttribute + column, 0);
+                glDisableVertexAttribArray(ModelViewMatrixAttribute + column);
+            }
+            glVertexAttribDivisor(EmissionAttribute, 0);
+            glDisableVertexAttribArray(EmissionAttribute);
+        }
+    };
+
+} // namespace Glee3D
+
+#endif // G3D_VERTEX_H
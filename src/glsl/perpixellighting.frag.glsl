@@ -22,6 +22,7 @@ varying vec3 v;
 varying vec3 lightvec;
 varying vec3 normal;
 varying vec4 FrontColor;
+varying vec4 Emission;
 
 uniform sampler2D Texture0;
 
@@ -33,5 +34,9 @@ void main(void) {
   vec4 IDiffuse  = gl_LightSource[0].diffuse * max(dot(normal, lightvec), 0.0) * gl_FrontMaterial.diffuse;
   vec4 ISpecular = gl_LightSource[0].specular * pow(max(dot(Reflected, Eye), 0.0), gl_FrontMaterial.shininess) * gl_FrontMaterial.specular;
 
-  gl_FragColor   = vec4((gl_FrontLightModelProduct.sceneColor + IAmbient + IDiffuse) * texture2D(Texture0, vec2(gl_TexCoord[0])) + ISpecular);
+  // Same as gl_FrontLightModelProduct.sceneColor, but with the emission
+  // passed by the vertex shader, which may differ per instance.
+  vec4 SceneColor = Emission + gl_LightModel.ambient * gl_FrontMaterial.ambient;
+
+  gl_FragColor   = vec4((SceneColor + IAmbient + IDiffuse) * texture2D(Texture0, vec2(gl_TexCoord[0])) + ISpecular);
 }
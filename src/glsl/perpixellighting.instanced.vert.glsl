@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+varying vec3 v;
+varying vec3 lightvec;
+varying vec3 normal;
+varying vec4 FrontColor;
+varying vec4 Emission;
+
+uniform mat4 g3d_ProjectionMatrix;
+
+// Per instance attributes, see InstanceAttributes
+attribute mat4 g3d_InstanceModelViewMatrix;
+attribute vec4 g3d_InstanceEmission;
+
+// Compressed vertices, see CompressedVertex
+uniform bool g3d_CompressedVertices;
+uniform vec3 g3d_PositionOffset;
+uniform vec3 g3d_PositionScale;
+uniform vec2 g3d_TexCoordOffset;
+uniform vec2 g3d_TexCoordScale;
+
+attribute vec4 g3d_CompressedPosition;
+attribute vec2 g3d_CompressedNormal;
+attribute vec2 g3d_CompressedTexCoord;
+
+vec3 decodeOctahedral(vec2 encoded) {
+    vec2 e = encoded / 32767.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if(n.z < 0.0) {
+        vec2 signs = vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(e.yx)) * signs;
+    }
+    return normalize(n);
+}
+
+// The same normal matrix Program passes to the regular shader as
+// g3d_NormalMatrix: the inverse transpose of the upper 3x3 part, up to scale.
+mat3 normalMatrix(mat4 m) {
+    mat3 n = mat3(cross(m[1].xyz, m[2].xyz),
+                  cross(m[2].xyz, m[0].xyz),
+                  cross(m[0].xyz, m[1].xyz));
+    if(dot(m[0].xyz, n[0]) < 0.0) {
+        n = -n;
+    }
+    return n;
+}
+
+void main(void) {
+    vec4 vertex;
+    vec3 vertexNormal;
+    vec4 texCoord;
+    if(g3d_CompressedVertices) {
+        vertex       = vec4(g3d_PositionOffset + g3d_PositionScale * g3d_CompressedPosition.xyz, 1.0);
+        vertexNormal = decodeOctahedral(g3d_CompressedNormal);
+        texCoord     = vec4(g3d_TexCoordOffset + g3d_TexCoordScale * g3d_CompressedTexCoord, 0.0, 1.0);
+    } else {
+        vertex       = gl_Vertex;
+        vertexNormal = gl_Normal;
+        texCoord     = gl_MultiTexCoord0;
+    }
+
+    normal         = normalize(normalMatrix(g3d_InstanceModelViewMatrix) * vertexNormal);
+    v              = vec3(g3d_InstanceModelViewMatrix * vertex);
+    lightvec       = normalize(gl_LightSource[0].position.xyz - v);
+
+    gl_TexCoord[0] = texCoord;
+    FrontColor     = gl_Color;
+    Emission       = g3d_InstanceEmission;
+
+    gl_Position    = g3d_ProjectionMatrix * g3d_InstanceModelViewMatrix * vertex;
+}
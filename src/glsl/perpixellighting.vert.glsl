@@ -22,17 +22,54 @@ varying vec3 v;
 varying vec3 lightvec;
 varying vec3 normal;
 varying vec4 FrontColor;
+varying vec4 Emission;
 
 uniform mat4 g3d_ProjectionMatrix;
 uniform mat4 g3d_ModelViewMatrix;
+uniform mat3 g3d_NormalMatrix;
+
+// Compressed vertices, see CompressedVertex
+uniform bool g3d_CompressedVertices;
+uniform vec3 g3d_PositionOffset;
+uniform vec3 g3d_PositionScale;
+uniform vec2 g3d_TexCoordOffset;
+uniform vec2 g3d_TexCoordScale;
+
+attribute vec4 g3d_CompressedPosition;
+attribute vec2 g3d_CompressedNormal;
+attribute vec2 g3d_CompressedTexCoord;
+
+vec3 decodeOctahedral(vec2 encoded) {
+    vec2 e = encoded / 32767.0;
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if(n.z < 0.0) {
+        vec2 signs = vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(e.yx)) * signs;
+    }
+    return normalize(n);
+}
 
 void main(void) {
-    normal         = normalize(gl_NormalMatrix * gl_Normal);
-    v              = vec3(g3d_ModelViewMatrix * gl_Vertex);
+    vec4 vertex;
+    vec3 vertexNormal;
+    vec4 texCoord;
+    if(g3d_CompressedVertices) {
+        vertex       = vec4(g3d_PositionOffset + g3d_PositionScale * g3d_CompressedPosition.xyz, 1.0);
+        vertexNormal = decodeOctahedral(g3d_CompressedNormal);
+        texCoord     = vec4(g3d_TexCoordOffset + g3d_TexCoordScale * g3d_CompressedTexCoord, 0.0, 1.0);
+    } else {
+        vertex       = gl_Vertex;
+        vertexNormal = gl_Normal;
+        texCoord     = gl_MultiTexCoord0;
+    }
+
+    normal         = normalize(g3d_NormalMatrix * vertexNormal);
+    v              = vec3(g3d_ModelViewMatrix * vertex);
     lightvec       = normalize(gl_LightSource[0].position.xyz - v);
 
-    gl_TexCoord[0] = gl_MultiTexCoord0;
+    gl_TexCoord[0] = texCoord;
     FrontColor     = gl_Color;
+    Emission       = gl_FrontMaterial.emission;
 
-    gl_Position    = g3d_ProjectionMatrix * g3d_ModelViewMatrix * gl_Vertex;
+    gl_Position    = g3d_ProjectionMatrix * g3d_ModelViewMatrix * vertex;
 }
@@ -0,0 +1,35 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+
+varying vec3 direction;
+
+uniform mat4 g3d_ProjectionMatrix;
+uniform mat4 g3d_ModelViewMatrix;
+
+void main(void) {
+    // The model view matrix only rotates, so the cube stays centered around
+    // the camera and each corner is the direction to look up.
+    direction = gl_Vertex.xyz;
+
+    // Setting z to w puts every vertex exactly on the far plane.
+    vec4 position = g3d_ProjectionMatrix * g3d_ModelViewMatrix * vec4(gl_Vertex.xyz, 1.0);
+    gl_Position = position.xyww;
+}
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_axisalignedbox.h"
+
+// Standard includes
+#include <math.h>
+
+namespace Glee3D {
+
+AxisAlignedBox::AxisAlignedBox() {
+    _empty = true;
+}
+
+AxisAlignedBox::AxisAlignedBox(Vector3D minimum, Vector3D maximum) {
+    _minimum = minimum;
+    _maximum = maximum;
+    _empty = false;
+}
+
+AxisAlignedBox AxisAlignedBox::fromPoints(const Vector3D *points, int count) {
+    AxisAlignedBox box;
+    for(int i = 0; i < count; i++) {
+        box.extend(points[i]);
+    }
+    return box;
+}
+
+bool AxisAlignedBox::isEmpty() const {
+    return _empty;
+}
+
+void AxisAlignedBox::extend(Vector3D point) {
+    if(_empty) {
+        _minimum = point;
+        _maximum = point;
+        _empty = false;
+        return;
+    }
+
+    Vector3D minimum = _minimum;
+    Vector3D maximum = _maximum;
+    _minimum = Vector3D(qMin(minimum.x(), point.x()), qMin(minimum.y(), point.y()), qMin(minimum.z(), point.z()));
+    _maximum = Vector3D(qMax(maximum.x(), point.x()), qMax(maximum.y(), point.y()), qMax(maximum.z(), point.z()));
+}
+
+Vector3D AxisAlignedBox::center() const {
+    return (_minimum + _maximum) * 0.5;
+}
+
+Vector3D AxisAlignedBox::halfExtents() const {
+    return (_maximum - _minimum) * 0.5;
+}
+
+bool AxisAlignedBox::contains(Vector3D point) const {
+    if(_empty) {
+        return false;
+    }
+
+    Vector3D minimum = _minimum;
+    Vector3D maximum = _maximum;
+    return point.x() >= minimum.x() && point.x() <= maximum.x()
+        && point.y() >= minimum.y() && point.y() <= maximum.y()
+        && point.z() >= minimum.z() && point.z() <= maximum.z();
+}
+
+bool AxisAlignedBox::intersects(const AxisAlignedBox& other) const {
+    if(_empty || other._empty) {
+        return false;
+    }
+
+    Vector3D minimum = _minimum, maximum = _maximum;
+    Vector3D otherMinimum = other._minimum, otherMaximum = other._maximum;
+    return minimum.x() <= otherMaximum.x() && maximum.x() >= otherMinimum.x()
+        && minimum.y() <= otherMaximum.y() && maximum.y() >= otherMinimum.y()
+        && minimum.z() <= otherMaximum.z() && maximum.z() >= otherMinimum.z();
+}
+
+AxisAlignedBox AxisAlignedBox::transformed(Matrix4x4 matrix) const {
+    if(_empty) {
+        return AxisAlignedBox();
+    }
+
+    // Transform the center and project the half extents onto each world
+    // axis using the absolute values of the matrix (Arvo 1990).
+    Vector3D center = matrix.multiplicate(Vector4D(this->center(), 1.0)).toVector3D();
+    Vector3D extents = halfExtents();
+    double *m = matrix.glDataPointer();
+    double e[3] = { extents.x(), extents.y(), extents.z() };
+    double worldExtents[3];
+    for(int row = 0; row < 3; row++) {
+        worldExtents[row] = fabs(m[0 * 4 + row]) * e[0]
+                          + fabs(m[1 * 4 + row]) * e[1]
+                          + fabs(m[2 * 4 + row]) * e[2];
+    }
+
+    Vector3D half(worldExtents[0], worldExtents[1], worldExtents[2]);
+    return AxisAlignedBox(center - half, center + half);
+}
+
+} // namespace Glee3D
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_AXISALIGNEDBOX_H
+#define G3D_AXISALIGNEDBOX_H
+
+// Own includes
+#include "math/g3d_vector3d.h"
+#include "math/g3d_matrix4x4.h"
+
+namespace Glee3D {
+    /**
+      * @class AxisAlignedBox
+      * Box whose faces are parallel to the coordinate planes. A box without
+      * any points is empty.
+      */
+    class AxisAlignedBox {
+    public:
+        /** Creates an empty box. */
+        AxisAlignedBox();
+
+        /** Creates a box spanning the given corners. */
+        AxisAlignedBox(Vector3D minimum, Vector3D maximum);
+
+        /** @returns the smallest box containing the given points. */
+        static AxisAlignedBox fromPoints(const Vector3D *points, int count);
+
+        /** @returns true, if this box does not contain any point. */
+        bool isEmpty() const;
+
+        /** Grows this box so that it contains the given point. */
+        void extend(Vector3D point);
+
+        /** @returns the center of the box. */
+        Vector3D center() const;
+
+        /** @returns half the size of the box along each axis. */
+        Vector3D halfExtents() const;
+
+        /** @returns true, if the given point is inside this box. */
+        bool contains(Vector3D point) const;
+
+        /** @returns true, if both boxes overlap. */
+        bool intersects(const AxisAlignedBox& other) const;
+
+        /**
+         * @returns the smallest axis aligned box containing this box after
+         * transforming it with the given matrix.
+         */
+        AxisAlignedBox transformed(Matrix4x4 matrix) const;
+
+        Vector3D _minimum;
+        Vector3D _maximum;
+        bool _empty;
+    };
+} // namespace Glee3D
+
+#endif // G3D_AXISALIGNEDBOX_H
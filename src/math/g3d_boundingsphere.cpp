@@ -0,0 +1,152 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_boundingsphere.h"
+
+// Standard includes
+#include <math.h>
+
+namespace Glee3D {
+
+BoundingSphere::BoundingSphere() {
+    _radius = -1.0;
+}
+
+BoundingSphere::BoundingSphere(Vector3D center, double radius) {
+    _center = center;
+    _radius = radius;
+}
+
+BoundingSphere BoundingSphere::fromPoints(const Vector3D *points, int count) {
+    if(count <= 0) {
+        return BoundingSphere();
+    }
+
+    // Find two points that are far apart as the initial diameter.
+    int farthest = 0;
+    double farthestDistance = -1.0;
+    for(int i = 0; i < count; i++) {
+        double distance = (points[i] - points[0]).length();
+        if(distance > farthestDistance) {
+            farthestDistance = distance;
+            farthest = i;
+        }
+    }
+
+    int opposite = farthest;
+    farthestDistance = -1.0;
+    for(int i = 0; i < count; i++) {
+        double distance = (points[i] - points[farthest]).length();
+        if(distance > farthestDistance) {
+            farthestDistance = distance;
+            opposite = i;
+        }
+    }
+
+    Vector3D center = (points[farthest] + points[opposite]) * 0.5;
+    double radius = farthestDistance * 0.5;
+
+    // Grow the sphere to include every point outside of it.
+    for(int i = 0; i < count; i++) {
+        Vector3D offset = points[i] - center;
+        double distance = offset.length();
+        if(distance > radius) {
+            double newRadius = (radius + distance) * 0.5;
+            center += offset * ((newRadius - radius) / distance);
+            radius = newRadius;
+        }
+    }
+
+    return BoundingSphere(center, radius);
+}
+
+void BoundingSphere::extend(const BoundingSphere& other) {
+    if(other.isEmpty()) {
+        return;
+    }
+
+    if(isEmpty()) {
+        *this = other;
+        return;
+    }
+
+    Vector3D offset = other._center - _center;
+    double distance = offset.length();
+    if(distance + other._radius <= _radius) {
+        return;
+    }
+
+    if(distance + _radius <= other._radius) {
+        *this = other;
+        return;
+    }
+
+    double radius = (distance + _radius + other._radius) * 0.5;
+    _center += offset * ((radius - _radius) / distance);
+    _radius = radius;
+}
+
+bool BoundingSphere::isEmpty() const {
+    return _radius < 0.0;
+}
+
+bool BoundingSphere::contains(Vector3D point) const {
+    return !isEmpty() && (point - _center).length() <= _radius;
+}
+
+bool BoundingSphere::intersects(const Line3D& line) const {
+    if(isEmpty()) {
+        return false;
+    }
+
+    Vector3D direction = line._directionVector;
+    double length = direction.length();
+    if(length <= 0.0) {
+        return contains(line._positionVector);
+    }
+
+    double distance = (_center - line._positionVector).crossProduct(direction).length() / length;
+    return distance <= _radius;
+}
+
+bool BoundingSphere::intersects(const BoundingSphere& other) const {
+    if(isEmpty() || other.isEmpty()) {
+        return false;
+    }
+    return (_center - other._center).length() <= _radius + other._radius;
+}
+
+BoundingSphere BoundingSphere::transformed(Matrix4x4 matrix) const {
+    if(isEmpty()) {
+        return BoundingSphere();
+    }
+
+    Vector3D center = matrix.multiplicate(Vector4D(_center, 1.0)).toVector3D();
+    double *m = matrix.glDataPointer();
+    double scale = 0.0;
+    for(int column = 0; column < 3; column++) {
+        Vector3D axis(m[column * 4 + 0], m[column * 4 + 1], m[column * 4 + 2]);
+        scale = qMax(scale, axis.length());
+    }
+    return BoundingSphere(center, _radius * scale);
+}
+
+} // namespace Glee3D
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_BOUNDINGSPHERE_H
+#define G3D_BOUNDINGSPHERE_H
+
+// Own includes
+#include "math/g3d_vector3d.h"
+#include "math/g3d_matrix4x4.h"
+#include "math/g3d_line3d.h"
+
+namespace Glee3D {
+    /**
+      * @class BoundingSphere
+      * Sphere enclosing a set of points. A sphere with a negative radius is
+      * empty.
+      */
+    class BoundingSphere {
+    public:
+        /** Creates an empty sphere. */
+        BoundingSphere();
+
+        /** Creates a sphere with the given center and radius. */
+        BoundingSphere(Vector3D center, double radius);
+
+        /**
+         * @returns a sphere containing the given points, using Ritter's
+         * algorithm. The result is typically within a few percent of the
+         * minimal enclosing sphere.
+         */
+        static BoundingSphere fromPoints(const Vector3D *points, int count);
+
+        /** Grows this sphere so that it contains the given sphere. */
+        void extend(const BoundingSphere& other);
+
+        /** @returns true, if this sphere does not contain any point. */
+        bool isEmpty() const;
+
+        /** @returns true, if the given point is inside this sphere. */
+        bool contains(Vector3D point) const;
+
+        /** @returns true, if the given line passes through this sphere. */
+        bool intersects(const Line3D& line) const;
+
+        /** @returns true, if both spheres overlap. */
+        bool intersects(const BoundingSphere& other) const;
+
+        /**
+         * @returns a sphere containing this sphere after transforming it with
+         * the given matrix. Non-uniform scaling is accounted for by using the
+         * largest scale factor.
+         */
+        BoundingSphere transformed(Matrix4x4 matrix) const;
+
+        Vector3D _center;
+        double _radius;
+    };
+} // namespace Glee3D
+
+#endif // G3D_BOUNDINGSPHERE_H
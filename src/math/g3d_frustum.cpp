@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_frustum.h"
+
+// Standard includes
+#include <math.h>
+
+namespace Glee3D {
+
+Frustum::Frustum() {
+    for(int side = 0; side < SideCount; side++) {
+        _offsets[side] = 0.0;
+        _enabled[side] = false;
+    }
+}
+
+Frustum::Frustum(Matrix4x4 modelviewMatrix, Matrix4x4 projectionMatrix) {
+    // Extract the planes from the rows of the combined matrix, see Gribb and
+    // Hartmann, "Fast Extraction of Viewing Frustum Planes".
+    Matrix4x4 clipMatrix = modelviewMatrix.multiplicate(projectionMatrix);
+    double row[4][4];
+    for(int r = 0; r < 4; r++) {
+        for(int c = 0; c < 4; c++) {
+            row[r][c] = clipMatrix.value(r, c);
+        }
+    }
+
+    for(int i = 0; i < 3; i++) {
+        setPlane((Side)(i * 2),
+                 row[3][0] + row[i][0], row[3][1] + row[i][1],
+                 row[3][2] + row[i][2], row[3][3] + row[i][3]);
+        setPlane((Side)(i * 2 + 1),
+                 row[3][0] - row[i][0], row[3][1] - row[i][1],
+                 row[3][2] - row[i][2], row[3][3] - row[i][3]);
+    }
+}
+
+void Frustum::setPlane(Side side, double a, double b, double c, double d) {
+    Vector3D normal(a, b, c);
+    double length = normal.length();
+    if(length <= 1e-12) {
+        _normals[side] = Vector3D();
+        _offsets[side] = 0.0;
+        _enabled[side] = false;
+        return;
+    }
+
+    _normals[side] = normal * (1.0 / length);
+    _offsets[side] = d / length;
+    _enabled[side] = true;
+}
+
+Plane3D Frustum::plane(Side side) const {
+    // Span the plane with two directions whose cross product is the normal.
+    Vector3D normal = _normals[side];
+    Vector3D helper = fabs(normal.x()) < 0.9 ? Vector3D(1.0, 0.0, 0.0) : Vector3D(0.0, 1.0, 0.0);
+    Vector3D direction1 = normal.crossProduct(helper).normalize();
+    Vector3D direction2 = normal.crossProduct(direction1);
+    return Plane3D(normal * -_offsets[side], direction1, direction2,
+                   Plane3D::PositionAndDirectionVectors);
+}
+
+bool Frustum::contains(Vector3D point) const {
+    for(int side = 0; side < SideCount; side++) {
+        if(_enabled[side] && _normals[side].scalarProduct(point) + _offsets[side] < 0.0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Frustum::Classification Frustum::classify(const BoundingSphere& sphere) const {
+    if(sphere.isEmpty()) {
+        return Intersecting;
+    }
+
+    Classification classification = Inside;
+    for(int side = 0; side < SideCount; side++) {
+        if(!_enabled[side]) {
+            continue;
+        }
+
+        double distance = _normals[side].scalarProduct(sphere._center) + _offsets[side];
+        if(distance < -sphere._radius) {
+            return Outside;
+        }
+        if(distance < sphere._radius) {
+            classification = Intersecting;
+        }
+    }
+    return classification;
+}
+
+Frustum::Classification Frustum::classify(const AxisAlignedBox& box) const {
+    if(box.isEmpty()) {
+        return Intersecting;
+    }
+
+    Vector3D center = box.center();
+    Vector3D halfExtents = box.halfExtents();
+    Classification classification = Inside;
+    for(int side = 0; side < SideCount; side++) {
+        if(!_enabled[side]) {
+            continue;
+        }
+
+        // Projected radius of the box onto the plane normal
+        Vector3D normal = _normals[side];
+        double radius = fabs(normal.x()) * halfExtents.x()
+                      + fabs(normal.y()) * halfExtents.y()
+                      + fabs(normal.z()) * halfExtents.z();
+        double distance = normal.scalarProduct(center) + _offsets[side];
+        if(distance < -radius) {
+            return Outside;
+        }
+        if(distance < radius) {
+            classification = Intersecting;
+        }
+    }
+    return classification;
+}
+
+} // namespace Glee3D
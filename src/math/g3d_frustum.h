@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_FRUSTUM_H
+#define G3D_FRUSTUM_H
+
+// Own includes
+#include "math/g3d_vector3d.h"
+#include "math/g3d_matrix4x4.h"
+#include "math/g3d_plane3d.h"
+#include "math/g3d_axisalignedbox.h"
+#include "math/g3d_boundingsphere.h"
+
+namespace Glee3D {
+    /**
+      * @class Frustum
+      * Viewing volume of a camera, bounded by six planes whose normals point
+      * inwards. Planes that degenerate, like the far plane of a camera with
+      * an extremely distant far clipping distance, are ignored.
+      */
+    class Frustum {
+    public:
+        /** @enum Side */
+        enum Side {
+            Left,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+            SideCount
+        };
+
+        /** @enum Classification */
+        enum Classification {
+            /** Completely outside of the frustum. */
+            Outside,
+            /** Partially inside of the frustum, or unknown. */
+            Intersecting,
+            /** Completely inside of the frustum. */
+            Inside
+        };
+
+        /** Creates a frustum that contains everything. */
+        Frustum();
+
+        /**
+         * Creates the frustum of the given camera matrices. When the
+         * modelview matrix is the camera matrix only, planes are in world
+         * space.
+         */
+        Frustum(Matrix4x4 modelviewMatrix, Matrix4x4 projectionMatrix);
+
+        /** @returns the plane on the given side, with its normal pointing inwards. */
+        Plane3D plane(Side side) const;
+
+        /** @returns true, if the given point is inside of the frustum. */
+        bool contains(Vector3D point) const;
+
+        /**
+         * Classifies the given sphere against the frustum. This test is
+         * conservative: it may report spheres near the corners as
+         * intersecting although they are outside. An empty sphere is always
+         * classified as intersecting.
+         */
+        Classification classify(const BoundingSphere& sphere) const;
+
+        /** @overload */
+        Classification classify(const AxisAlignedBox& box) const;
+
+    private:
+        void setPlane(Side side, double a, double b, double c, double d);
+
+        Vector3D _normals[SideCount];
+        double _offsets[SideCount];
+        bool _enabled[SideCount];
+    };
+} // namespace Glee3D
+
+#endif // G3D_FRUSTUM_H
@@ -174,6 +174,48 @@ bool Matrix4x4::invert(Matrix4x4 *result) {
     return true;
 }
 
+Matrix4x4 Matrix4x4::interpolate(Matrix4x4 to, double factor) {
+    Matrix4x4 result;
+    for(int i = 0; i < 16; i++) {
+        result._data[i] = _data[i] + (to._data[i] - _data[i]) * factor;
+    }
+
+    // Blending rotations element by element shrinks and shears the axes, so
+    // they are made orthogonal again and scaled to their blended lengths.
+    Vector3D axes[3];
+    double lengths[3];
+    for(int column = 0; column < 3; column++) {
+        Vector3D from(_data[column * 4], _data[column * 4 + 1], _data[column * 4 + 2]);
+        Vector3D target(to._data[column * 4], to._data[column * 4 + 1], to._data[column * 4 + 2]);
+        lengths[column] = from.length() + (target.length() - from.length()) * factor;
+        axes[column] = Vector3D(result._data[column * 4], result._data[column * 4 + 1], result._data[column * 4 + 2]);
+        if(axes[column].length() <= 1e-12) {
+            return result;
+        }
+    }
+
+    axes[0].normalize();
+    axes[1] -= axes[0] * axes[1].scalarProduct(axes[0]);
+    axes[2] -= axes[0] * axes[2].scalarProduct(axes[0]);
+    if(axes[1].length() <= 1e-12) {
+        return result;
+    }
+    axes[1].normalize();
+    axes[2] -= axes[1] * axes[2].scalarProduct(axes[1]);
+    if(axes[2].length() <= 1e-12) {
+        return result;
+    }
+    axes[2].normalize();
+
+    for(int column = 0; column < 3; column++) {
+        Vector3D axis = axes[column] * lengths[column];
+        result._data[column * 4]     = axis.x();
+        result._data[column * 4 + 1] = axis.y();
+        result._data[column * 4 + 2] = axis.z();
+    }
+    return result;
+}
+
 double Matrix4x4::value(int row, int column) {
     if(row < 0 || row > 3 || column < 0 || column > 3) {
         warning(QString("Accessing matrix outside of range: %1/%2").arg(row).arg(column));
@@ -65,6 +65,17 @@ public:
      */
     bool invert(Matrix4x4 *result = 0);
 
+    /**
+     * Blends this matrix towards another affine transformation. Translation
+     * and axis lengths are interpolated linearly, the axes are made
+     * orthogonal again afterwards. This is meant for small steps, such as
+     * between two consecutive logic steps, not for large rotations.
+     * @param to The matrix to blend towards.
+     * @param factor Blend factor, 0 returns this matrix and 1 returns to.
+     * @returns the blended matrix.
+     */
+    Matrix4x4 interpolate(Matrix4x4 to, double factor);
+
     /**
      * Retrieves a value from the matrix. This does bounds-checking, so it may be slow.
      * If you are sure you are not violating any bounds, you may want to look into
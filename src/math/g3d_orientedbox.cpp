@@ -0,0 +1,205 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "g3d_orientedbox.h"
+
+// Standard includes
+#include <math.h>
+
+namespace Glee3D {
+
+namespace {
+    /**
+     * Diagonalizes the symmetric 3x3 matrix a with cyclic Jacobi rotations.
+     * On return, the diagonal of a holds the eigenvalues and the columns of v
+     * the corresponding eigenvectors.
+     */
+    void jacobiEigenvectors(double a[3][3], double v[3][3]) {
+        for(int i = 0; i < 3; i++) {
+            for(int j = 0; j < 3; j++) {
+                v[i][j] = (i == j) ? 1.0 : 0.0;
+            }
+        }
+
+        for(int sweep = 0; sweep < 32; sweep++) {
+            double offDiagonal = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+            if(offDiagonal < 1e-12) {
+                return;
+            }
+
+            for(int p = 0; p < 2; p++) {
+                for(int q = p + 1; q < 3; q++) {
+                    if(fabs(a[p][q]) < 1e-15) {
+                        continue;
+                    }
+
+                    double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                    double t = (theta >= 0.0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                    double c = 1.0 / sqrt(t * t + 1.0);
+                    double s = t * c;
+
+                    for(int k = 0; k < 3; k++) {
+                        double akp = a[k][p];
+                        double akq = a[k][q];
+                        a[k][p] = c * akp - s * akq;
+                        a[k][q] = s * akp + c * akq;
+                    }
+                    for(int k = 0; k < 3; k++) {
+                        double apk = a[p][k];
+                        double aqk = a[q][k];
+                        a[p][k] = c * apk - s * aqk;
+                        a[q][k] = s * apk + c * aqk;
+                    }
+                    for(int k = 0; k < 3; k++) {
+                        double vkp = v[k][p];
+                        double vkq = v[k][q];
+                        v[k][p] = c * vkp - s * vkq;
+                        v[k][q] = s * vkp + c * vkq;
+                    }
+                }
+            }
+        }
+    }
+}
+
+OrientedBox::OrientedBox() {
+    _axes[0] = Vector3D(1.0, 0.0, 0.0);
+    _axes[1] = Vector3D(0.0, 1.0, 0.0);
+    _axes[2] = Vector3D(0.0, 0.0, 1.0);
+    _halfExtents = Vector3D(-1.0, -1.0, -1.0);
+}
+
+OrientedBox OrientedBox::fromPoints(const Vector3D *points, int count) {
+    OrientedBox box;
+    if(count <= 0) {
+        return box;
+    }
+
+    // Covariance of the point cloud
+    Vector3D mean;
+    for(int i = 0; i < count; i++) {
+        mean += points[i];
+    }
+    mean = mean * (1.0 / count);
+
+    double covariance[3][3] = { { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 }, { 0.0, 0.0, 0.0 } };
+    for(int i = 0; i < count; i++) {
+        Vector3D d = points[i] - mean;
+        double p[3] = { d.x(), d.y(), d.z() };
+        for(int r = 0; r < 3; r++) {
+            for(int c = r; c < 3; c++) {
+                covariance[r][c] += p[r] * p[c];
+            }
+        }
+    }
+    for(int r = 0; r < 3; r++) {
+        for(int c = 0; c < r; c++) {
+            covariance[r][c] = covariance[c][r];
+        }
+    }
+
+    double eigenvectors[3][3];
+    jacobiEigenvectors(covariance, eigenvectors);
+    for(int axis = 0; axis < 3; axis++) {
+        box._axes[axis] = Vector3D(eigenvectors[0][axis], eigenvectors[1][axis], eigenvectors[2][axis]);
+        box._axes[axis].normalize();
+    }
+
+    // Keep the axes right-handed.
+    if(box._axes[0].crossProduct(box._axes[1]).scalarProduct(box._axes[2]) < 0.0) {
+        box._axes[2] = -box._axes[2];
+    }
+
+    // Project all points onto the axes to find the extents.
+    double lower[3], upper[3];
+    for(int i = 0; i < count; i++) {
+        for(int axis = 0; axis < 3; axis++) {
+            double projection = points[i].scalarProduct(box._axes[axis]);
+            if(i == 0 || projection < lower[axis]) {
+                lower[axis] = projection;
+            }
+            if(i == 0 || projection > upper[axis]) {
+                upper[axis] = projection;
+            }
+        }
+    }
+
+    box._center = box._axes[0] * ((lower[0] + upper[0]) * 0.5)
+                + box._axes[1] * ((lower[1] + upper[1]) * 0.5)
+                + box._axes[2] * ((lower[2] + upper[2]) * 0.5);
+    box._halfExtents = Vector3D((upper[0] - lower[0]) * 0.5,
+                                (upper[1] - lower[1]) * 0.5,
+                                (upper[2] - lower[2]) * 0.5);
+    return box;
+}
+
+bool OrientedBox::isEmpty() const {
+    Vector3D halfExtents = _halfExtents;
+    return halfExtents.x() < 0.0;
+}
+
+bool OrientedBox::contains(Vector3D point) const {
+    if(isEmpty()) {
+        return false;
+    }
+
+    Vector3D offset = point - _center;
+    Vector3D halfExtents = _halfExtents;
+    double extents[3] = { halfExtents.x(), halfExtents.y(), halfExtents.z() };
+    for(int axis = 0; axis < 3; axis++) {
+        if(fabs(offset.scalarProduct(_axes[axis])) > extents[axis]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void OrientedBox::corners(Vector3D *corners) const {
+    Vector3D halfExtents = _halfExtents;
+    for(int i = 0; i < 8; i++) {
+        corners[i] = _center
+                   + _axes[0] * ((i & 1) ? halfExtents.x() : -halfExtents.x())
+                   + _axes[1] * ((i & 2) ? halfExtents.y() : -halfExtents.y())
+                   + _axes[2] * ((i & 4) ? halfExtents.z() : -halfExtents.z());
+    }
+}
+
+OrientedBox OrientedBox::transformed(Matrix4x4 matrix) const {
+    if(isEmpty()) {
+        return OrientedBox();
+    }
+
+    OrientedBox box;
+    box._center = matrix.multiplicate(Vector4D(_center, 1.0)).toVector3D();
+
+    Vector3D halfExtents = _halfExtents;
+    double extents[3] = { halfExtents.x(), halfExtents.y(), halfExtents.z() };
+    for(int axis = 0; axis < 3; axis++) {
+        Vector3D transformedAxis = matrix.multiplicate(Vector4D(_axes[axis], 0.0)).toVector3D(Vector4D::IgnoreW);
+        double scale = transformedAxis.length();
+        extents[axis] *= scale;
+        box._axes[axis] = scale > 0.0 ? transformedAxis * (1.0 / scale) : _axes[axis];
+    }
+    box._halfExtents = Vector3D(extents[0], extents[1], extents[2]);
+    return box;
+}
+
+} // namespace Glee3D
@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef G3D_ORIENTEDBOX_H
+#define G3D_ORIENTEDBOX_H
+
+// Own includes
+#include "math/g3d_vector3d.h"
+#include "math/g3d_matrix4x4.h"
+
+namespace Glee3D {
+    /**
+      * @class OrientedBox
+      * Box with arbitrarily oriented, orthonormal axes. A box with negative
+      * half extents is empty.
+      */
+    class OrientedBox {
+    public:
+        /** Creates an empty box. */
+        OrientedBox();
+
+        /**
+         * @returns a box containing the given points. The axes are the
+         * principal components of the point cloud, which gives a tight fit
+         * for elongated or rotated shapes without searching all orientations.
+         */
+        static OrientedBox fromPoints(const Vector3D *points, int count);
+
+        /** @returns true, if this box does not contain any point. */
+        bool isEmpty() const;
+
+        /** @returns true, if the given point is inside this box. */
+        bool contains(Vector3D point) const;
+
+        /** Writes the eight corners of this box into corners. */
+        void corners(Vector3D *corners) const;
+
+        /**
+         * @returns this box transformed with the given matrix. Scaling is
+         * moved from the axes into the half extents, so the axes stay
+         * orthonormal as long as the matrix does not shear.
+         */
+        OrientedBox transformed(Matrix4x4 matrix) const;
+
+        Vector3D _center;
+        Vector3D _axes[3];
+        Vector3D _halfExtents;
+    };
+} // namespace Glee3D
+
+#endif // G3D_ORIENTEDBOX_H
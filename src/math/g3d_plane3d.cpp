@@ -66,6 +66,10 @@ Vector3D Plane3D::normal() {
     return _directionVector1.crossProduct(_directionVector2).normalize();
 }
 
+double Plane3D::signedDistance(Vector3D point) {
+    return normal().scalarProduct(point - _positionVector);
+}
+
 QString Plane3D::className() {
     return "Plane3D";
 }
@@ -66,6 +66,12 @@ namespace Glee3D {
          */
         Vector3D normal();
 
+        /**
+         * @returns the distance of the given point to this plane. The
+         * distance is positive on the side the normal points to.
+         */
+        double signedDistance(Vector3D point);
+
         QString className();
         QJsonObject serialize();
         bool deserialize(QJsonObject jsonObject);
@@ -17,7 +17,7 @@ TEMPLATE = lib
 TARGET = glee3d
 CONFIG += debug_and_release staticlib
 
-QT += opengl
+QT += opengl concurrent
 
 DEFINES += GL_GLEXT_PROTOTYPES
 
@@ -45,6 +45,7 @@ HEADERS += \
     core/g3d_anchored.h \
     core/g3d_camera.h \
     core/g3d_framebuffer.h \
+    core/g3d_heightmap.h \
     core/g3d_lightsource.h \
     core/g3d_display.h \
     core/g3d_material.h \
@@ -56,6 +57,7 @@ HEADERS += \
     core/g3d_scene.h \
     core/g3d_skybox.h \
     core/g3d_terrain.h \
+    core/g3d_terrainchunk.h \
     core/g3d_texturestore.h \
     core/g3d_texturizable.h \
     objects/g3d_cube.h \
@@ -68,7 +70,24 @@ HEADERS += \
     math/g3d_vector4d.h \
     math/g3d_plane3d.h \
     math/g3d_line3d.h \
+    math/g3d_axisalignedbox.h \
+    math/g3d_boundingsphere.h \
+    math/g3d_orientedbox.h \
+    math/g3d_frustum.h \
     core/g3d_compiledmesh.h \
+    core/g3d_compiledmeshregistry.h \
+    core/g3d_meshcompiler.h \
+    core/g3d_renderqueue.h \
+    core/g3d_scenesnapshot.h \
+    core/g3d_logicthread.h \
+    core/g3d_frameprofiler.h \
+    core/g3d_rendercounters.h \
+    core/g3d_renderer.h \
+    core/g3d_offscreenrenderer.h \
+    core/g3d_normalbuilder.h \
+    core/g3d_meshoptimizer.h \
+    core/g3d_meshsimplifier.h \
+    core/g3d_vertex.h \
     core/g3d_log.h \
     core/g3d_logging.h \
     core/g3d_utilities.h \
@@ -79,6 +98,7 @@ SOURCES += \
     core/g3d_camera.cpp \
     core/g3d_display.cpp \
     core/g3d_framebuffer.cpp \
+    core/g3d_heightmap.cpp \
     core/g3d_lightsource.cpp \
     core/g3d_material.cpp \
     core/g3d_mesh.cpp \
@@ -87,16 +107,33 @@ SOURCES += \
     core/g3d_scene.cpp \
     core/g3d_skybox.cpp \
     core/g3d_terrain.cpp \
+    core/g3d_terrainchunk.cpp \
     core/g3d_texturestore.cpp \
     objects/g3d_cube.cpp \
     objects/g3d_cylinder.cpp \
     io/g3d_objloader.cpp \
     core/g3d_entity.cpp \
     core/g3d_compiledmesh.cpp \
+    core/g3d_compiledmeshregistry.cpp \
+    core/g3d_meshcompiler.cpp \
+    core/g3d_renderqueue.cpp \
+    core/g3d_scenesnapshot.cpp \
+    core/g3d_logicthread.cpp \
+    core/g3d_frameprofiler.cpp \
+    core/g3d_rendercounters.cpp \
+    core/g3d_renderer.cpp \
+    core/g3d_offscreenrenderer.cpp \
+    core/g3d_normalbuilder.cpp \
+    core/g3d_meshoptimizer.cpp \
+    core/g3d_meshsimplifier.cpp \
     core/g3d_log.cpp \
     core/g3d_utilities.cpp \
     math/g3d_matrix4x4.cpp \
     math/g3d_line3d.cpp \
+    math/g3d_axisalignedbox.cpp \
+    math/g3d_boundingsphere.cpp \
+    math/g3d_orientedbox.cpp \
+    math/g3d_frustum.cpp \
     math/g3d_plane3d.cpp \
     math/g3d_vector2d.cpp \
     math/g3d_vector3d.cpp \
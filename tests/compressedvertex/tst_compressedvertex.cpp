@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "core/g3d_vertex.h"
+
+// Qt includes
+#include <QtTest>
+
+// Standard includes
+#include <math.h>
+
+using namespace Glee3D;
+
+namespace {
+    /** Largest deviation of a decoded unit normal, in length of the
+      * difference vector. Two 16 bit octahedral components resolve
+      * directions to a few hundredths of a milliradian. */
+    const double normalTolerance = 1e-4;
+
+    /** @returns the normal after encoding and decoding. */
+    Vector3D roundTrip(Vector3D normal) {
+        GLshort encoded[2];
+        CompressedVertex::encodeNormal(normal, encoded);
+        return CompressedVertex::decodeNormal(encoded);
+    }
+
+    /** @returns the distance of the normal after a round trip. */
+    double normalError(Vector3D normal) {
+        normal.normalize();
+        return (roundTrip(normal) - normal).length();
+    }
+
+    /** @returns the largest error a quantized value may have, half a step
+      * plus some slack for rounding. */
+    double quantizationTolerance(double scale) {
+        return scale / 65535.0 * 0.5 * (1.0 + 1e-6);
+    }
+}
+
+class TestCompressedVertex : public QObject {
+    Q_OBJECT
+
+private slots:
+    void vertexSize() {
+        QCOMPARE((int)sizeof(CompressedVertex), 16);
+    }
+
+    void quantizeRoundTrip_data() {
+        QTest::addColumn<double>("offset");
+        QTest::addColumn<double>("scale");
+        QTest::newRow("unit range") << 0.0 << 1.0;
+        QTest::newRow("negative offset") << -250.0 << 500.0;
+        QTest::newRow("small range") << 3.0 << 1e-3;
+        QTest::newRow("large range") << -1e5 << 3e5;
+    }
+
+    void quantizeRoundTrip() {
+        QFETCH(double, offset);
+        QFETCH(double, scale);
+        double tolerance = quantizationTolerance(scale);
+        for(int i = 0; i <= 10000; i++) {
+            double value = offset + scale * (i / 10000.0);
+            GLushort quantized = CompressedVertex::quantize(value, offset, scale);
+            double decoded = CompressedVertex::dequantize(quantized, offset, scale);
+            QVERIFY(fabs(decoded - value) <= tolerance);
+        }
+    }
+
+    void quantizeBoundingBoxExtremes() {
+        double offset = -12.5;
+        double scale = 40.0;
+        double tolerance = quantizationTolerance(scale);
+
+        // The box corners map to the ends of the 16 bit range.
+        QCOMPARE((int)CompressedVertex::quantize(offset, offset, scale), 0);
+        QCOMPARE((int)CompressedVertex::quantize(offset + scale, offset, scale), 65535);
+        QVERIFY(fabs(CompressedVertex::dequantize(0, offset, scale) - offset) <= 1e-12);
+        QVERIFY(fabs(CompressedVertex::dequantize(65535, offset, scale) - (offset + scale)) <= 1e-12);
+
+        // Values just inside the box must not wrap around.
+        QVERIFY(fabs(CompressedVertex::dequantize(CompressedVertex::quantize(offset + scale - 1e-9, offset, scale), offset, scale)
+                     - (offset + scale)) <= tolerance);
+
+        // Values outside the box are clamped to it.
+        QCOMPARE((int)CompressedVertex::quantize(offset - 1.0, offset, scale), 0);
+        QCOMPARE((int)CompressedVertex::quantize(offset + scale + 1.0, offset, scale), 65535);
+    }
+
+    void quantizeFlatAxis() {
+        // Flat meshes have a bounding box without extent along one axis.
+        QCOMPARE((int)CompressedVertex::quantize(2.0, 2.0, 0.0), 0);
+        QCOMPARE(CompressedVertex::dequantize(0, 2.0, 0.0), 2.0);
+    }
+
+    void axisAlignedNormals_data() {
+        QTest::addColumn<double>("x");
+        QTest::addColumn<double>("y");
+        QTest::addColumn<double>("z");
+        QTest::newRow("+x") << 1.0 << 0.0 << 0.0;
+        QTest::newRow("-x") << -1.0 << 0.0 << 0.0;
+        QTest::newRow("+y") << 0.0 << 1.0 << 0.0;
+        QTest::newRow("-y") << 0.0 << -1.0 << 0.0;
+        QTest::newRow("+z") << 0.0 << 0.0 << 1.0;
+        QTest::newRow("-z") << 0.0 << 0.0 << -1.0;
+    }
+
+    void axisAlignedNormals() {
+        QFETCH(double, x);
+        QFETCH(double, y);
+        QFETCH(double, z);
+
+        // Axis directions lie on octahedron corners and decode exactly.
+        QVERIFY(normalError(Vector3D(x, y, z)) <= 1e-12);
+    }
+
+    void lowerHemisphereWrap_data() {
+        QTest::addColumn<double>("x");
+        QTest::addColumn<double>("y");
+        QTest::addColumn<double>("z");
+
+        // Close to -z, the folded coordinates approach the square corners.
+        QTest::newRow("near -z, +x +y") << 1e-4 << 1e-4 << -1.0;
+        QTest::newRow("near -z, -x +y") << -1e-4 << 1e-4 << -1.0;
+        QTest::newRow("near -z, +x -y") << 1e-4 << -1e-4 << -1.0;
+        QTest::newRow("near -z, -x -y") << -1e-4 << -1e-4 << -1.0;
+
+        // Just below the equator, the fold meets the upper hemisphere.
+        QTest::newRow("below equator, +x") << 1.0 << 0.3 << -1e-4;
+        QTest::newRow("below equator, -x") << -1.0 << 0.3 << -1e-4;
+        QTest::newRow("below equator, +y") << 0.3 << 1.0 << -1e-4;
+        QTest::newRow("below equator, -y") << 0.3 << -1.0 << -1e-4;
+
+        // Zero components on the fold must pick a consistent side.
+        QTest::newRow("-z with zero x") << 0.0 << 0.6 << -0.8;
+        QTest::newRow("-z with zero y") << -0.6 << 0.0 << -0.8;
+    }
+
+    void lowerHemisphereWrap() {
+        QFETCH(double, x);
+        QFETCH(double, y);
+        QFETCH(double, z);
+        QVERIFY(normalError(Vector3D(x, y, z)) <= normalTolerance);
+    }
+
+    void normalRoundTrip() {
+        // Spread directions evenly over the sphere.
+        const int count = 100000;
+        const double goldenAngle = M_PI * (3.0 - sqrt(5.0));
+        double maximumError = 0.0;
+        for(int i = 0; i < count; i++) {
+            double z = 1.0 - 2.0 * (i + 0.5) / count;
+            double radius = sqrt(1.0 - z * z);
+            double angle = goldenAngle * i;
+            maximumError = qMax(maximumError, normalError(Vector3D(radius * cos(angle), radius * sin(angle), z)));
+        }
+        QVERIFY(maximumError <= normalTolerance);
+    }
+
+    void nullNormal() {
+        GLshort encoded[2] = { 1, 1 };
+        CompressedVertex::encodeNormal(Vector3D(), encoded);
+        QCOMPARE((int)encoded[0], 0);
+        QCOMPARE((int)encoded[1], 0);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestCompressedVertex)
+#include "tst_compressedvertex.moc"
@@ -0,0 +1,231 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "core/g3d_mesh.h"
+#include "core/g3d_normalbuilder.h"
+
+// Qt includes
+#include <QtTest>
+#include <QVector>
+
+// Standard includes
+#include <math.h>
+
+using namespace Glee3D;
+
+namespace {
+    /** Creates a bumpy grid of about the given number of triangles. */
+    Mesh *createGrid(int triangleCount) {
+        int quads = (int)ceil(sqrt(triangleCount / 2.0));
+        Mesh *mesh = new Mesh((quads + 1) * (quads + 1), quads * quads * 2);
+        for(int y = 0; y <= quads; y++) {
+            for(int x = 0; x <= quads; x++) {
+                double height = sin(x * 0.37) * cos(y * 0.23) + ((x * 7919 + y * 104729) % 13) * 0.01;
+                mesh->setVertex(y * (quads + 1) + x, Vector3D(x, height, y));
+            }
+        }
+
+        for(int y = 0; y < quads; y++) {
+            for(int x = 0; x < quads; x++) {
+                int p1 = y * (quads + 1) + x;
+                int p2 = p1 + quads + 1;
+                int p3 = p2 + 1;
+                int p4 = p1 + 1;
+                mesh->setTriangle((y * quads + x) * 2, Triangle(p1, p2, p3));
+                mesh->setTriangle((y * quads + x) * 2 + 1, Triangle(p1, p3, p4));
+            }
+        }
+        return mesh;
+    }
+
+    /** The normals CompiledMesh built before NormalBuilder existed, which
+      * scans all triangles for every vertex. */
+    QVector<Vector3D> previousNormals(Mesh *mesh) {
+        QVector<Triangle> triangles(mesh->triangleCount());
+        QVector<Vector3D> surfaceNormals(mesh->triangleCount());
+        for(int i = 0; i < mesh->triangleCount(); i++) {
+            Triangle t = triangles[i] = mesh->triangle(i);
+            surfaceNormals[i] = ((mesh->vertex(t._indices[1]) - mesh->vertex(t._indices[0]))
+                    .crossProduct(mesh->vertex(t._indices[2]) - mesh->vertex(t._indices[0]))).normalize();
+        }
+
+        QVector<Vector3D> vertexNormals(mesh->vertexCount());
+        for(int i = 0; i < mesh->vertexCount(); i++) {
+            Vector3D cumulatedJointNormal;
+            for(int j = 0; j < mesh->triangleCount(); j++) {
+                const Triangle& t = triangles[j];
+                if(t._indices[0] == i || t._indices[1] == i || t._indices[2] == i) {
+                    cumulatedJointNormal += surfaceNormals[j];
+                }
+            }
+            vertexNormals[i] = cumulatedJointNormal.normalize();
+        }
+        return vertexNormals;
+    }
+
+    /** @returns the largest distance between corresponding normals. */
+    double maximumDeviation(QVector<Vector3D> a, QVector<Vector3D> b) {
+        double deviation = 0.0;
+        for(int i = 0; i < a.size(); i++) {
+            deviation = qMax(deviation, (a[i] - b[i]).length());
+        }
+        return deviation;
+    }
+}
+
+class TestNormalBuilder : public QObject {
+    Q_OBJECT
+
+private slots:
+    void matchesPreviousNormals_data() {
+        QTest::addColumn<int>("triangleCount");
+        QTest::addColumn<int>("threadCount");
+        QTest::newRow("small, single thread") << 2000 << 1;
+        QTest::newRow("small, threaded") << 2000 << 4;
+        QTest::newRow("split over threads") << 20000 << 4;
+    }
+
+    void matchesPreviousNormals() {
+        QFETCH(int, triangleCount);
+        QFETCH(int, threadCount);
+        Mesh *mesh = createGrid(triangleCount);
+
+        NormalBuilder normalBuilder(NormalBuilder::Uniform);
+        normalBuilder.setThreadCount(threadCount);
+        QVector<Vector3D> normals = normalBuilder.build(mesh);
+
+        QCOMPARE(normals.size(), mesh->vertexCount());
+        QVERIFY(maximumDeviation(normals, previousNormals(mesh)) < 1e-12);
+        delete mesh;
+    }
+
+    void threadCountDoesNotChangeNormals_data() {
+        QTest::addColumn<int>("weighting");
+        QTest::newRow("uniform") << (int)NormalBuilder::Uniform;
+        QTest::newRow("area weighted") << (int)NormalBuilder::AreaWeighted;
+        QTest::newRow("angle weighted") << (int)NormalBuilder::AngleWeighted;
+    }
+
+    void threadCountDoesNotChangeNormals() {
+        QFETCH(int, weighting);
+        Mesh *mesh = createGrid(50000);
+
+        NormalBuilder normalBuilder((NormalBuilder::Weighting)weighting);
+        normalBuilder.setThreadCount(1);
+        QVector<Vector3D> singleThreaded = normalBuilder.build(mesh);
+        normalBuilder.setThreadCount(8);
+        QVector<Vector3D> multiThreaded = normalBuilder.build(mesh);
+
+        QVERIFY(maximumDeviation(singleThreaded, multiThreaded) == 0.0);
+        delete mesh;
+    }
+
+    void rangesMatchBuild_data() {
+        QTest::addColumn<int>("weighting");
+        QTest::addColumn<int>("rangeSize");
+        QTest::addColumn<int>("threadCount");
+        QTest::newRow("uniform, small ranges") << (int)NormalBuilder::Uniform << 1000 << 1;
+        QTest::newRow("area weighted, threaded") << (int)NormalBuilder::AreaWeighted << 20000 << 4;
+        QTest::newRow("angle weighted, uneven ranges") << (int)NormalBuilder::AngleWeighted << 777 << 4;
+        QTest::newRow("single range") << (int)NormalBuilder::Uniform << 100000 << 4;
+    }
+
+    void rangesMatchBuild() {
+        QFETCH(int, weighting);
+        QFETCH(int, rangeSize);
+        QFETCH(int, threadCount);
+        Mesh *mesh = createGrid(50000);
+        // Invalid triangles are skipped by both paths.
+        mesh->setTriangle(17, Triangle(0, 1, mesh->vertexCount()));
+
+        NormalBuilder normalBuilder((NormalBuilder::Weighting)weighting);
+        normalBuilder.setThreadCount(threadCount);
+        QVector<Vector3D> normals = normalBuilder.build(mesh);
+
+        QVERIFY(normalBuilder.prepareRanges(mesh, rangeSize));
+        QVector<Vector3D> rangeNormals(mesh->vertexCount());
+        for(int first = 0; first < mesh->vertexCount(); first += rangeSize) {
+            QVERIFY(normalBuilder.buildRange(first / rangeSize, rangeNormals.data() + first));
+        }
+        QVERIFY(!normalBuilder.buildRange((mesh->vertexCount() + rangeSize - 1) / rangeSize, rangeNormals.data()));
+
+        QVERIFY(maximumDeviation(normals, rangeNormals) == 0.0);
+        delete mesh;
+    }
+
+    void benchmarkNormalBuilder_data() {
+        QTest::addColumn<int>("triangleCount");
+        QTest::newRow("10k triangles") << 10000;
+        QTest::newRow("100k triangles") << 100000;
+        QTest::newRow("1M triangles") << 1000000;
+    }
+
+    void benchmarkNormalBuilder() {
+        QFETCH(int, triangleCount);
+        Mesh *mesh = createGrid(triangleCount);
+        NormalBuilder normalBuilder;
+        QBENCHMARK {
+            normalBuilder.build(mesh);
+        }
+        delete mesh;
+    }
+
+    void benchmarkRanges_data() {
+        QTest::addColumn<int>("triangleCount");
+        QTest::newRow("100k triangles") << 100000;
+        QTest::newRow("1M triangles") << 1000000;
+    }
+
+    void benchmarkRanges() {
+        QFETCH(int, triangleCount);
+        Mesh *mesh = createGrid(triangleCount);
+        NormalBuilder normalBuilder;
+        // The chunk size CompiledMesh streams with.
+        const int rangeSize = 65536;
+        QVector<Vector3D> normals(rangeSize);
+        QBENCHMARK {
+            normalBuilder.prepareRanges(mesh, rangeSize);
+            for(int first = 0; first < mesh->vertexCount(); first += rangeSize) {
+                normalBuilder.buildRange(first / rangeSize, normals.data());
+            }
+        }
+        delete mesh;
+    }
+
+    void benchmarkPreviousNormals_data() {
+        // At a million triangles, the previous path takes hours.
+        QTest::addColumn<int>("triangleCount");
+        QTest::newRow("10k triangles") << 10000;
+        QTest::newRow("100k triangles") << 100000;
+    }
+
+    void benchmarkPreviousNormals() {
+        QFETCH(int, triangleCount);
+        Mesh *mesh = createGrid(triangleCount);
+        QBENCHMARK_ONCE {
+            previousNormals(mesh);
+        }
+        delete mesh;
+    }
+};
+
+QTEST_GUILESS_MAIN(TestNormalBuilder)
+#include "tst_normalbuilder.moc"
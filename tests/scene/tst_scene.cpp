@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "core/g3d_scene.h"
+#include "core/g3d_scenesnapshot.h"
+
+// Qt includes
+#include <QtTest>
+
+using namespace Glee3D;
+
+namespace {
+    /** Entity counting how many instances have been deleted. */
+    class CountedEntity : public Entity {
+    public:
+        CountedEntity(int *deleted)
+            : Entity(),
+              _deleted(deleted) {
+        }
+
+        ~CountedEntity() {
+            (*_deleted)++;
+        }
+
+    private:
+        int *_deleted;
+    };
+}
+
+class TestScene : public QObject {
+    Q_OBJECT
+
+private slots:
+    void destroySubordinatedEntity() {
+        int deleted = 0;
+        Scene scene;
+        Entity *parent = new CountedEntity(&deleted);
+        Entity *child = new CountedEntity(&deleted);
+        parent->subordinate(child);
+        scene.insert(parent);
+
+        scene.destroy(child);
+        QVERIFY(parent->children().isEmpty());
+        QVERIFY(child->parent() == 0);
+
+        SceneSnapshot *snapshot = SceneSnapshot::capture(&scene, 0, 1);
+        QCOMPARE(snapshot->entities().size(), 1);
+        QVERIFY(snapshot->entities()[0]._entity == parent);
+        delete snapshot;
+
+        scene.deleteDestroyed();
+        QCOMPARE(deleted, 1);
+    }
+
+    void destroyParentEntity() {
+        int deleted = 0;
+        Scene scene;
+        Entity *root = new CountedEntity(&deleted);
+        Entity *parent = new CountedEntity(&deleted);
+        Entity *child = new CountedEntity(&deleted);
+        Entity *other = new CountedEntity(&deleted);
+        root->subordinate(parent);
+        parent->subordinate(child);
+        scene.insert(root);
+        scene.insert(other);
+
+        scene.destroy(parent);
+        QVERIFY(root->children().isEmpty());
+
+        SceneSnapshot *snapshot = SceneSnapshot::capture(&scene, 0, 1);
+        QCOMPARE(snapshot->entities().size(), 2);
+        delete snapshot;
+        scene.deleteDestroyed();
+        QCOMPARE(deleted, 2);
+
+        scene.destroy(root);
+        snapshot = SceneSnapshot::capture(&scene, 0, 2);
+        QCOMPARE(snapshot->entities().size(), 1);
+        QVERIFY(snapshot->entities()[0]._entity == other);
+        delete snapshot;
+        scene.deleteDestroyed();
+        QCOMPARE(deleted, 3);
+    }
+
+    void destroyedEntitiesWaitForSnapshots() {
+        int deleted = 0;
+        Scene scene;
+        Entity *parent = new CountedEntity(&deleted);
+        Entity *child = new CountedEntity(&deleted);
+        parent->subordinate(child);
+        scene.insert(parent);
+
+        SceneSnapshot *snapshot = SceneSnapshot::capture(&scene, 0, 1);
+        QCOMPARE(snapshot->entities().size(), 2);
+        scene.destroy(parent);
+        scene.deleteDestroyed();
+        QCOMPARE(deleted, 0);
+
+        SceneSnapshot *latest = SceneSnapshot::capture(&scene, 0, 2);
+        QCOMPARE(latest->entities().size(), 0);
+        delete latest;
+
+        delete snapshot;
+        scene.deleteDestroyed();
+        QCOMPARE(deleted, 2);
+    }
+};
+
+QTEST_GUILESS_MAIN(TestScene)
+#include "tst_scene.moc"
@@ -0,0 +1,395 @@
+///////////////////////////////////////////////////////////////////////////////
+//                                                                           //
+//    This file is part of glee3d.                                           //
+//    Copyright (C) 2012-2015 Jacob Dawid, jacob.dawid@omg-it.works          //
+//                                                                           //
+//    glee3d is free software: you can redistribute it and/or modify         //
+//    it under the terms of the GNU General Public License as published by   //
+//    the Free Software Foundation, either version 3 of the License, or      //
+//    (at your option) any later version.                                    //
+//                                                                           //
+//    glee3d is distributed in the hope that it will be useful,              //
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of         //
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the          //
+//    GNU General Public License for more details.                           //
+//                                                                           //
+//    You should have received a copy of the GNU General Public License      //
+//    along with glee3d.  If not, see <http://www.gnu.org/licenses/>.        //
+//                                                                           //
+///////////////////////////////////////////////////////////////////////////////
+
+// Own includes
+#include "core/g3d_terrain.h"
+#include "core/g3d_terrainchunk.h"
+#include "core/g3d_heightmap.h"
+
+// Qt includes
+#include <QtTest>
+#include <QImage>
+#include <QHash>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+#include <QTemporaryFile>
+
+// Standard includes
+#include <math.h>
+
+using namespace Glee3D;
+
+namespace {
+    /** Creates a hilly heightmap with heights in red and tile ids in green. */
+    QImage createHeightmap(int size) {
+        QImage image(size, size, QImage::Format_RGB32);
+        for(int y = 0; y < size; y++) {
+            for(int x = 0; x < size; x++) {
+                int height = 128 + (int)(60.0 * sin(x * 0.05) * cos(y * 0.07)) + (x * 7 + y * 13) % 5;
+                image.setPixel(x, y, qRgb(height, (x / 16 + y / 16) % 4, 0));
+            }
+        }
+        return image;
+    }
+
+    /** Positions and normals of terrain vertices. */
+    struct TerrainVertices {
+        QVector<Vector3D> _positions;
+        QVector<Vector3D> _normals;
+    };
+
+    /** The vertex buffers Terrain::generate() built before heights were kept
+      * in flat arrays, with every pixel and normal looked up by position.
+      * Every quad has four vertices of its own. */
+    TerrainVertices previousGenerate(const QImage& image) {
+        int width = image.width();
+        int height = image.height();
+        double scale = 1.0;
+        double tilingOffset = 1.0;
+
+        QHash<QPair<int, int>, double> terrain;
+        QHash<QPair<int, int>, int> tileIDs;
+        QHash<QPair<int, int>, Vector3D> normals;
+        for(int y = 0; y < height; y++) {
+            for(int x = 0; x < width; x++) {
+                int pixelValue = image.pixel(x, y);
+                terrain[QPair<int, int>(x, y)] = (double)qRed(pixelValue) - 128.0;
+                tileIDs[QPair<int, int>(x, y)] = qGreen(pixelValue);
+            }
+        }
+
+        QMap<QPair<int, int>, Vector3D> surfaceNormals;
+        for(int y = 0; y < height - 1; y++) {
+            for(int x = 0; x < width - 1; x++) {
+                Vector3D v1 = Vector3D(0,
+                                       terrain[QPair<int, int>(x, y + 1)] - terrain[QPair<int, int>(x, y)],
+                                       (double)(y + 1) * 10.0 - (double)y * 10.0);
+                Vector3D v2 = Vector3D((double)(x + 1) * 10.0 - (double)x * 10.0,
+                                       terrain[QPair<int, int>(x + 1, y)] - terrain[QPair<int, int>(x, y)],
+                                       0);
+                Vector3D normal = v1.crossProduct(v2);
+                normal.normalize();
+                surfaceNormals[QPair<int, int>(x, y)] = normal;
+            }
+        }
+
+        for(int y = 0; y < height; y++) {
+            for(int x = 0; x < width; x++) {
+                Vector3D vertexNormal;
+                if(x == 0 && y == 0) {
+                    vertexNormal = surfaceNormals[QPair<int, int>(0, 0)];
+                } else if(x > 0 && x < (width - 1) && y == 0) {
+                    vertexNormal = (surfaceNormals[QPair<int, int>(x - 1, 0)] + surfaceNormals[QPair<int, int>(x, 0)]) * 0.5;
+                } else if(x == (width - 1) && y == 0) {
+                    vertexNormal = surfaceNormals[QPair<int, int>(width - 2, 0)];
+                } else if(x == (width - 1) && y > 0 && y < (height - 1)) {
+                    vertexNormal = (surfaceNormals[QPair<int, int>(width - 2, y - 1)] + surfaceNormals[QPair<int, int>(width - 2, y)]) * 0.5;
+                } else if(x == (width - 1) && y == (height - 1)) {
+                    vertexNormal = surfaceNormals[QPair<int, int>(width - 2, height - 2)];
+                } else if(x > 0 && x < (width - 1) && y == (height - 1)) {
+                    vertexNormal = (surfaceNormals[QPair<int, int>(x - 1, height - 2)] + surfaceNormals[QPair<int, int>(x, height - 2)]) * 0.5;
+                } else if(x == 0 && y == (height - 1)) {
+                    vertexNormal = surfaceNormals[QPair<int, int>(0, height - 2)];
+                } else if(x == 0 && y > 0 && y < (height - 1)) {
+                    vertexNormal = (surfaceNormals[QPair<int, int>(0, y - 1)] + surfaceNormals[QPair<int, int>(0, y)]) * 0.5;
+                } else {
+                    vertexNormal = (surfaceNormals[QPair<int, int>(x - 1, y - 1)]
+                            + surfaceNormals[QPair<int, int>(x    , y - 1)]
+                            + surfaceNormals[QPair<int, int>(x    , y    )]
+                            + surfaceNormals[QPair<int, int>(x - 1, y    )]) * 0.25;
+                }
+                vertexNormal.normalize();
+                normals[QPair<int, int>(x, y)] = vertexNormal;
+            }
+        }
+
+        // Four vertices per quad, each with a position, texture coordinates
+        // and a normal.
+        TerrainVertices buffers;
+        buffers._positions.resize((width - 1) * (height - 1) * 4);
+        QVector<double> textureCoordinatesBuffer((width - 1) * (height - 1) * 4 * 2);
+        buffers._normals.resize((width - 1) * (height - 1) * 4);
+        int i = 0;
+        for(int y = 0; y < height - 1; y++) {
+            for(int x = 0; x < width - 1; x++) {
+                QPair<int, int> corners[4] = {
+                    QPair<int, int>(x, y),
+                    QPair<int, int>(x, y + 1),
+                    QPair<int, int>(x + 1, y + 1),
+                    QPair<int, int>(x + 1, y)
+                };
+                for(int c = 0; c < 4; c++) {
+                    buffers._positions[i] = Vector3D(corners[c].first * scale,
+                                                     terrain[corners[c]] * scale / 10.0,
+                                                     corners[c].second * scale);
+                    textureCoordinatesBuffer[i * 2 + 0] = c < 2 ? 0.0 : tilingOffset;
+                    textureCoordinatesBuffer[i * 2 + 1] = (c == 1 || c == 2) ? 1.0 : 0.0;
+                    buffers._normals[i] = normals[corners[c]];
+                    i++;
+                }
+            }
+        }
+        return buffers;
+    }
+
+    /** Vertices of a chunk, along with where it is placed. */
+    struct ChunkVertices {
+        int _x;
+        int _y;
+        int _width;
+        int _height;
+        QVector<Vertex> _vertices;
+    };
+
+    /** Builds the vertices of all chunks of the given heightmap, like a
+      * terrain does before uploading them. */
+    QVector<ChunkVertices> buildChunkVertices(const QImage& image) {
+        int width = image.width();
+        int height = image.height();
+        QVector<float> heights(width * height);
+        for(int y = 0; y < height; y++) {
+            for(int x = 0; x < width; x++) {
+                heights[y * width + x] = (float)qRed(image.pixel(x, y)) - 128.0f;
+            }
+        }
+
+        TerrainChunk::Heights chunkHeights;
+        chunkHeights._data = heights.constData();
+        chunkHeights._x = 0;
+        chunkHeights._y = 0;
+        chunkHeights._width = width;
+        chunkHeights._heightfieldWidth = width;
+        chunkHeights._heightfieldHeight = height;
+
+        QVector<ChunkVertices> chunks;
+        for(int y = 0; y < height - 1; y += TerrainChunk::Size) {
+            for(int x = 0; x < width - 1; x += TerrainChunk::Size) {
+                TerrainChunk chunk(x, y,
+                                   qMin((int)TerrainChunk::Size, width - 1 - x),
+                                   qMin((int)TerrainChunk::Size, height - 1 - y));
+                chunk.buildVertices(chunkHeights, 1.0, 0.1, 1.0);
+
+                ChunkVertices chunkVertices;
+                chunkVertices._x = chunk.x();
+                chunkVertices._y = chunk.y();
+                chunkVertices._width = chunk.width();
+                chunkVertices._height = chunk.height();
+                chunkVertices._vertices = chunk.vertices();
+                chunks.append(chunkVertices);
+            }
+        }
+        return chunks;
+    }
+
+    /** Lays out the vertices of the given chunks the way previousGenerate()
+      * does, with four vertices per quad. */
+    TerrainVertices perQuadCorner(const QVector<ChunkVertices>& chunks, int width, int height) {
+        QVector<Vertex> grid(width * height);
+        foreach(ChunkVertices chunk, chunks) {
+            const Vertex *vertex = chunk._vertices.constData();
+            for(int y = chunk._y; y <= chunk._y + chunk._height; y++) {
+                for(int x = chunk._x; x <= chunk._x + chunk._width; x++) {
+                    grid[y * width + x] = *vertex++;
+                }
+            }
+        }
+
+        TerrainVertices corners;
+        for(int y = 0; y < height - 1; y++) {
+            for(int x = 0; x < width - 1; x++) {
+                int indices[4] = {
+                    y * width + x,
+                    (y + 1) * width + x,
+                    (y + 1) * width + x + 1,
+                    y * width + x + 1
+                };
+                for(int c = 0; c < 4; c++) {
+                    const Vertex& vertex = grid[indices[c]];
+                    corners._positions.append(Vector3D(vertex._position[0], vertex._position[1], vertex._position[2]));
+                    corners._normals.append(Vector3D(vertex._normal[0], vertex._normal[1], vertex._normal[2]));
+                }
+            }
+        }
+        return corners;
+    }
+
+    /** @returns the largest distance between corresponding vectors. */
+    double maximumDeviation(QVector<Vector3D> a, QVector<Vector3D> b) {
+        double deviation = 0.0;
+        for(int i = 0; i < a.size(); i++) {
+            deviation = qMax(deviation, (a[i] - b[i]).length());
+        }
+        return deviation;
+    }
+}
+
+class TestTerrain : public QObject {
+    Q_OBJECT
+
+private slots:
+    void generateChecksSize() {
+        Terrain terrain;
+        QCOMPARE((int)terrain.generate(createHeightmap(1)), (int)Terrain::InvalidImageSize);
+        QCOMPARE((int)terrain.generate(createHeightmap(2)), (int)Terrain::Ok);
+        QCOMPARE((int)terrain.generate(createHeightmap(129)), (int)Terrain::Ok);
+        QCOMPARE(terrain.width(), 129);
+        QCOMPARE(terrain.height(), 129);
+    }
+
+    void heightmapMatchesImage() {
+        // Raw values of 256 times an image value give the same height as
+        // generate() decodes from the image.
+        int values[] = { 0, 1, 127, 128, 129, 255 };
+        QByteArray raw;
+        for(int i = 0; i < 6; i++) {
+            int value = values[i] * 256;
+            raw.append((char)(value & 0xff));
+            raw.append((char)(value >> 8));
+        }
+
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        file.write(raw);
+        file.close();
+
+        Heightmap heightmap;
+        QVERIFY(heightmap.map(file.fileName(), 3, 2));
+        float heights[6];
+        heightmap.read(0, 0, 3, 2, heights);
+        for(int i = 0; i < 6; i++) {
+            QCOMPARE(heights[i], (float)values[i] - 128.0f);
+        }
+    }
+
+    void streamMatchesGenerate_data() {
+        QTest::addColumn<int>("width");
+        QTest::addColumn<int>("height");
+        QTest::newRow("single chunk") << 40 << 33;
+        QTest::newRow("partial chunks") << 150 << 100;
+        QTest::newRow("whole chunks") << 257 << 129;
+    }
+
+    void streamMatchesGenerate() {
+        QFETCH(int, width);
+        QFETCH(int, height);
+        QImage image(width, height, QImage::Format_RGB32);
+        QImage square = createHeightmap(qMax(width, height));
+        QByteArray raw;
+        for(int y = 0; y < height; y++) {
+            for(int x = 0; x < width; x++) {
+                image.setPixel(x, y, square.pixel(x, y));
+                int value = qRed(square.pixel(x, y)) * 256;
+                raw.append((char)(value & 0xff));
+                raw.append((char)(value >> 8));
+            }
+        }
+
+        QTemporaryFile file;
+        QVERIFY(file.open());
+        file.write(raw);
+        file.close();
+
+        Terrain generated;
+        Terrain streamed;
+        QCOMPARE((int)generated.generate(image), (int)Terrain::Ok);
+        QCOMPARE((int)streamed.stream(file.fileName(), width, height), (int)Terrain::Ok);
+        QVERIFY(streamed.isStreamed());
+
+        QCOMPARE(streamed.chunkCount(), generated.chunkCount());
+        for(int i = 0; i < generated.chunkCount(); i++) {
+            TerrainChunk *expected = generated.chunk(i);
+            TerrainChunk *actual = streamed.chunk(i);
+            QCOMPARE(actual->x(), expected->x());
+            QCOMPARE(actual->y(), expected->y());
+            QCOMPARE(actual->width(), expected->width());
+            QCOMPARE(actual->height(), expected->height());
+            QVERIFY((actual->boundingBox().center() - expected->boundingBox().center()).length() < 1e-9);
+            QVERIFY((actual->boundingBox().halfExtents() - expected->boundingBox().halfExtents()).length() < 1e-9);
+            for(int level = 0; level <= expected->maximumLevelOfDetail(); level++) {
+                QCOMPARE(actual->error(level), expected->error(level));
+            }
+        }
+    }
+
+    void chunkVerticesMatchPreviousGenerate_data() {
+        QTest::addColumn<int>("size");
+        QTest::newRow("single chunk") << 33;
+        QTest::newRow("partial chunks") << 100;
+        QTest::newRow("whole chunks") << 257;
+    }
+
+    void chunkVerticesMatchPreviousGenerate() {
+        // Chunks store single precision vertices, the previous path doubles.
+        QFETCH(int, size);
+        QImage image = createHeightmap(size);
+        TerrainVertices previous = previousGenerate(image);
+        TerrainVertices chunks = perQuadCorner(buildChunkVertices(image), size, size);
+
+        QCOMPARE(chunks._positions.size(), previous._positions.size());
+        QVERIFY(maximumDeviation(chunks._positions, previous._positions) < 1e-5);
+        QVERIFY(maximumDeviation(chunks._normals, previous._normals) < 1e-5);
+    }
+
+    void benchmarkGenerate_data() {
+        QTest::addColumn<int>("size");
+        QTest::newRow("257x257") << 257;
+        QTest::newRow("1025x1025") << 1025;
+        QTest::newRow("2049x2049") << 2049;
+    }
+
+    void benchmarkGenerate() {
+        QFETCH(int, size);
+        QImage image = createHeightmap(size);
+        Terrain terrain;
+        QBENCHMARK {
+            terrain.generate(image);
+        }
+    }
+
+    void benchmarkChunkVertices_data() {
+        benchmarkGenerate_data();
+    }
+
+    void benchmarkChunkVertices() {
+        // Vertices are built when chunks are first drawn. Together with
+        // generate(), this is the work the previous path did up front.
+        QFETCH(int, size);
+        QImage image = createHeightmap(size);
+        QBENCHMARK {
+            buildChunkVertices(image);
+        }
+    }
+
+    void benchmarkPreviousGenerate_data() {
+        benchmarkGenerate_data();
+    }
+
+    void benchmarkPreviousGenerate() {
+        QFETCH(int, size);
+        QImage image = createHeightmap(size);
+        QBENCHMARK_ONCE {
+            previousGenerate(image);
+        }
+    }
+};
+
+QTEST_GUILESS_MAIN(TestTerrain)
+#include "tst_terrain.moc"